@@ -7,6 +7,17 @@
 
 using namespace std;
 
+namespace transport_catalogue::geo {
+
+// оператор объявлен в пространстве имён `Coordinates`, чтобы его нашёл ADL
+// внутри шаблонов `AssertEqual`
+ostream &operator<<(ostream &os, const Coordinates &c) {
+  os << '(' << c.lat << ", " << c.lng << ')';
+  return os;
+}
+
+}  // namespace transport_catalogue::geo
+
 namespace transport_catalogue::geo::tests {
 
 void TestCoordinates() {
@@ -27,12 +38,6 @@ void TestCoordinates() {
 
 }  // namespace transport_catalogue::geo::tests
 
-using transport_catalogue::geo::Coordinates;
-ostream &operator<<(ostream &os, const Coordinates &c) {
-  os << '(' << c.lat << ", " << c.lng << ')';
-  return os;
-}
-
 void TestGeo(TestRunner &tr) {
   using namespace transport_catalogue::geo::tests;
 
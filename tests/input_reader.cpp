@@ -215,11 +215,6 @@ void TestReadDB() {
 
 }  // namespace transport_catalogue::input_reader::from_char_stream::tests
 
-using transport_catalogue::input_reader::AddStopCmd;
-ostream &operator<<(ostream &os, const AddStopCmd::Distance &dis) {
-  return os << '{' << dis.first << ", " << dis.second << '}';
-}
-
 void TestInputReader(TestRunner &tr) {
   {
     using namespace transport_catalogue::input_reader::from_char_stream::tests;
@@ -97,6 +97,24 @@ void TestBusParser() {
     ASSERT_EQUAL(base_requests.size(), 1u);
     ASSERT_EQUAL(get<AddBusCmd>(base_requests[0]).route_type,
                  RouteType::LINEAR);
+    ASSERT(get<AddBusCmd>(base_requests[0]).trips.empty());
+  }
+  {
+    string stop_json =
+        R"({
+           "type": "Bus",
+           "name": "16",
+           "stops": ["A", "B"],
+           "is_roundtrip": false,
+           "trips": [[480, 485, 490], [540.5, 545, 550]]
+         })"s;
+    istringstream sin{R"({"base_requests":[)"s + stop_json +
+                      R"(],"stat_requests":[]})"s};
+    BufferingRequestReader reader{sin};
+    const auto &cmd = get<AddBusCmd>(reader.GetBaseRequests()[0]);
+    ASSERT_EQUAL(cmd.trips.size(), 2u);
+    ASSERT_EQUAL(cmd.trips[0], (vector<double>{480, 485, 490}));
+    ASSERT_EQUAL(cmd.trips[1], (vector<double>{540.5, 545, 550}));
   }
 }
 
@@ -136,6 +154,66 @@ void TestBusStatRequestParser() {
   ASSERT_EQUAL(req.name, "14"s);
 }
 
+void TestRouteRequestParser() {
+  istringstream sin{
+      R"({"base_requests":[],"stat_requests":[)"
+      R"({"id":1,"type":"Route","from":"A","to":"B"},)"
+      R"({"id":2,"type":"Route","from":"A","to":"B","departure_time":475.5},)"
+      R"({"id":3,"type":"Route","from":"A","to":"B","bus_velocity":45,)"
+      R"("bus_wait_time":3.5})"
+      R"(]})"s};
+  BufferingRequestReader reader{sin};
+  const auto &stat_requests = reader.GetStatRequests();
+  ASSERT_EQUAL(stat_requests.size(), 3u);
+  const auto &req = get<RouteRequest>(stat_requests[0]);
+  ASSERT_EQUAL(req.id, 1);
+  ASSERT_EQUAL(req.from, "A"s);
+  ASSERT_EQUAL(req.to, "B"s);
+  ASSERT(!req.departure_time);
+  const auto &timed_req = get<RouteRequest>(stat_requests[1]);
+  ASSERT(timed_req.departure_time);
+  ASSERT_EQUAL(*timed_req.departure_time, 475.5);
+  ASSERT(!req.profile.bus_velocity);
+  ASSERT(!req.profile.bus_wait_time);
+  const auto &profile_req = get<RouteRequest>(stat_requests[2]);
+  ASSERT(profile_req.profile.bus_velocity);
+  ASSERT_EQUAL(*profile_req.profile.bus_velocity, 45.0);
+  ASSERT(profile_req.profile.bus_wait_time);
+  ASSERT_EQUAL(*profile_req.profile.bus_wait_time, 3.5);
+}
+
+void TestIsochroneRequestParser() {
+  istringstream sin{
+      R"({"base_requests":[],"stat_requests":[)"
+      R"({"id":1,"type":"Isochrone","from":"A","max_time":12.5})"
+      R"(]})"s};
+  BufferingRequestReader reader{sin};
+  const auto &stat_requests = reader.GetStatRequests();
+  ASSERT_EQUAL(stat_requests.size(), 1u);
+  const auto &req = get<IsochroneRequest>(stat_requests[0]);
+  ASSERT_EQUAL(req.id, 1);
+  ASSERT_EQUAL(req.from, "A"s);
+  ASSERT_EQUAL(req.max_time, 12.5);
+}
+
+void TestRouteMatrixRequestParser() {
+  istringstream sin{
+      R"({"base_requests":[],"stat_requests":[)"
+      R"({"id":1,"type":"RouteMatrix","from":["A","B"],"to":["C"]},)"
+      R"({"id":2,"type":"RouteMatrix","from":[],"to":["C"],"with_steps":true})"
+      R"(]})"s};
+  BufferingRequestReader reader{sin};
+  const auto &stat_requests = reader.GetStatRequests();
+  ASSERT_EQUAL(stat_requests.size(), 2u);
+  ASSERT(holds_alternative<RouteMatrixRequest>(stat_requests[0]));
+  const auto &req = get<RouteMatrixRequest>(stat_requests[0]);
+  ASSERT_EQUAL(req.id, 1);
+  ASSERT_EQUAL(req.from, (vector<string>{"A"s, "B"s}));
+  ASSERT_EQUAL(req.to, (vector<string>{"C"s}));
+  ASSERT(!req.with_steps);
+  ASSERT(get<RouteMatrixRequest>(stat_requests[1]).with_steps);
+}
+
 void TestRenderSettings() {
   {
     string render_settings_json =
@@ -191,6 +269,106 @@ void TestRenderSettings() {
   }
 }
 
+void TestRouterSettingsParser() {
+  {
+    istringstream sin{
+        R"({"base_requests":[],"stat_requests":[],)"
+        R"("routing_settings":{"bus_velocity":40,"bus_wait_time":6}})"s};
+    BufferingRequestReader reader{sin};
+    ASSERT(reader.GetRouterSettings());
+    const auto &rs = *reader.GetRouterSettings();
+    ASSERT_SOFT_EQUAL(rs.bus_velocity, 40.0);
+    ASSERT_SOFT_EQUAL(rs.bus_wait_time, 6.0);
+    ASSERT_EQUAL(rs.engine, router::RouterEngine::FLOYD_WARSHALL);
+    ASSERT(!rs.use_reachability_index);
+  }
+  {
+    istringstream sin{
+        R"({"base_requests":[],"stat_requests":[],"routing_settings":)"
+        R"({"bus_velocity":40,"bus_wait_time":6,"router_engine":"alt",)"
+        R"("landmark_count":3}})"s};
+    BufferingRequestReader reader{sin};
+    ASSERT_EQUAL(reader.GetRouterSettings()->engine, router::RouterEngine::ALT);
+    ASSERT_EQUAL(reader.GetRouterSettings()->landmark_count, 3u);
+  }
+  {
+    istringstream sin{
+        R"({"base_requests":[],"stat_requests":[],"routing_settings":)"
+        R"({"bus_velocity":40,"bus_wait_time":6,"router_threads":0,)"
+        R"("tree_cache_size":16,"cache_file":"router.bin",)"
+        R"("profile_cache_size":2,"route_cache_size":64,)"
+        R"("use_reachability_index":true}})"s};
+    BufferingRequestReader reader{sin};
+    ASSERT_EQUAL(reader.GetRouterSettings()->router_threads, 0u);
+    ASSERT_EQUAL(reader.GetRouterSettings()->tree_cache_size, 16u);
+    ASSERT_EQUAL(reader.GetRouterSettings()->profile_cache_size, 2u);
+    ASSERT_EQUAL(reader.GetRouterSettings()->route_cache_size, 64u);
+    ASSERT(reader.GetRouterSettings()->use_reachability_index);
+    ASSERT_EQUAL(reader.GetRouterSettings()->cache_file, "router.bin"s);
+    ASSERT_EQUAL(reader.GetRouterSettings()->graph_model,
+                 router::GraphModel::ALL_PAIRS);
+    ASSERT(!reader.GetRouterSettings()->prune_bus_edges);
+    ASSERT(!reader.GetRouterSettings()->reduce_to_transfer_stops);
+    ASSERT(!reader.GetRouterSettings()->reorder_vertices);
+  }
+  {
+    istringstream sin{
+        R"({"base_requests":[],"stat_requests":[],"routing_settings":)"
+        R"({"bus_velocity":40,"bus_wait_time":6,"prune_bus_edges":true,)"
+        R"("reduce_to_transfer_stops":true,"reorder_vertices":true}})"s};
+    BufferingRequestReader reader{sin};
+    ASSERT(reader.GetRouterSettings()->prune_bus_edges);
+    ASSERT(reader.GetRouterSettings()->reduce_to_transfer_stops);
+    ASSERT(reader.GetRouterSettings()->reorder_vertices);
+  }
+  {
+    istringstream sin{
+        R"({"base_requests":[],"stat_requests":[],"routing_settings":)"
+        R"({"bus_velocity":40,"bus_wait_time":6,"graph_model":"ride_chain"}})"s};
+    BufferingRequestReader reader{sin};
+    ASSERT_EQUAL(reader.GetRouterSettings()->graph_model,
+                 router::GraphModel::RIDE_CHAIN);
+  }
+  {
+    istringstream sin{
+        R"({"base_requests":[],"stat_requests":[],"routing_settings":)"
+        R"({"bus_velocity":40,"bus_wait_time":6,"graph_model":"wait_free"}})"s};
+    BufferingRequestReader reader{sin};
+    ASSERT_EQUAL(reader.GetRouterSettings()->graph_model,
+                 router::GraphModel::WAIT_FREE);
+  }
+  {
+    istringstream sin{
+        R"({"base_requests":[],"stat_requests":[],"routing_settings":)"
+        R"({"bus_velocity":40,"bus_wait_time":6,"graph_model":"magic"}})"s};
+    ASSERT_THROWS(BufferingRequestReader{sin}, invalid_argument);
+  }
+  {
+    istringstream sin{
+        R"({"base_requests":[],"stat_requests":[],"routing_settings":)"
+        R"({"bus_velocity":40,"bus_wait_time":6,"router_engine":"dijkstra"}})"s};
+    BufferingRequestReader reader{sin};
+    ASSERT_EQUAL(reader.GetRouterSettings()->engine,
+                 router::RouterEngine::DIJKSTRA);
+  }
+  {
+    istringstream sin{
+        R"({"base_requests":[],"stat_requests":[],"routing_settings":)"
+        R"({"bus_velocity":40,"bus_wait_time":6,"router_engine":"magic"}})"s};
+    ASSERT_THROWS(BufferingRequestReader{sin}, invalid_argument);
+  }
+  // отрицательный размер не должен превращаться в огромный `size_t`
+  for (const string &key :
+       {"landmark_count"s, "router_threads"s, "tree_cache_size"s,
+        "profile_cache_size"s, "route_cache_size"s}) {
+    istringstream sin{
+        R"({"base_requests":[],"stat_requests":[],"routing_settings":)"
+        R"({"bus_velocity":40,"bus_wait_time":6,")"s +
+        key + R"(":-1}})"s};
+    ASSERT_THROWS_HINT(BufferingRequestReader{sin}, invalid_argument, key);
+  }
+}
+
 void TestBusStatResponsePrinter() {
   ostringstream sout;
 
@@ -229,6 +407,78 @@ void TestEmptyResponsePrinter() {
       R"([{"error_message":"not found","request_id":12345},{"error_message":"not found","request_id":12346}])"s);
 }
 
+void TestRouteMatrixResponsePrinter() {
+  using namespace transport_catalogue::router;
+  ostringstream sout;
+
+  {
+    ResponsePrinter printer{sout};
+    RouteMatrix times_only{2, 1, {60.0, nullopt}, {}};
+    printer.PrintResponse(1, times_only);
+    RouteMatrix with_steps{
+        1,
+        2,
+        {0.0, 420.0},
+        {{}, {WaitAction{"A"sv, 120}, BusAction{"1"sv, 2, 300}}}};
+    printer.PrintResponse(2, with_steps);
+  }
+  ASSERT_EQUAL(
+      sout.str(),
+      R"([{"request_id":1,"times":[[1],[null]]},)"
+      R"({"items":[[[],[{"stop_name":"A","time":2,"type":"Wait"},)"
+      R"({"bus":"1","span_count":2,"time":5,"type":"Bus"}]]],)"
+      R"("request_id":2,"times":[[0,7]]}])"s);
+}
+
+void TestIsochroneResponsePrinter() {
+  using namespace transport_catalogue::router;
+  ostringstream sout;
+  {
+    ResponsePrinter printer{sout};
+    printer.PrintResponse(1, Isochrone{{{"A"sv, 0}, {"B"sv, 270}}});
+    printer.PrintResponse(2, Isochrone{});
+  }
+  ASSERT_EQUAL(sout.str(),
+               R"([{"request_id":1,"stops":[{"stop_name":"A","time":0},)"
+               R"({"stop_name":"B","time":4.5}]},)"
+               R"({"request_id":2,"stops":[]}])"s);
+}
+
+/**
+ * Ответ на запрос маршрута, сохранённый в строку при первой печати,
+ * печатается так же, как обычный.
+ */
+void TestRouteResponsePrinter() {
+  using namespace transport_catalogue::router;
+  const RouteResult route{420.0,
+                          {WaitAction{"A"sv, 120}, BusAction{"1"sv, 2, 300}}};
+  ostringstream expected;
+  {
+    ResponsePrinter printer{expected};
+    printer.PrintResponse(1, route);
+    printer.PrintResponse(2, route);
+  }
+  ASSERT_EQUAL(
+      expected.str(),
+      R"([{"items":[{"stop_name":"A","time":2,"type":"Wait"},)"
+      R"({"bus":"1","span_count":2,"time":5,"type":"Bus"}],)"
+      R"("request_id":1,"total_time":7},)"
+      R"({"items":[{"stop_name":"A","time":2,"type":"Wait"},)"
+      R"({"bus":"1","span_count":2,"time":5,"type":"Bus"}],)"
+      R"("request_id":2,"total_time":7}])"s);
+
+  ostringstream actual;
+  SerializedRoute serialized;
+  {
+    ResponsePrinter printer{actual};
+    printer.PrintRouteResponse(1, route, serialized);
+    ASSERT(!serialized.items.empty());
+    // второй раз печатается сохранённая строка, а не `route`
+    printer.PrintRouteResponse(2, RouteResult{}, serialized);
+  }
+  ASSERT_EQUAL(actual.str(), expected.str());
+}
+
 }  // namespace transport_catalogue::json_reader::tests
 
 void TestJSONReader(TestRunner &tr) {
@@ -238,9 +488,16 @@ void TestJSONReader(TestRunner &tr) {
   RUN_TEST(tr, TestBusParser);
   RUN_TEST(tr, TestStopStatRequestParser);
   RUN_TEST(tr, TestBusStatRequestParser);
+  RUN_TEST(tr, TestRouteRequestParser);
+  RUN_TEST(tr, TestRouteMatrixRequestParser);
+  RUN_TEST(tr, TestIsochroneRequestParser);
   RUN_TEST(tr, TestRenderSettings);
+  RUN_TEST(tr, TestRouterSettingsParser);
 
   RUN_TEST(tr, TestBusStatResponsePrinter);
   RUN_TEST(tr, TestStopStatResponsePrinter);
   RUN_TEST(tr, TestEmptyResponsePrinter);
+  RUN_TEST(tr, TestRouteMatrixResponsePrinter);
+  RUN_TEST(tr, TestRouteResponsePrinter);
+  RUN_TEST(tr, TestIsochroneResponsePrinter);
 }
@@ -5,11 +5,13 @@
 #include "json_reader.h"
 #include "map_renderer.h"
 #include "request_handler.h"
+#include "router.h"
 #include "shapes.h"
 #include "stat_reader.h"
 #include "svg.h"
 #include "test_framework.h"
 #include "transport_catalogue.h"
+#include "transport_router.h"
 
 int main() {
   TestRunner tr;
@@ -25,4 +27,6 @@ int main() {
   TestRequestHandler(tr);
   TestMapRenderer(tr);
   TestJsonBuilder(tr);
+  TestRouter(tr);
+  TestTransportRouter(tr);
 }
@@ -127,6 +127,65 @@ void TestProcessRequests() {
   }
 }
 
+/**
+ * Повторные запросы маршрута отвечаются из кэша, а ответы те же, что без
+ * кэша.
+ */
+void TestRouteCache() {
+  vector<BaseRequest> base_requests{
+      AddBusCmd{"114"s, RouteType::LINEAR, {"A"s, "B"s}},
+      AddStopCmd{"A"s, {43.587795, 39.716901}, {{"B"s, 850}}},
+      AddStopCmd{"B"s, {43.581969, 39.719848}, {{"A"s, 1000}}}};
+  RouteRequest fast_request{{4}, "A"s, "B"s, nullopt, {}};
+  fast_request.profile.bus_velocity = 60;
+  vector<StatRequest> stat_requests{
+      RouteRequest{{1}, "A"s, "B"s, nullopt, {}},
+      RouteRequest{{2}, "A"s, "B"s, nullopt, {}},
+      RouteRequest{{3}, "B"s, "A"s, nullopt, {}},
+      fast_request,
+      RouteRequest{{5}, "A"s, "Z"s, nullopt, {}},
+      RouteRequest{{6}, "A"s, "Z"s, nullopt, {}}};
+  RouterSettings router_settings;
+  router_settings.bus_velocity = 30;
+  router_settings.bus_wait_time = 2;
+
+  auto process = [&](size_t route_cache_size, TestResponsePrinter &printer) {
+    router_settings.route_cache_size = route_cache_size;
+    const TestRequestReader requests{vector(base_requests),
+                                     vector(stat_requests), nullopt,
+                                     optional(router_settings)};
+    TransportCatalogue transport_catalogue;
+    BufferingRequestHandler request_handler{transport_catalogue, requests};
+    request_handler.ProcessRequests(printer);
+    return request_handler.GetRouteCacheStats();
+  };
+  TestResponsePrinter expected;
+  const auto no_cache_stats = process(0, expected);
+  ASSERT_EQUAL(no_cache_stats.hits + no_cache_stats.misses, 0u);
+  TestResponsePrinter actual;
+  const auto stats = process(2, actual);
+  ASSERT_EQUAL(stats.hits, 2u);
+  ASSERT_EQUAL(stats.misses, 4u);
+  ASSERT_EQUAL(stats.evictions, 2u);
+  ASSERT_EQUAL(stats.size, 2u);
+
+  ASSERT_EQUAL(actual.collected_responses.size(), stat_requests.size());
+  for (size_t i = 0; i < stat_requests.size(); ++i) {
+    const auto &[expected_id, expected_response] =
+        expected.collected_responses[i];
+    const auto &[actual_id, actual_response] = actual.collected_responses[i];
+    ASSERT_EQUAL(actual_id, expected_id);
+    ASSERT_EQUAL(actual_response.index(), expected_response.index());
+    if (holds_alternative<router::RouteResult>(expected_response)) {
+      ASSERT_SOFT_EQUAL(get<router::RouteResult>(actual_response).time,
+                        get<router::RouteResult>(expected_response).time);
+    }
+  }
+  ASSERT(holds_alternative<router::RouteResult>(
+      actual.collected_responses[1].second));
+  ASSERT(holds_alternative<monostate>(actual.collected_responses[5].second));
+}
+
 using map_renderer::MapRenderer;
 using map_renderer::RenderSettings;
 struct TestMapRenderer final : public MapRenderer {
@@ -165,5 +224,6 @@ void TestRequestHandler(TestRunner &tr) {
   using namespace transport_catalogue::request_handler::tests;
 
   RUN_TEST(tr, TestProcessRequests);
+  RUN_TEST(tr, TestRouteCache);
   RUN_TEST(tr, TestRenderMap);
 }
@@ -0,0 +1,743 @@
+#include "../transport-catalogue/router.h"
+
+#include <cmath>
+#include <cstdint>
+#include <limits>
+#include <optional>
+#include <random>
+#include <stdexcept>
+#include <string>
+
+#include "../transport-catalogue/astar_router.h"
+#include "../transport-catalogue/bidirectional_dijkstra_router.h"
+#include "../transport-catalogue/contraction_hierarchy_router.h"
+#include "../transport-catalogue/dijkstra_router.h"
+#include "../transport-catalogue/graph.h"
+#include "../transport-catalogue/hub_label_router.h"
+#include "../transport-catalogue/min_plus.h"
+#include "../transport-catalogue/reachability_index.h"
+#include "router.h"
+#include "test_framework.h"
+
+using namespace std;
+
+namespace graph::tests {
+
+using Graph = DirectedWeightedGraph<double>;
+
+/**
+ * Случайный граф с целыми весами: суммы целых чисел в `double` считаются
+ * точно, поэтому веса маршрутов разных движков можно сравнивать на равенство.
+ */
+Graph MakeRandomGraph(size_t vertex_count, size_t edge_count, unsigned seed) {
+  mt19937 gen{seed};
+  uniform_int_distribution<size_t> vertex_dist{0, vertex_count - 1};
+  uniform_int_distribution<int> weight_dist{0, 20};
+  Graph graph{vertex_count};
+  for (size_t i = 0; i < edge_count; ++i) {
+    graph.AddEdge({vertex_dist(gen), vertex_dist(gen),
+                   static_cast<double>(weight_dist(gen))});
+  }
+  return graph;
+}
+
+/**
+ * Проверяет, что `edges` - это путь из `from` в `to` с весом `weight`.
+ */
+template <typename AnyGraph>
+void AssertIsPath(const AnyGraph &graph, VertexId from, VertexId to,
+                  double weight, const vector<EdgeId> &edges,
+                  const string &hint) {
+  VertexId vertex = from;
+  double path_weight = 0;
+  for (EdgeId edge_id : edges) {
+    const auto &edge = graph.GetEdge(edge_id);
+    ASSERT_EQUAL_HINT(edge.from, vertex, hint);
+    path_weight += edge.weight;
+    vertex = edge.to;
+  }
+  ASSERT_EQUAL_HINT(vertex, to, hint);
+  ASSERT_EQUAL_HINT(path_weight, weight, hint);
+}
+
+/**
+ * Сравнивает ответы движка `router` с ответами эталонного движка на
+ * Флойде-Уоршелле для всех пар вершин.
+ */
+template <typename AnyGraph>
+void AssertSameRoutes(const AnyGraph &graph,
+                      const AbstractRouter<double> &router,
+                      const string &hint) {
+  const Router<double, AnyGraph> expected_router{graph};
+  for (VertexId from = 0; from < graph.GetVertexCount(); ++from) {
+    for (VertexId to = 0; to < graph.GetVertexCount(); ++to) {
+      const string pair_hint =
+          hint + " " + to_string(from) + "->" + to_string(to);
+      auto expected = expected_router.BuildRoute(from, to);
+      auto actual = router.BuildRoute(from, to);
+      ASSERT_EQUAL_HINT(actual.has_value(), expected.has_value(), pair_hint);
+      if (expected) {
+        ASSERT_EQUAL_HINT(actual->weight, expected->weight, pair_hint);
+        AssertIsPath(graph, from, to, actual->weight, actual->edges,
+                     pair_hint);
+      }
+    }
+  }
+}
+
+void TestFloydWarshallRouter() {
+  Graph graph{4};
+  graph.AddEdge({0, 1, 5});
+  graph.AddEdge({1, 2, 5});
+  graph.AddEdge({0, 2, 12});
+  graph.AddEdge({2, 0, 1});
+
+  Router<double> router{graph};
+  auto route = router.BuildRoute(0, 2);
+  ASSERT(route);
+  ASSERT_EQUAL(route->weight, 10.0);
+  ASSERT_EQUAL(route->edges, (vector<EdgeId>{0, 1}));
+
+  route = router.BuildRoute(1, 1);
+  ASSERT(route);
+  ASSERT_EQUAL(route->weight, 0.0);
+  ASSERT(route->edges.empty());
+
+  ASSERT(!router.BuildRoute(0, 3));
+  ASSERT(!router.BuildRoute(3, 0));
+  ASSERT_THROWS(router.BuildRoute(0, 4), out_of_range);
+
+  // у целых весов нет бесконечности, отсутствие маршрута обозначается
+  // наибольшим значением типа
+  DirectedWeightedGraph<int> int_graph{3};
+  int_graph.AddEdge({0, 1, 2});
+  int_graph.AddEdge({1, 2, 3});
+  Router<int> int_router{int_graph};
+  auto int_route = int_router.BuildRoute(0, 2);
+  ASSERT(int_route);
+  ASSERT_EQUAL(int_route->weight, 5);
+  ASSERT_EQUAL(int_route->edges, (vector<EdgeId>{0, 1}));
+  ASSERT(!int_router.BuildRoute(2, 0));
+}
+
+/**
+ * Блочный и многопоточный Флойд-Уоршелл должен давать те же маршруты до
+ * последнего ребра, что и однопоточный, в том числе среди равноценных путей.
+ */
+void TestParallelFloydWarshallRouter() {
+  for (unsigned seed = 1; seed <= 3; ++seed) {
+    // вершин больше, чем в нескольких блоках, и число не кратно блоку
+    const Graph graph = MakeRandomGraph(83, 300, seed);
+    const Router<double> expected_router{graph};
+    for (size_t thread_count : {0, 2, 3, 7}) {
+      const Router<double> router{graph, thread_count};
+      for (VertexId from = 0; from < graph.GetVertexCount(); ++from) {
+        for (VertexId to = 0; to < graph.GetVertexCount(); ++to) {
+          const string hint = "seed " + to_string(seed) + " threads " +
+                              to_string(thread_count) + " " + to_string(from) +
+                              "->" + to_string(to);
+          auto expected = expected_router.BuildRoute(from, to);
+          auto actual = router.BuildRoute(from, to);
+          ASSERT_EQUAL_HINT(actual.has_value(), expected.has_value(), hint);
+          if (expected) {
+            ASSERT_EQUAL_HINT(actual->weight, expected->weight, hint);
+            ASSERT_EQUAL_HINT(actual->edges, expected->edges, hint);
+          }
+        }
+      }
+    }
+  }
+}
+
+/**
+ * Граф с теми же вершинами, что и `graph`: часть рёбер пропадает, часть
+ * дорожает или дешевеет, и добавляется несколько новых.
+ */
+Graph MakeChangedGraph(const Graph &graph, unsigned seed) {
+  mt19937 gen{seed};
+  uniform_int_distribution<int> change_dist{0, 3};
+  uniform_int_distribution<int> weight_dist{0, 20};
+  uniform_int_distribution<size_t> vertex_dist{0,
+                                               graph.GetVertexCount() - 1};
+  Graph result{graph.GetVertexCount()};
+  for (EdgeId id = 0; id < graph.GetEdgeCount(); ++id) {
+    auto edge = graph.GetEdge(id);
+    const int change = change_dist(gen);
+    if (change == 0) {
+      continue;
+    }
+    if (change == 1) {
+      edge.weight = static_cast<double>(weight_dist(gen));
+    }
+    result.AddEdge(edge);
+  }
+  for (size_t i = 0; i < 10; ++i) {
+    result.AddEdge({vertex_dist(gen), vertex_dist(gen),
+                    static_cast<double>(weight_dist(gen))});
+  }
+  return result;
+}
+
+void TestFloydWarshallUpdate() {
+  for (unsigned seed = 1; seed <= 5; ++seed) {
+    Graph graph = MakeRandomGraph(30, 80, seed);
+    Router<double> router{graph};
+    for (unsigned step = 0; step < 3; ++step) {
+      const Graph old_graph = graph;
+      graph = MakeChangedGraph(old_graph, seed * 10 + step);
+      router.Update(old_graph);
+      AssertSameRoutes(graph, router,
+                       "seed " + to_string(seed) + " step " + to_string(step));
+    }
+  }
+  {
+    // немного изменений - таблица обновляется, много - считается заново
+    auto scale_weights = [](const Graph &graph, double factor) {
+      Graph result{graph.GetVertexCount()};
+      for (EdgeId id = 0; id < graph.GetEdgeCount(); ++id) {
+        auto edge = graph.GetEdge(id);
+        edge.weight *= factor;
+        result.AddEdge(edge);
+      }
+      return result;
+    };
+    Graph graph = MakeRandomGraph(40, 120, 7);
+    Router<double> router{graph};
+
+    Graph old_graph = graph;
+    graph = Graph{old_graph.GetVertexCount()};
+    for (EdgeId id = 0; id < old_graph.GetEdgeCount(); ++id) {
+      auto edge = old_graph.GetEdge(id);
+      if (id == 0) {
+        edge.weight /= 2;
+      }
+      graph.AddEdge(edge);
+    }
+    ASSERT(router.Update(old_graph));
+    AssertSameRoutes(graph, router, "one cheaper edge");
+
+    old_graph = graph;
+    graph = scale_weights(old_graph, 0.5);
+    ASSERT(!router.Update(old_graph, 4));
+    AssertSameRoutes(graph, router, "all edges cheaper");
+
+    old_graph = graph;
+    graph = scale_weights(old_graph, 3);
+    ASSERT(!router.Update(old_graph, 4));
+    AssertSameRoutes(graph, router, "all edges dearer");
+  }
+  {
+    // таблица чужого движка копируется, а не меняется
+    Graph graph = MakeRandomGraph(20, 50, 1);
+    const Router<double> source_router{graph};
+    const vector<double> source_weights(source_router.GetWeights(),
+                                        source_router.GetWeights() + 400);
+    Router<double> router{graph, source_router.GetWeights(),
+                          source_router.GetPrevEdges()};
+    const Graph old_graph = graph;
+    graph = MakeChangedGraph(old_graph, 2);
+    router.Update(old_graph);
+    AssertSameRoutes(graph, router, "external table");
+    ASSERT_EQUAL((vector<double>(source_router.GetWeights(),
+                                 source_router.GetWeights() + 400)),
+                 source_weights);
+  }
+  {
+    Graph graph{2};
+    Router<double> router{graph};
+    const Graph old_graph{3};
+    ASSERT_THROWS(router.Update(old_graph), invalid_argument);
+  }
+}
+
+/**
+ * Все реализации релаксации строки, которые поддерживает процессор, дают
+ * то же, что поэлементный цикл, в том числе на хвостах строк, с
+ * недостижимыми ячейками и ячейками без ребра.
+ */
+template <typename EdgeIndex>
+void AssertSameMinPlusKernels() {
+  using detail::MinPlusKernel;
+  constexpr double INF = numeric_limits<double>::infinity();
+  constexpr EdgeIndex NO_EDGE = numeric_limits<EdgeIndex>::max();
+  mt19937 gen{42};
+  uniform_int_distribution<int> value_dist{0, 30};
+  for (size_t count = 0; count <= 19; ++count) {
+    vector<double> through_weights(count);
+    vector<EdgeIndex> through_prev_edges(count);
+    vector<double> row_weights(count);
+    vector<EdgeIndex> row_prev_edges(count);
+    for (size_t i = 0; i < count; ++i) {
+      const int value = value_dist(gen);
+      through_weights[i] = value < 5 ? INF : value;
+      through_prev_edges[i] = value % 4 == 0 ? NO_EDGE : value * 1000;
+      row_weights[i] = value_dist(gen) < 8 ? INF : value_dist(gen);
+      row_prev_edges[i] = value_dist(gen);
+    }
+    const double weight_from = value_dist(gen) / 2;
+    const EdgeIndex prev_edge_from = 7;
+    auto expected_weights = row_weights;
+    auto expected_prev_edges = row_prev_edges;
+    detail::RelaxRowMinPlusScalar(
+        weight_from, through_weights.data(), prev_edge_from,
+        through_prev_edges.data(), expected_weights.data(),
+        expected_prev_edges.data(), count);
+    for (MinPlusKernel kernel :
+         {MinPlusKernel::SCALAR, MinPlusKernel::SSE2, MinPlusKernel::AVX2}) {
+      if (!detail::IsMinPlusKernelSupported(kernel)) {
+        continue;
+      }
+      const string hint = "kernel " + to_string(kernel) + " count " +
+                          to_string(count) + " index size " +
+                          to_string(sizeof(EdgeIndex));
+      auto weights = row_weights;
+      auto prev_edges = row_prev_edges;
+      detail::RelaxRowMinPlus(kernel, weight_from, through_weights.data(),
+                              prev_edge_from, through_prev_edges.data(),
+                              weights.data(), prev_edges.data(), count);
+      ASSERT_EQUAL_HINT(weights, expected_weights, hint);
+      ASSERT_EQUAL_HINT(prev_edges, expected_prev_edges, hint);
+    }
+  }
+}
+
+void TestMinPlusKernels() {
+  ASSERT(detail::IsMinPlusKernelSupported(detail::MinPlusKernel::SCALAR));
+  ASSERT(detail::IsMinPlusKernelSupported(detail::GetBestMinPlusKernel()));
+  AssertSameMinPlusKernels<uint32_t>();
+  AssertSameMinPlusKernels<uint64_t>();
+}
+
+void TestDijkstraRouter() {
+  {
+    Graph graph{4};
+    graph.AddEdge({0, 1, 5});
+    graph.AddEdge({1, 2, 5});
+    graph.AddEdge({0, 2, 12});
+    graph.AddEdge({2, 0, 1});
+
+    DijkstraRouter<double> router{graph};
+    auto route = router.BuildRoute(0, 2);
+    ASSERT(route);
+    ASSERT_EQUAL(route->weight, 10.0);
+    ASSERT_EQUAL(route->edges, (vector<EdgeId>{0, 1}));
+    // повторный запрос не должен видеть состояние предыдущего поиска
+    ASSERT(!router.BuildRoute(0, 3));
+    route = router.BuildRoute(2, 1);
+    ASSERT(route);
+    ASSERT_EQUAL(route->weight, 6.0);
+    ASSERT_EQUAL(route->edges, (vector<EdgeId>{3, 0}));
+    ASSERT_THROWS(router.BuildRoute(0, 4), out_of_range);
+  }
+  {
+    Graph graph{2};
+    graph.AddEdge({0, 1, -1});
+    ASSERT_THROWS(DijkstraRouter<double>{graph}, domain_error);
+  }
+  for (unsigned seed = 1; seed <= 5; ++seed) {
+    const Graph graph = MakeRandomGraph(30, 80, seed);
+    DijkstraRouter<double> router{graph};
+    AssertSameRoutes(graph, router, "seed " + to_string(seed));
+  }
+}
+
+void TestShortestPathTree() {
+  {
+    Graph graph{4};
+    graph.AddEdge({0, 1, 5});
+    graph.AddEdge({1, 2, 5});
+    graph.AddEdge({0, 2, 12});
+    graph.AddEdge({2, 0, 1});
+    ShortestPathTree<double> tree{graph, 0};
+    ASSERT_EQUAL(tree.GetSource(), 0u);
+    auto route = tree.BuildRoute(2);
+    ASSERT(route);
+    ASSERT_EQUAL(route->weight, 10.0);
+    ASSERT_EQUAL(route->edges, (vector<EdgeId>{0, 1}));
+    route = tree.BuildRoute(0);
+    ASSERT(route);
+    ASSERT(route->edges.empty());
+    ASSERT(!tree.BuildRoute(3));
+    ASSERT_THROWS(tree.BuildRoute(4), out_of_range);
+    ASSERT_THROWS((ShortestPathTree<double>{graph, 4}), out_of_range);
+
+    // путь до 2 весит больше границы
+    ShortestPathTree<double> bounded_tree{graph, 0, 9.0};
+    ASSERT_EQUAL(bounded_tree.GetWeight(1).value_or(-1), 5.0);
+    ASSERT(!bounded_tree.GetWeight(2));
+    ASSERT(!bounded_tree.BuildRoute(2));
+    ASSERT_EQUAL(
+        ShortestPathTree<double>(graph, 0, 10.0).GetWeight(2).value_or(-1),
+        10.0);
+  }
+  for (unsigned seed = 1; seed <= 5; ++seed) {
+    const Graph graph = MakeRandomGraph(30, 80, seed);
+    const Router<double> expected_router{graph};
+    for (VertexId from = 0; from < graph.GetVertexCount(); ++from) {
+      ShortestPathTree<double> tree{graph, from};
+      ShortestPathTree<double> bounded_tree{graph, from, 20.0};
+      for (VertexId to = 0; to < graph.GetVertexCount(); ++to) {
+        const string hint = "seed " + to_string(seed) + " " + to_string(from) +
+                            "->" + to_string(to);
+        auto expected = expected_router.BuildRoute(from, to);
+        auto actual = tree.BuildRoute(to);
+        ASSERT_EQUAL_HINT(actual.has_value(), expected.has_value(), hint);
+        if (expected) {
+          ASSERT_EQUAL_HINT(actual->weight, expected->weight, hint);
+          AssertIsPath(graph, from, to, actual->weight, actual->edges, hint);
+        }
+        const bool in_bound = expected && expected->weight <= 20.0;
+        ASSERT_EQUAL_HINT(bounded_tree.GetWeight(to).has_value(), in_bound,
+                          hint);
+        if (in_bound) {
+          ASSERT_EQUAL_HINT(*bounded_tree.GetWeight(to), expected->weight,
+                            hint);
+        }
+      }
+    }
+  }
+}
+
+void TestReachabilityIndex() {
+  {
+    // два цикла, из первого есть ребро во второй, вершина 5 отдельно
+    Graph graph{6};
+    graph.AddEdge({0, 1, 1});
+    graph.AddEdge({1, 0, 1});
+    graph.AddEdge({1, 2, 1});
+    graph.AddEdge({2, 3, 1});
+    graph.AddEdge({3, 4, 1});
+    graph.AddEdge({4, 2, 1});
+    ReachabilityIndex<Graph> index{graph};
+    ASSERT(index.IsExact());
+    ASSERT_EQUAL(index.GetComponentCount(), 3u);
+    ASSERT_EQUAL(index.GetComponent(0), index.GetComponent(1));
+    ASSERT_EQUAL(index.GetComponent(2), index.GetComponent(4));
+    ASSERT(index.IsReachable(0, 4));
+    ASSERT(index.IsReachable(3, 2));
+    ASSERT(!index.IsReachable(2, 0));
+    ASSERT(!index.IsReachable(0, 5));
+    ASSERT(index.IsReachable(5, 5));
+
+    // без битовых множеств 2 -> 0 уже не отличить от достижимой пары
+    ReachabilityIndex<Graph> weak_index{graph, 0};
+    ASSERT(!weak_index.IsExact());
+    ASSERT(weak_index.IsReachable(0, 4));
+    ASSERT(weak_index.IsReachable(2, 0));
+    ASSERT(!weak_index.IsReachable(0, 5));
+  }
+  {
+    // длинная цепочка не должна переполнять стек
+    const size_t vertex_count = 200000;
+    Graph graph{vertex_count};
+    for (VertexId vertex = 0; vertex + 1 < vertex_count; ++vertex) {
+      graph.AddEdge({vertex, vertex + 1, 1});
+    }
+    ReachabilityIndex<Graph> index{graph};
+    ASSERT_EQUAL(index.GetComponentCount(), vertex_count);
+    ASSERT(!index.IsExact());
+    ASSERT(index.IsReachable(0, vertex_count - 1));
+  }
+  for (unsigned seed = 1; seed <= 5; ++seed) {
+    // рёбер мало, чтобы было много компонент
+    const Graph graph = MakeRandomGraph(70, 60, seed);
+    const Router<double> expected_router{graph};
+    const ReachabilityIndex<Graph> index{graph};
+    const ReachabilityIndex<Graph> weak_index{graph, 0};
+    const CsrGraph<double> csr_graph{graph};
+    const ReachabilityIndex<CsrGraph<double>> csr_index{csr_graph};
+    ASSERT(index.GetComponentCount() > 1);
+    for (VertexId from = 0; from < graph.GetVertexCount(); ++from) {
+      for (VertexId to = 0; to < graph.GetVertexCount(); ++to) {
+        const string hint = "seed " + to_string(seed) + " " + to_string(from) +
+                            "->" + to_string(to);
+        const bool expected = expected_router.BuildRoute(from, to).has_value();
+        ASSERT_EQUAL_HINT(index.IsReachable(from, to), expected, hint);
+        ASSERT_EQUAL_HINT(csr_index.IsReachable(from, to), expected, hint);
+        if (expected) {
+          ASSERT_HINT(weak_index.IsReachable(from, to), hint);
+        }
+      }
+    }
+  }
+}
+
+void TestIncomingEdgesIndex() {
+  Graph graph{3};
+  graph.AddEdge({0, 2, 1});
+  ASSERT(!graph.HasIncomingEdgesIndex());
+  ASSERT_THROWS(graph.GetIncomingEdges(2), logic_error);
+
+  graph.BuildIncomingEdgesIndex();
+  graph.AddEdge({1, 2, 1});
+  graph.AddEdge({2, 0, 1});
+  ASSERT(graph.HasIncomingEdgesIndex());
+  const auto incoming = graph.GetIncomingEdges(2);
+  ASSERT_EQUAL((vector<EdgeId>{incoming.begin(), incoming.end()}),
+               (vector<EdgeId>{0, 1}));
+  ASSERT(graph.GetIncomingEdges(1).begin() == graph.GetIncomingEdges(1).end());
+}
+
+void TestBidirectionalDijkstraRouter() {
+  {
+    Graph graph{2};
+    graph.AddEdge({0, 1, 1});
+    ASSERT_THROWS(BidirectionalDijkstraRouter<double>{graph}, invalid_argument);
+  }
+  {
+    Graph graph{4};
+    graph.AddEdge({0, 1, 5});
+    graph.AddEdge({1, 2, 5});
+    graph.AddEdge({0, 2, 12});
+    graph.AddEdge({2, 0, 1});
+    graph.BuildIncomingEdgesIndex();
+
+    BidirectionalDijkstraRouter<double> router{graph};
+    auto route = router.BuildRoute(0, 2);
+    ASSERT(route);
+    ASSERT_EQUAL(route->weight, 10.0);
+    ASSERT_EQUAL(route->edges, (vector<EdgeId>{0, 1}));
+    ASSERT(!router.BuildRoute(0, 3));
+    route = router.BuildRoute(3, 3);
+    ASSERT(route);
+    ASSERT(route->edges.empty());
+  }
+  for (unsigned seed = 1; seed <= 5; ++seed) {
+    Graph graph = MakeRandomGraph(30, 80, seed);
+    graph.BuildIncomingEdgesIndex();
+    BidirectionalDijkstraRouter<double> router{graph};
+    AssertSameRoutes(graph, router, "seed " + to_string(seed));
+  }
+}
+
+void TestAStarRouter() {
+  {
+    // нулевой потенциал превращает A* в обычного Дейкстру
+    const Graph graph = MakeRandomGraph(30, 80, 1);
+    AStarRouter<double> router{
+        graph, [](VertexId, VertexId) { return optional<double>{0.0}; }};
+    AssertSameRoutes(graph, router, "zero potential");
+  }
+  {
+    // вершины на прямой, вес ребра - расстояние между ними: оценка
+    // расстоянием по прямой точна
+    Graph graph{5};
+    for (VertexId v = 0; v + 1 < 5; ++v) {
+      graph.AddEdge({v, v + 1, 1});
+      graph.AddEdge({v + 1, v, 1});
+    }
+    graph.AddEdge({0, 4, 10});
+    AStarRouter<double> router{graph, [](VertexId vertex, VertexId target) {
+                                 return optional<double>{
+                                     abs(static_cast<double>(vertex) -
+                                         static_cast<double>(target))};
+                               }};
+    auto route = router.BuildRoute(0, 4);
+    ASSERT(route);
+    ASSERT_EQUAL(route->weight, 4.0);
+    ASSERT_EQUAL(route->edges, (vector<EdgeId>{0, 2, 4, 6}));
+  }
+  {
+    Graph graph{2};
+    graph.AddEdge({0, 1, 1});
+    AStarRouter<double> router{
+        graph, [](VertexId, VertexId) { return optional<double>{}; }};
+    ASSERT(!router.BuildRoute(0, 1));
+  }
+}
+
+void TestAltRouter() {
+  {
+    Graph graph{2};
+    ASSERT_THROWS((AltRouter<double>{graph, 2}), invalid_argument);
+  }
+  {
+    // две несвязные части: ориентир должен найтись в каждой, а маршрут между
+    // частями - отсекаться оценкой сразу
+    Graph graph{4};
+    graph.AddEdge({0, 1, 1});
+    graph.AddEdge({1, 0, 1});
+    graph.AddEdge({2, 3, 1});
+    graph.AddEdge({3, 2, 1});
+    graph.BuildIncomingEdgesIndex();
+    Landmarks<double> landmarks{graph, 2};
+    ASSERT_EQUAL(landmarks.GetLandmarks(), (vector<VertexId>{0, 2}));
+    ASSERT(!landmarks.LowerBound(0, 3));
+    const auto bound = landmarks.LowerBound(1, 0);
+    ASSERT(bound);
+    ASSERT_EQUAL(*bound, 1.0);
+  }
+  for (unsigned seed = 1; seed <= 5; ++seed) {
+    Graph graph = MakeRandomGraph(30, 80, seed);
+    graph.BuildIncomingEdgesIndex();
+    for (size_t landmark_count : {1, 4, 40}) {
+      AltRouter<double> router{graph, landmark_count};
+      AssertSameRoutes(graph, router,
+                       "seed " + to_string(seed) + " landmarks " +
+                           to_string(landmark_count));
+    }
+  }
+}
+
+void TestContractionHierarchyRouter() {
+  {
+    // 0 -> 1 -> 2 дешевле прямого ребра 0 -> 2, поэтому при сжатии 1
+    // понадобится сокращение, а маршрут должен раскрыться в исходные рёбра
+    Graph graph{3};
+    graph.AddEdge({0, 1, 1});
+    graph.AddEdge({1, 2, 1});
+    graph.AddEdge({0, 2, 5});
+    ContractionHierarchyRouter<double> router{graph};
+    auto route = router.BuildRoute(0, 2);
+    ASSERT(route);
+    ASSERT_EQUAL(route->weight, 2.0);
+    ASSERT_EQUAL(route->edges, (vector<EdgeId>{0, 1}));
+    ASSERT(!router.BuildRoute(2, 0));
+    route = router.BuildRoute(1, 1);
+    ASSERT(route);
+    ASSERT(route->edges.empty());
+  }
+  {
+    Graph graph{2};
+    graph.AddEdge({0, 1, -1});
+    ASSERT_THROWS(ContractionHierarchyRouter<double>{graph}, domain_error);
+  }
+  for (unsigned seed = 1; seed <= 5; ++seed) {
+    const Graph graph = MakeRandomGraph(40, 120, seed);
+    ContractionHierarchyRouter<double> router{graph};
+    AssertSameRoutes(graph, router, "seed " + to_string(seed));
+  }
+}
+
+void TestHubLabelRouter() {
+  {
+    Graph graph{2};
+    ASSERT_THROWS(HubLabelRouter<double>{graph}, invalid_argument);
+  }
+  {
+    // у вершины 1 больше всего рёбер, она станет первым хабом и покроет все
+    // пути через себя
+    Graph graph{4};
+    graph.AddEdge({0, 1, 1});
+    graph.AddEdge({1, 2, 1});
+    graph.AddEdge({0, 2, 5});
+    graph.AddEdge({3, 1, 2});
+    graph.BuildIncomingEdgesIndex();
+    HubLabelRouter<double> router{graph};
+    auto route = router.BuildRoute(0, 2);
+    ASSERT(route);
+    ASSERT_EQUAL(route->weight, 2.0);
+    ASSERT_EQUAL(route->edges, (vector<EdgeId>{0, 1}));
+    route = router.BuildRoute(3, 2);
+    ASSERT(route);
+    ASSERT_EQUAL(route->weight, 3.0);
+    ASSERT_EQUAL(route->edges, (vector<EdgeId>{3, 1}));
+    ASSERT(!router.BuildRoute(2, 0));
+    route = router.BuildRoute(2, 2);
+    ASSERT(route);
+    ASSERT(route->edges.empty());
+    ASSERT_THROWS(router.BuildRoute(0, 4), out_of_range);
+
+    const auto &stats = router.GetStats();
+    // каждая вершина - хаб сама для себя, плюс записи хаба 1
+    ASSERT(stats.label_entry_count >= 8);
+    ASSERT(stats.max_label_size >= 1);
+  }
+  for (unsigned seed = 1; seed <= 5; ++seed) {
+    Graph graph = MakeRandomGraph(40, 120, seed);
+    graph.BuildIncomingEdgesIndex();
+    HubLabelRouter<double> router{graph};
+    AssertSameRoutes(graph, router, "seed " + to_string(seed));
+  }
+}
+
+void TestCsrGraph() {
+  ASSERT_EQUAL(CsrGraph<double>{Graph{}}.GetVertexCount(), 0u);
+
+  Graph graph{3};
+  graph.AddEdge({2, 0, 1});
+  graph.AddEdge({0, 1, 2});
+  graph.AddEdge({0, 2, 3});
+  graph.AddEdge({1, 2, 4});
+  const CsrGraph<double> csr{graph};
+  ASSERT_EQUAL(csr.GetVertexCount(), 3u);
+  ASSERT_EQUAL(csr.GetEdgeCount(), 4u);
+  ASSERT(csr.HasIncomingEdgesIndex());
+
+  // рёбра сгруппированы по начальной вершине в исходном порядке
+  const auto incident = csr.GetIncidentEdges(0);
+  ASSERT_EQUAL((vector<EdgeId>{incident.begin(), incident.end()}),
+               (vector<EdgeId>{0, 1}));
+  vector<EdgeId> source_ids;
+  for (EdgeId id = 0; id < csr.GetEdgeCount(); ++id) {
+    const auto edge = csr.GetEdge(id);
+    const auto &source_edge = graph.GetEdge(csr.GetSourceEdgeId(id));
+    ASSERT_EQUAL(edge.from, source_edge.from);
+    ASSERT_EQUAL(edge.to, source_edge.to);
+    ASSERT_EQUAL(edge.weight, source_edge.weight);
+    source_ids.push_back(csr.GetSourceEdgeId(id));
+  }
+  ASSERT_EQUAL(source_ids, (vector<EdgeId>{1, 2, 3, 0}));
+
+  const auto incoming = csr.GetIncomingEdges(2);
+  ASSERT_EQUAL((vector<EdgeId>{incoming.begin(), incoming.end()}),
+               (vector<EdgeId>{1, 2}));
+  ASSERT(csr.GetIncidentEdges(2).begin() != csr.GetIncidentEdges(2).end());
+  ASSERT(csr.GetIncomingEdges(0).begin() != csr.GetIncomingEdges(0).end());
+}
+
+void TestCsrGraphRouters() {
+  using Csr = CsrGraph<double>;
+  for (unsigned seed = 1; seed <= 3; ++seed) {
+    Graph graph = MakeRandomGraph(30, 80, seed);
+    const Csr csr{graph};
+    const string hint = "seed " + to_string(seed);
+
+    const Router<double> expected_router{graph};
+    const Router<double, Csr> csr_router{csr};
+    for (VertexId from = 0; from < graph.GetVertexCount(); ++from) {
+      for (VertexId to = 0; to < graph.GetVertexCount(); ++to) {
+        auto expected = expected_router.BuildRoute(from, to);
+        auto actual = csr_router.BuildRoute(from, to);
+        ASSERT_EQUAL_HINT(actual.has_value(), expected.has_value(), hint);
+        if (expected) {
+          ASSERT_EQUAL_HINT(actual->weight, expected->weight, hint);
+        }
+      }
+    }
+
+    AssertSameRoutes(csr, DijkstraRouter<double, Csr>{csr}, hint);
+    AssertSameRoutes(csr, BidirectionalDijkstraRouter<double, Csr>{csr},
+                     hint);
+    AssertSameRoutes(
+        csr,
+        AStarRouter<double, Csr>{
+            csr, [](VertexId, VertexId) { return optional<double>{0.0}; }},
+        hint);
+    AssertSameRoutes(csr, AltRouter<double, Csr>{csr, 4}, hint);
+    AssertSameRoutes(csr, ContractionHierarchyRouter<double, Csr>{csr}, hint);
+    AssertSameRoutes(csr, HubLabelRouter<double, Csr>{csr}, hint);
+  }
+}
+
+}  // namespace graph::tests
+
+void TestRouter(TestRunner &tr) {
+  using namespace graph::tests;
+
+  RUN_TEST(tr, TestFloydWarshallRouter);
+  RUN_TEST(tr, TestParallelFloydWarshallRouter);
+  RUN_TEST(tr, TestFloydWarshallUpdate);
+  RUN_TEST(tr, TestMinPlusKernels);
+  RUN_TEST(tr, TestDijkstraRouter);
+  RUN_TEST(tr, TestShortestPathTree);
+  RUN_TEST(tr, TestReachabilityIndex);
+  RUN_TEST(tr, TestIncomingEdgesIndex);
+  RUN_TEST(tr, TestBidirectionalDijkstraRouter);
+  RUN_TEST(tr, TestAStarRouter);
+  RUN_TEST(tr, TestAltRouter);
+  RUN_TEST(tr, TestContractionHierarchyRouter);
+  RUN_TEST(tr, TestHubLabelRouter);
+  RUN_TEST(tr, TestCsrGraph);
+  RUN_TEST(tr, TestCsrGraphRouters);
+}
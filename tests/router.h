@@ -0,0 +1,5 @@
+#pragma once
+
+class TestRunner;
+
+void TestRouter(TestRunner &tr);
@@ -12,6 +12,7 @@
 #include <type_traits>
 #include <unordered_map>
 #include <unordered_set>
+#include <utility>
 #include <vector>
 
 namespace TestRunnerPrivate {
@@ -46,6 +47,11 @@ std::ostream &PrintSet(std::ostream &os, const Set &s) {
 
 }  // namespace TestRunnerPrivate
 
+template <class K, class V>
+std::ostream &operator<<(std::ostream &os, const std::pair<K, V> &p) {
+  return os << '{' << p.first << ", " << p.second << '}';
+}
+
 template <class T>
 std::ostream &operator<<(std::ostream &os, const std::vector<T> &s) {
   os << "{";
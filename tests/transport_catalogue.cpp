@@ -70,6 +70,34 @@ void TestAddBus() {
       invalid_argument);
 }
 
+void TestAddTrip() {
+  TransportCatalogue tc;
+  tc.AddStop("Rasskazovka"s, {55.632761, 37.333324});
+  tc.AddStop("Marushkino"s, {55.595884, 37.209755});
+  tc.AddBus("750"s, RouteType::LINEAR, {"Rasskazovka"s, "Marushkino"s});
+  tc.AddBus("751"s, RouteType::CIRCULAR,
+            {"Rasskazovka"s, "Marushkino"s, "Rasskazovka"s});
+
+  // линейный рейс проезжает три остановки, кольцевой - тоже три
+  ASSERT_DOESNT_THROW(tc.AddTrip("750"sv, {480, 490, 500}));
+  ASSERT_DOESNT_THROW(tc.AddTrip("750"sv, {540, 540, 560}));
+  ASSERT_DOESNT_THROW(tc.AddTrip("751"sv, {600, 610, 620}));
+  ASSERT_EQUAL(tc.GetBuses()[0]->trips.size(), 2u);
+  ASSERT_EQUAL(tc.GetBuses()[0]->trips[1].departure_times,
+               (vector<double>{540, 540, 560}));
+  ASSERT_EQUAL(tc.GetBuses()[1]->trips.size(), 1u);
+
+  ASSERT_THROWS(tc.AddTrip("752"sv, {480, 490, 500}), invalid_argument);
+  ASSERT_THROWS(tc.AddTrip("750"sv, {480, 490}), invalid_argument);
+  ASSERT_THROWS(tc.AddTrip("751"sv, {480, 490, 500, 510}), invalid_argument);
+  ASSERT_THROWS(tc.AddTrip("750"sv, {480, 470, 500}), invalid_argument);
+  // у кольцевого маршрута из одной остановки остановок не остаётся
+  tc.AddBus("753"s, RouteType::CIRCULAR, {"Rasskazovka"s});
+  ASSERT_THROWS(tc.AddTrip("753"sv, {}), invalid_argument);
+  ASSERT_THROWS(tc.AddTrip("753"sv, {480}), invalid_argument);
+  ASSERT_EQUAL(tc.GetBuses()[0]->trips.size(), 2u);
+}
+
 void TestSetDistance() {
   TransportCatalogue tc;
 
@@ -92,6 +120,21 @@ void TestSetDistance() {
   ASSERT_THROWS(tc.SetDistance("A"sv, "B"sv, 1123), invalid_argument);
 }
 
+void TestChangeDistance() {
+  TransportCatalogue tc;
+  tc.AddStop("A"s, {55.632761, 37.333324});
+  ASSERT_THROWS(tc.ChangeDistance("A"s, "B"s, 1000), invalid_argument);
+  tc.AddStop("B"s, {55.632761, 37.3492554327});
+  tc.AddBus("1"s, RouteType::LINEAR, {"A"s, "B"s});
+
+  tc.ChangeDistance("A"sv, "B"sv, 1000);
+  ASSERT_SOFT_EQUAL(tc.GetBusStats("1"sv)->route_length, 1000 * 2);
+  tc.ChangeDistance("A"sv, "B"sv, 1500);
+  ASSERT_SOFT_EQUAL(tc.GetBusStats("1"sv)->route_length, 1500 * 2);
+  tc.ChangeDistance("B"sv, "A"sv, 500);
+  ASSERT_SOFT_EQUAL(tc.GetBusStats("1"sv)->route_length, 1500 + 500);
+}
+
 void TestGetBusStats() {
   {
     TransportCatalogue tc;
@@ -237,7 +280,9 @@ void TestTransportCatalogue(TestRunner &tr) {
 
   RUN_TEST(tr, TestAddStop);
   RUN_TEST(tr, TestAddBus);
+  RUN_TEST(tr, TestAddTrip);
   RUN_TEST(tr, TestSetDistance);
+  RUN_TEST(tr, TestChangeDistance);
   RUN_TEST(tr, TestGetBusStats);
   RUN_TEST(tr, TestGetStopInfo);
   RUN_TEST(tr, TestGetBuses);
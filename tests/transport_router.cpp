@@ -0,0 +1,1125 @@
+#include "../transport-catalogue/transport_router.h"
+
+#include <algorithm>
+#include <filesystem>
+#include <random>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include "../transport-catalogue/transport_catalogue.h"
+#include "test_framework.h"
+#include "transport_router.h"
+
+using namespace std;
+
+namespace transport_catalogue::router::tests {
+
+/**
+ * Небольшой справочник, на котором маршруты легко посчитать руками.
+ * При скорости 30 км/ч автобус проезжает 500 метров за минуту.
+ *
+ * Маршруты:
+ *  - "1": A - B - C, линейный;
+ *  - "2": C - D - E - C, кольцевой;
+ *  - "3": B - D, линейный.
+ * Остановка F ни с чем не связана.
+ */
+void FillSmallCatalogue(TransportCatalogue &tc) {
+  tc.AddStop("A"s, {55.60, 37.20});
+  tc.AddStop("B"s, {55.61, 37.21});
+  tc.AddStop("C"s, {55.62, 37.22});
+  tc.AddStop("D"s, {55.63, 37.23});
+  tc.AddStop("E"s, {55.64, 37.24});
+  tc.AddStop("F"s, {55.65, 37.25});
+  tc.SetDistance("A"s, "B"s, 1000);
+  tc.SetDistance("B"s, "C"s, 1500);
+  tc.SetDistance("C"s, "D"s, 2000);
+  tc.SetDistance("D"s, "E"s, 500);
+  tc.SetDistance("E"s, "C"s, 1000);
+  tc.SetDistance("B"s, "D"s, 3000);
+  tc.AddBus("1"s, RouteType::LINEAR, {"A"s, "B"s, "C"s});
+  tc.AddBus("2"s, RouteType::CIRCULAR, {"C"s, "D"s, "E"s, "C"s});
+  tc.AddBus("3"s, RouteType::LINEAR, {"B"s, "D"s});
+}
+
+/**
+ * Справочник со случайной сетью маршрутов. Расстояния целые и небольшие,
+ * так что маршруты с разной последовательностью рёбер часто получаются
+ * одинаковыми по времени - это хорошо проверяет движки на равноценных путях.
+ */
+void FillRandomCatalogue(TransportCatalogue &tc, unsigned seed,
+                         size_t stop_count = 25, size_t bus_count = 8) {
+  mt19937 gen{seed};
+  uniform_real_distribution<double> coord_dist{0.0, 0.05};
+  uniform_int_distribution<size_t> stop_dist{0, stop_count - 1};
+  uniform_int_distribution<size_t> len_dist{2, 7};
+  uniform_int_distribution<int> distance_dist{1, 6};
+
+  vector<string> names;
+  for (size_t i = 0; i < stop_count; ++i) {
+    names.push_back("S"s + to_string(i));
+    tc.AddStop(names.back(), {55.6 + coord_dist(gen), 37.2 + coord_dist(gen)});
+  }
+  for (size_t i = 0; i < stop_count; ++i) {
+    for (size_t j = 0; j < 3; ++j) {
+      size_t other = stop_dist(gen);
+      try {
+        tc.SetDistance(names[i], names[other], distance_dist(gen) * 500);
+      } catch (const invalid_argument &) {
+        // расстояние между этой парой уже задано
+      }
+    }
+  }
+  for (size_t i = 0; i < bus_count; ++i) {
+    vector<string> stops;
+    for (size_t j = len_dist(gen); j > 0; --j) {
+      stops.push_back(names[stop_dist(gen)]);
+    }
+    RouteType route_type = i % 2 == 0 ? RouteType::LINEAR : RouteType::CIRCULAR;
+    if (route_type == RouteType::CIRCULAR) {
+      stops.push_back(stops[0]);
+    }
+    tc.AddBus("B"s + to_string(i), route_type, stops);
+  }
+}
+
+/**
+ * Запись шагов маршрута строками вида "Wait A 2" и "Bus 1 2 5",
+ * где время указано в минутах.
+ */
+vector<string> DescribeSteps(const RouteResult &route) {
+  vector<string> result;
+  for (const auto &step : route.steps) {
+    ostringstream out;
+    if (holds_alternative<WaitAction>(step)) {
+      const auto &wait = get<WaitAction>(step);
+      out << "Wait "s << wait.stop_name << ' ' << wait.time / 60;
+    } else {
+      const auto &bus = get<BusAction>(step);
+      out << "Bus "s << bus.bus_name << ' ' << bus.stop_count << ' '
+          << bus.time / 60;
+    }
+    result.push_back(out.str());
+  }
+  return result;
+}
+
+/**
+ * Проверяет, что сумма времени шагов маршрута совпадает с общим временем.
+ */
+void AssertConsistent(const RouteResult &route, const string &hint) {
+  double time = 0;
+  for (const auto &step : route.steps) {
+    time += holds_alternative<WaitAction>(step) ? get<WaitAction>(step).time
+                                                : get<BusAction>(step).time;
+  }
+  if (route.time == 0) {
+    ASSERT_EQUAL_HINT(time, 0.0, hint);
+  } else {
+    ASSERT_SOFT_EQUAL_HINT(time, route.time, hint);
+  }
+}
+
+RouterSettings GetTestRouterSettings(RouterEngine engine) {
+  RouterSettings settings;
+  settings.bus_velocity = 30;
+  settings.bus_wait_time = 2;
+  settings.engine = engine;
+  return settings;
+}
+
+const vector<RouterEngine> ALL_ENGINES{RouterEngine::FLOYD_WARSHALL,
+                                       RouterEngine::DIJKSTRA,
+                                       RouterEngine::BIDIRECTIONAL_DIJKSTRA,
+                                       RouterEngine::A_STAR,
+                                       RouterEngine::ALT,
+                                       RouterEngine::CONTRACTION_HIERARCHY,
+                                       RouterEngine::HUB_LABELS,
+                                       RouterEngine::RAPTOR};
+
+void TestSmallCatalogueRoutes(const RouterSettings &settings) {
+  TransportCatalogue tc;
+  FillSmallCatalogue(tc);
+  Router router{settings, tc};
+
+  auto route = router.CalcRoute("A"sv, "C"sv);
+  ASSERT(route);
+  ASSERT_SOFT_EQUAL(route->time, 7.0 * 60);
+  ASSERT_EQUAL(DescribeSteps(*route),
+               (vector<string>{"Wait A 2"s, "Bus 1 2 5"s}));
+
+  route = router.CalcRoute("A"sv, "D"sv);
+  ASSERT(route);
+  ASSERT_SOFT_EQUAL(route->time, 12.0 * 60);
+  ASSERT_EQUAL(DescribeSteps(*route),
+               (vector<string>{"Wait A 2"s, "Bus 1 1 2"s, "Wait B 2"s,
+                               "Bus 3 1 6"s}));
+
+  route = router.CalcRoute("E"sv, "D"sv);
+  ASSERT(route);
+  ASSERT_SOFT_EQUAL(route->time, 10.0 * 60);
+  ASSERT_EQUAL(DescribeSteps(*route),
+               (vector<string>{"Wait E 2"s, "Bus 2 1 2"s, "Wait C 2"s,
+                               "Bus 2 1 4"s}));
+
+  route = router.CalcRoute("B"sv, "B"sv);
+  ASSERT(route);
+  ASSERT_EQUAL(route->time, 0.0);
+  ASSERT(route->steps.empty());
+
+  ASSERT(!router.CalcRoute("A"sv, "F"sv));
+  ASSERT(!router.CalcRoute("F"sv, "A"sv));
+  ASSERT(!router.CalcRoute("A"sv, "Z"sv));
+}
+
+/**
+ * Сравнивает ответы всех движков с Флойдом-Уоршеллом на случайных сетях.
+ */
+void AssertSameAsFloydWarshall(const RouterSettings &settings) {
+  for (unsigned seed = 1; seed <= 3; ++seed) {
+    TransportCatalogue tc;
+    FillRandomCatalogue(tc, seed);
+    Router expected_router{GetTestRouterSettings(RouterEngine::FLOYD_WARSHALL),
+                           tc};
+    Router router{settings, tc};
+    for (const Stop *from : tc.GetStops()) {
+      for (const Stop *to : tc.GetStops()) {
+        const string hint = "seed "s + to_string(seed) + " "s + from->name +
+                            "->"s + to->name;
+        auto expected = expected_router.CalcRoute(from->name, to->name);
+        auto actual = router.CalcRoute(from->name, to->name);
+        ASSERT_EQUAL_HINT(actual.has_value(), expected.has_value(), hint);
+        if (expected) {
+          if (expected->time == 0) {
+            ASSERT_EQUAL_HINT(actual->time, 0.0, hint);
+          } else {
+            ASSERT_SOFT_EQUAL_HINT(actual->time, expected->time, hint);
+          }
+          AssertConsistent(*actual, hint);
+        }
+      }
+    }
+  }
+}
+
+void TestEngines() {
+  for (RouterEngine engine : ALL_ENGINES) {
+    TestSmallCatalogueRoutes(GetTestRouterSettings(engine));
+    AssertSameAsFloydWarshall(GetTestRouterSettings(engine));
+  }
+}
+
+/**
+ * Маршрутов между несвязанными сетями нет ни у одного движка, в том числе
+ * в матрице и с другим профилем, с индексом достижимости и без него.
+ */
+void TestDisjointNetworks() {
+  TransportCatalogue tc;
+  FillSmallCatalogue(tc);
+  tc.AddStop("X"s, {56.60, 38.20});
+  tc.AddStop("Y"s, {56.61, 38.21});
+  tc.SetDistance("X"s, "Y"s, 1200);
+  tc.AddBus("9"s, RouteType::LINEAR, {"X"s, "Y"s});
+  RouteProfile profile;
+  profile.bus_wait_time = 5;
+  for (RouterEngine engine : ALL_ENGINES) {
+    for (GraphModel graph_model :
+         {GraphModel::ALL_PAIRS, GraphModel::RIDE_CHAIN,
+          GraphModel::WAIT_FREE}) {
+      for (bool use_reachability_index : {false, true}) {
+        const string hint = "engine "s + to_string(engine) + " model "s +
+                            to_string(graph_model) + " index "s +
+                            to_string(use_reachability_index);
+        auto settings = GetTestRouterSettings(engine);
+        settings.graph_model = graph_model;
+        settings.use_reachability_index = use_reachability_index;
+        const Router router{settings, tc};
+        ASSERT_EQUAL_HINT(
+            router.HasReachabilityIndex(),
+            use_reachability_index && engine != RouterEngine::RAPTOR, hint);
+        ASSERT_HINT(!router.CalcRoute("A"sv, "Y"sv), hint);
+        ASSERT_HINT(!router.CalcRoute("X"sv, "E"sv), hint);
+        ASSERT_HINT(!router.CalcRoute("X"sv, "A"sv, profile), hint);
+        ASSERT_HINT(router.CalcRoute("Y"sv, "X"sv), hint);
+        ASSERT_HINT(router.CalcRoute("Y"sv, "X"sv, profile), hint);
+
+        const auto matrix =
+            router.CalcRouteMatrix({"A"sv, "X"sv}, {"Y"sv, "B"sv}, true);
+        ASSERT_HINT(!matrix.times[0], hint);
+        ASSERT_HINT(matrix.times[1], hint);
+        ASSERT_HINT(matrix.times[2], hint);
+        ASSERT_HINT(!matrix.times[3], hint);
+      }
+    }
+  }
+}
+
+void TestTreeCache() {
+  auto settings = GetTestRouterSettings(RouterEngine::DIJKSTRA);
+  settings.tree_cache_size = 2;
+  TestSmallCatalogueRoutes(settings);
+  AssertSameAsFloydWarshall(settings);
+
+  TransportCatalogue tc;
+  FillSmallCatalogue(tc);
+  Router router{settings, tc};
+  ASSERT_EQUAL(router.GetTreeCacheStats().GetHitRate(), 0.0);
+
+  router.CalcRoute("A"sv, "C"sv);
+  router.CalcRoute("A"sv, "D"sv);
+  router.CalcRoute("B"sv, "D"sv);
+  auto stats = router.GetTreeCacheStats();
+  ASSERT_EQUAL(stats.size, 2u);
+  ASSERT_EQUAL(stats.hits, 1u);
+  ASSERT_EQUAL(stats.misses, 2u);
+  ASSERT_EQUAL(stats.evictions, 0u);
+
+  // A использовалась позже B, поэтому вытесняется B
+  router.CalcRoute("A"sv, "E"sv);
+  router.CalcRoute("E"sv, "D"sv);
+  router.CalcRoute("A"sv, "B"sv);
+  stats = router.GetTreeCacheStats();
+  ASSERT_EQUAL(stats.size, 2u);
+  ASSERT_EQUAL(stats.hits, 3u);
+  ASSERT_EQUAL(stats.misses, 3u);
+  ASSERT_EQUAL(stats.evictions, 1u);
+  ASSERT_SOFT_EQUAL(stats.GetHitRate(), 0.5);
+
+  // неизвестные остановки до кэша не доходят
+  ASSERT(!router.CalcRoute("Z"sv, "A"sv));
+  ASSERT_EQUAL(router.GetTreeCacheStats().misses, 3u);
+}
+
+/**
+ * Матрица маршрутов должна совпадать с ответами на отдельные запросы.
+ */
+void AssertMatrixMatchesRoutes(const Router &router,
+                               const vector<string_view> &from,
+                               const vector<string_view> &to,
+                               const string &hint) {
+  const auto times_only = router.CalcRouteMatrix(from, to, false);
+  const auto with_steps = router.CalcRouteMatrix(from, to, true);
+  ASSERT_EQUAL_HINT(times_only.from_count, from.size(), hint);
+  ASSERT_EQUAL_HINT(times_only.to_count, to.size(), hint);
+  ASSERT_EQUAL_HINT(times_only.times.size(), from.size() * to.size(), hint);
+  ASSERT_HINT(times_only.steps.empty(), hint);
+  ASSERT_EQUAL_HINT(with_steps.steps.size(), from.size() * to.size(), hint);
+  for (size_t i = 0; i < from.size(); ++i) {
+    for (size_t j = 0; j < to.size(); ++j) {
+      const string pair_hint =
+          hint + " "s + string{from[i]} + "->"s + string{to[j]};
+      const size_t index = i * to.size() + j;
+      const auto route = router.CalcRoute(from[i], to[j]);
+      ASSERT_EQUAL_HINT(times_only.times[index].has_value(), route.has_value(),
+                        pair_hint);
+      ASSERT_EQUAL_HINT(with_steps.times[index].has_value(), route.has_value(),
+                        pair_hint);
+      if (!route) {
+        continue;
+      }
+      ASSERT_EQUAL_HINT(*times_only.times[index], *with_steps.times[index],
+                        pair_hint);
+      if (route->time == 0) {
+        ASSERT_EQUAL_HINT(*times_only.times[index], 0.0, pair_hint);
+      } else {
+        ASSERT_SOFT_EQUAL_HINT(*times_only.times[index], route->time,
+                               pair_hint);
+      }
+      RouteResult matrix_route{*with_steps.times[index],
+                               with_steps.steps[index]};
+      AssertConsistent(matrix_route, pair_hint);
+    }
+  }
+}
+
+void TestRouteMatrix() {
+  {
+    TransportCatalogue tc;
+    FillSmallCatalogue(tc);
+    Router router{GetTestRouterSettings(RouterEngine::DIJKSTRA), tc};
+    const vector<string_view> from{"A"sv, "E"sv, "Z"sv, "A"sv};
+    const vector<string_view> to{"C"sv, "D"sv, "F"sv, "A"sv, "Z"sv};
+    AssertMatrixMatchesRoutes(router, from, to, "small"s);
+
+    const auto matrix = router.CalcRouteMatrix(from, to, true);
+    ASSERT_SOFT_EQUAL(*matrix.times[1], 12.0 * 60);
+    ASSERT_EQUAL(DescribeSteps({*matrix.times[1], matrix.steps[1]}),
+                 (vector<string>{"Wait A 2"s, "Bus 1 1 2"s, "Wait B 2"s,
+                                 "Bus 3 1 6"s}));
+    ASSERT(!matrix.times[2]);
+    ASSERT_EQUAL(*matrix.times[3], 0.0);
+    ASSERT(!matrix.times[2 * to.size()]);
+
+    const auto empty = router.CalcRouteMatrix({}, to, false);
+    ASSERT_EQUAL(empty.from_count, 0u);
+    ASSERT(empty.times.empty());
+  }
+  for (RouterEngine engine : ALL_ENGINES) {
+    auto settings = GetTestRouterSettings(engine);
+    for (size_t tree_cache_size : {0, 3}) {
+      settings.tree_cache_size = tree_cache_size;
+      TransportCatalogue tc;
+      FillRandomCatalogue(tc, 1);
+      Router router{settings, tc};
+      vector<string_view> stops;
+      for (const Stop *stop : tc.GetStops()) {
+        stops.push_back(stop->name);
+      }
+      AssertMatrixMatchesRoutes(router, stops, stops,
+                                "engine "s + to_string(engine) + " cache "s +
+                                    to_string(tree_cache_size));
+    }
+  }
+}
+
+void TestRideChainGraphModel() {
+  for (RouterEngine engine : ALL_ENGINES) {
+    auto settings = GetTestRouterSettings(engine);
+    settings.graph_model = GraphModel::RIDE_CHAIN;
+    TestSmallCatalogueRoutes(settings);
+    AssertSameAsFloydWarshall(settings);
+  }
+
+  // перегоны одной поездки складываются в один шаг
+  TransportCatalogue tc;
+  FillSmallCatalogue(tc);
+  auto settings = GetTestRouterSettings(RouterEngine::DIJKSTRA);
+  settings.graph_model = GraphModel::RIDE_CHAIN;
+  settings.tree_cache_size = 2;
+  Router router{settings, tc};
+  auto route = router.CalcRoute("C"sv, "A"sv);
+  ASSERT(route);
+  ASSERT_EQUAL(DescribeSteps(*route),
+               (vector<string>{"Wait C 2"s, "Bus 1 2 5"s}));
+  route = router.CalcRoute("D"sv, "C"sv);
+  ASSERT(route);
+  ASSERT_EQUAL(DescribeSteps(*route),
+               (vector<string>{"Wait D 2"s, "Bus 2 2 3"s}));
+  AssertMatrixMatchesRoutes(router, {"A"sv, "D"sv, "E"sv},
+                            {"A"sv, "C"sv, "E"sv, "F"sv}, "ride chain"s);
+}
+
+/**
+ * Модель с одной вершиной на остановку должна давать те же маршруты, что и
+ * двухвершинная, вплоть до погрешности округления, и тоже с шагами ожидания.
+ */
+void TestWaitFreeGraphModel() {
+  for (RouterEngine engine : ALL_ENGINES) {
+    auto settings = GetTestRouterSettings(engine);
+    settings.graph_model = GraphModel::WAIT_FREE;
+    TestSmallCatalogueRoutes(settings);
+    AssertSameAsFloydWarshall(settings);
+  }
+
+  for (unsigned seed = 1; seed <= 3; ++seed) {
+    TransportCatalogue tc;
+    FillRandomCatalogue(tc, seed);
+    auto settings = GetTestRouterSettings(RouterEngine::DIJKSTRA);
+    const Router expected_router{settings, tc};
+    settings.graph_model = GraphModel::WAIT_FREE;
+    const Router router{settings, tc};
+    ASSERT(router.GetStopGraphEdgeCount() <
+           expected_router.GetStopGraphEdgeCount());
+    RouteProfile profile;
+    profile.bus_velocity = 45;
+    profile.bus_wait_time = 5;
+    for (const Stop *from : tc.GetStops()) {
+      for (const Stop *to : tc.GetStops()) {
+        const string hint = "seed "s + to_string(seed) + " "s + from->name +
+                            "->"s + to->name;
+        for (const RouteProfile &route_profile : {RouteProfile{}, profile}) {
+          auto expected =
+              expected_router.CalcRoute(from->name, to->name, route_profile);
+          auto actual = router.CalcRoute(from->name, to->name, route_profile);
+          ASSERT_EQUAL_HINT(actual.has_value(), expected.has_value(), hint);
+          if (expected) {
+            ASSERT_EQUAL_HINT(actual->time, expected->time, hint);
+            AssertConsistent(*actual, hint);
+          }
+        }
+      }
+    }
+  }
+}
+
+void TestPrunedBusEdges() {
+  for (RouterEngine engine : ALL_ENGINES) {
+    auto settings = GetTestRouterSettings(engine);
+    settings.prune_bus_edges = true;
+    TestSmallCatalogueRoutes(settings);
+    AssertSameAsFloydWarshall(settings);
+  }
+
+  // "4" едет как "1", но от B до C быстрее через G
+  TransportCatalogue tc;
+  FillSmallCatalogue(tc);
+  tc.AddStop("G"s, {55.66, 37.26});
+  tc.SetDistance("B"s, "G"s, 500);
+  tc.SetDistance("G"s, "C"s, 500);
+  tc.AddBus("4"s, RouteType::LINEAR, {"A"s, "B"s, "G"s, "C"s});
+  auto settings = GetTestRouterSettings(RouterEngine::DIJKSTRA);
+  Router full_router{settings, tc};
+  settings.prune_bus_edges = true;
+  Router pruned_router{settings, tc};
+  ASSERT(pruned_router.GetStopGraphEdgeCount() <
+         full_router.GetStopGraphEdgeCount());
+
+  // A - B одинаково по времени у обоих автобусов, остаётся ребро "1"
+  auto route = pruned_router.CalcRoute("A"sv, "B"sv);
+  ASSERT(route);
+  ASSERT_EQUAL(DescribeSteps(*route),
+               (vector<string>{"Wait A 2"s, "Bus 1 1 2"s}));
+  route = pruned_router.CalcRoute("A"sv, "C"sv);
+  ASSERT(route);
+  ASSERT_EQUAL(DescribeSteps(*route),
+               (vector<string>{"Wait A 2"s, "Bus 4 3 4"s}));
+  route = pruned_router.CalcRoute("C"sv, "B"sv);
+  ASSERT(route);
+  ASSERT_EQUAL(DescribeSteps(*route),
+               (vector<string>{"Wait C 2"s, "Bus 4 2 2"s}));
+}
+
+/**
+ * Граф, построенный в несколько потоков, должен совпадать с построенным в
+ * одном: те же рёбра с теми же номерами дают те же маршруты.
+ */
+void TestParallelGraphBuild() {
+  for (GraphModel graph_model :
+       {GraphModel::ALL_PAIRS, GraphModel::RIDE_CHAIN}) {
+    for (bool prune_bus_edges : {false, true}) {
+      TransportCatalogue tc;
+      FillRandomCatalogue(tc, 7, 40, 30);
+      auto settings = GetTestRouterSettings(RouterEngine::DIJKSTRA);
+      settings.graph_model = graph_model;
+      settings.prune_bus_edges = prune_bus_edges;
+      Router serial_router{settings, tc};
+      settings.router_threads = 4;
+      Router parallel_router{settings, tc};
+      ASSERT_EQUAL(parallel_router.GetStopGraphEdgeCount(),
+                   serial_router.GetStopGraphEdgeCount());
+      for (const Stop *from : tc.GetStops()) {
+        for (const Stop *to : tc.GetStops()) {
+          const string hint = from->name + "->"s + to->name;
+          auto expected = serial_router.CalcRoute(from->name, to->name);
+          auto actual = parallel_router.CalcRoute(from->name, to->name);
+          ASSERT_EQUAL_HINT(actual.has_value(), expected.has_value(), hint);
+          if (expected) {
+            ASSERT_EQUAL_HINT(actual->time, expected->time, hint);
+            ASSERT_EQUAL_HINT(DescribeSteps(*actual), DescribeSteps(*expected),
+                              hint);
+          }
+        }
+      }
+    }
+  }
+}
+
+/**
+ * Сравнивает маршруты двух роутеров между всеми парами остановок.
+ */
+void AssertSameRoutes(const TransportCatalogue &tc, const Router &expected,
+                      const Router &actual) {
+  for (const Stop *from : tc.GetStops()) {
+    for (const Stop *to : tc.GetStops()) {
+      const string hint = from->name + "->"s + to->name;
+      auto expected_route = expected.CalcRoute(from->name, to->name);
+      auto actual_route = actual.CalcRoute(from->name, to->name);
+      ASSERT_EQUAL_HINT(actual_route.has_value(), expected_route.has_value(),
+                        hint);
+      if (expected_route) {
+        ASSERT_EQUAL_HINT(actual_route->time, expected_route->time, hint);
+        ASSERT_EQUAL_HINT(DescribeSteps(*actual_route),
+                          DescribeSteps(*expected_route), hint);
+      }
+    }
+  }
+}
+
+void TestRouterFile() {
+  const string path =
+      (filesystem::temp_directory_path() / "transport_router_test.bin"s)
+          .string();
+  for (RouterEngine engine :
+       {RouterEngine::FLOYD_WARSHALL, RouterEngine::DIJKSTRA}) {
+    for (GraphModel graph_model :
+         {GraphModel::ALL_PAIRS, GraphModel::RIDE_CHAIN,
+          GraphModel::WAIT_FREE}) {
+      filesystem::remove(path);
+      TransportCatalogue tc;
+      FillRandomCatalogue(tc, 3);
+      auto settings = GetTestRouterSettings(engine);
+      settings.graph_model = graph_model;
+      const Router expected{settings, tc};
+      settings.cache_file = path;
+
+      const Router built{settings, tc};
+      ASSERT(!built.IsLoadedFromFile());
+      ASSERT(filesystem::exists(path));
+      const Router loaded{settings, tc};
+      ASSERT(loaded.IsLoadedFromFile());
+      ASSERT_EQUAL(loaded.GetStopGraphEdgeCount(),
+                   expected.GetStopGraphEdgeCount());
+      AssertSameRoutes(tc, expected, loaded);
+    }
+  }
+
+  TransportCatalogue tc;
+  FillRandomCatalogue(tc, 3);
+  auto settings = GetTestRouterSettings(RouterEngine::FLOYD_WARSHALL);
+  settings.cache_file = path;
+  {
+    // файл от другого справочника не подходит и перезаписывается
+    TransportCatalogue other_tc;
+    FillRandomCatalogue(other_tc, 4);
+    const Router other{settings, other_tc};
+    ASSERT(!Router(settings, tc).IsLoadedFromFile());
+    ASSERT(Router(settings, tc).IsLoadedFromFile());
+  }
+  {
+    auto other_settings = settings;
+    other_settings.bus_velocity = 40;
+    ASSERT(!Router(other_settings, tc).IsLoadedFromFile());
+    ASSERT(!Router(settings, tc).IsLoadedFromFile());
+  }
+  {
+    // обрезанный файл
+    const auto size = filesystem::file_size(path);
+    filesystem::resize_file(path, size / 2);
+    const Router router{settings, tc};
+    ASSERT(!router.IsLoadedFromFile());
+    ASSERT_EQUAL(filesystem::file_size(path), size);
+  }
+  {
+    const Router raptor{GetTestRouterSettings(RouterEngine::RAPTOR), tc};
+    ASSERT_THROWS(raptor.SaveToFile(path), logic_error);
+  }
+  {
+    // файл в несуществующем каталоге не записать, но роутер всё равно
+    // строится
+    auto unwritable_settings = settings;
+    unwritable_settings.cache_file =
+        (filesystem::temp_directory_path() / "no_such_directory"s /
+         "transport_router_test.bin"s)
+            .string();
+    const Router router{unwritable_settings, tc};
+    ASSERT(!router.IsLoadedFromFile());
+    ASSERT(!filesystem::exists(unwritable_settings.cache_file));
+    AssertSameRoutes(tc, Router{GetTestRouterSettings(
+                                    RouterEngine::FLOYD_WARSHALL),
+                                tc},
+                     router);
+    ASSERT_THROWS(router.SaveToFile(unwritable_settings.cache_file),
+                  runtime_error);
+  }
+  {
+    // с кэшем деревьев таблица Флойда-Уоршелла не строится и в файл не
+    // пишется: он такой же, как у Дейкстры
+    auto dijkstra_settings = GetTestRouterSettings(RouterEngine::DIJKSTRA);
+    dijkstra_settings.cache_file = path;
+    filesystem::remove(path);
+    const Router dijkstra{dijkstra_settings, tc};
+    const auto dijkstra_size = filesystem::file_size(path);
+
+    auto cached_settings = settings;
+    cached_settings.tree_cache_size = 4;
+    filesystem::remove(path);
+    const Router cached{cached_settings, tc};
+    ASSERT_EQUAL(filesystem::file_size(path), dijkstra_size);
+    const Router loaded{cached_settings, tc};
+    ASSERT(loaded.IsLoadedFromFile());
+    AssertSameRoutes(tc, dijkstra, cached);
+    AssertSameRoutes(tc, dijkstra, loaded);
+
+    // таблица с файлом без неё не загружается
+    ASSERT(!Router(settings, tc).IsLoadedFromFile());
+    ASSERT(filesystem::file_size(path) > dijkstra_size);
+  }
+  filesystem::remove(path);
+}
+
+/**
+ * Сравнивает время маршрутов двух роутеров между всеми парами остановок:
+ * среди равноценных маршрутов роутеры могут выбрать разные.
+ */
+void AssertSameRouteTimes(const TransportCatalogue &tc, const Router &expected,
+                          const Router &actual, const string &hint) {
+  for (const Stop *from : tc.GetStops()) {
+    for (const Stop *to : tc.GetStops()) {
+      const string pair_hint = hint + " "s + from->name + "->"s + to->name;
+      auto expected_route = expected.CalcRoute(from->name, to->name);
+      auto actual_route = actual.CalcRoute(from->name, to->name);
+      ASSERT_EQUAL_HINT(actual_route.has_value(), expected_route.has_value(),
+                        pair_hint);
+      if (expected_route && expected_route->time > 0) {
+        ASSERT_SOFT_EQUAL_HINT(actual_route->time, expected_route->time,
+                               pair_hint);
+        AssertConsistent(*actual_route, pair_hint);
+      }
+    }
+  }
+}
+
+/**
+ * Роутер после `Update` должен отвечать так же, как построенный заново.
+ */
+void TestRouterUpdate() {
+  for (RouterEngine engine :
+       {RouterEngine::FLOYD_WARSHALL, RouterEngine::DIJKSTRA,
+        RouterEngine::CONTRACTION_HIERARCHY, RouterEngine::RAPTOR}) {
+    for (GraphModel graph_model :
+         {GraphModel::ALL_PAIRS, GraphModel::RIDE_CHAIN,
+          GraphModel::WAIT_FREE}) {
+      const string hint = "engine "s + to_string(engine) + " model "s +
+                          to_string(graph_model);
+      TransportCatalogue tc;
+      FillRandomCatalogue(tc, 5);
+      auto settings = GetTestRouterSettings(engine);
+      settings.graph_model = graph_model;
+      Router router{settings, tc};
+
+      // одно расстояние растёт, другое падает
+      for (const Bus *bus : tc.GetBuses()) {
+        if (bus->stops.size() > 1) {
+          const auto &stops = bus->stops;
+          tc.ChangeDistance(stops[0]->name, stops[1]->name, 9000);
+          tc.ChangeDistance(stops[1]->name, stops[0]->name, 9000);
+          tc.ChangeDistance(stops.back()->name, stops.front()->name, 100);
+          break;
+        }
+      }
+      router.Update();
+      AssertSameRouteTimes(tc, Router{settings, tc}, router,
+                           hint + " distances"s);
+
+      tc.AddBus("New"s, RouteType::LINEAR, {"S1"s, "S2"s, "S3"s});
+      router.Update();
+      AssertSameRouteTimes(tc, Router{settings, tc}, router, hint + " bus"s);
+
+      tc.AddStop("Far"s, {55.7, 37.3});
+      tc.AddBus("ToFar"s, RouteType::LINEAR, {"S4"s, "Far"s});
+      router.Update();
+      AssertSameRouteTimes(tc, Router{settings, tc}, router, hint + " stop"s);
+    }
+  }
+}
+
+/**
+ * Таблица только между пересадочными остановками должна давать те же
+ * времена маршрутов, что и полная: в том числе между остановками одного
+ * автобуса и через пересадочные остановки, которые автобус проезжает.
+ */
+void TestTransferStops() {
+  auto settings = GetTestRouterSettings(RouterEngine::FLOYD_WARSHALL);
+  settings.reduce_to_transfer_stops = true;
+  TestSmallCatalogueRoutes(settings);
+  AssertSameAsFloydWarshall(settings);
+  for (unsigned seed = 1; seed <= 3; ++seed) {
+    TransportCatalogue tc;
+    FillRandomCatalogue(tc, seed, 60, 10);
+    const string hint = "seed "s + to_string(seed);
+    const Router expected{GetTestRouterSettings(RouterEngine::FLOYD_WARSHALL),
+                          tc};
+    AssertSameRouteTimes(tc, expected, Router{settings, tc}, hint);
+    auto pruned_settings = settings;
+    pruned_settings.prune_bus_edges = true;
+    AssertSameRouteTimes(tc, expected, Router{pruned_settings, tc},
+                         hint + " pruned"s);
+  }
+
+  // таблица не записывается в файл и считается заново после загрузки
+  const string path =
+      (filesystem::temp_directory_path() / "transport_router_test.bin"s)
+          .string();
+  filesystem::remove(path);
+  TransportCatalogue tc;
+  FillRandomCatalogue(tc, 5);
+  auto file_settings = settings;
+  file_settings.cache_file = path;
+  const Router built{file_settings, tc};
+  const Router loaded{file_settings, tc};
+  ASSERT(loaded.IsLoadedFromFile());
+  AssertSameRoutes(tc, built, loaded);
+  filesystem::remove(path);
+
+  Router router{settings, tc};
+  tc.AddStop("Far"s, {55.7, 37.3});
+  tc.AddBus("ToFar"s, RouteType::LINEAR, {"S1"s, "S2"s, "Far"s});
+  router.Update();
+  AssertSameRouteTimes(
+      tc, Router{GetTestRouterSettings(RouterEngine::FLOYD_WARSHALL), tc},
+      router, "update"s);
+}
+
+/**
+ * Перенумерация вершин не должна менять ни времена маршрутов, ни изохроны,
+ * в том числе после загрузки из файла.
+ */
+void TestVertexReordering() {
+  for (RouterEngine engine : ALL_ENGINES) {
+    for (GraphModel graph_model :
+         {GraphModel::ALL_PAIRS, GraphModel::RIDE_CHAIN,
+          GraphModel::WAIT_FREE}) {
+      const string hint = "engine "s + to_string(engine) + " model "s +
+                          to_string(graph_model);
+      TransportCatalogue tc;
+      FillRandomCatalogue(tc, 6);
+      auto settings = GetTestRouterSettings(engine);
+      settings.graph_model = graph_model;
+      const Router expected{settings, tc};
+      settings.reorder_vertices = true;
+      const Router reordered{settings, tc};
+      AssertSameRouteTimes(tc, expected, reordered, hint);
+      for (const Stop *from : tc.GetStops()) {
+        const auto expected_isochrone = expected.CalcIsochrone(from->name, 900);
+        const auto isochrone = reordered.CalcIsochrone(from->name, 900);
+        ASSERT_EQUAL_HINT(isochrone->stops.size(),
+                          expected_isochrone->stops.size(), hint);
+      }
+    }
+  }
+
+  TransportCatalogue tc;
+  FillRandomCatalogue(tc, 7, 60, 10);
+  auto settings = GetTestRouterSettings(RouterEngine::FLOYD_WARSHALL);
+  const Router expected{settings, tc};
+  settings.reorder_vertices = true;
+  settings.reduce_to_transfer_stops = true;
+  AssertSameRouteTimes(tc, expected, Router{settings, tc}, "transfer stops"s);
+
+  const string path =
+      (filesystem::temp_directory_path() / "transport_router_test.bin"s)
+          .string();
+  filesystem::remove(path);
+  settings.reduce_to_transfer_stops = false;
+  settings.cache_file = path;
+  const Router built{settings, tc};
+  const Router loaded{settings, tc};
+  ASSERT(loaded.IsLoadedFromFile());
+  AssertSameRoutes(tc, built, loaded);
+  filesystem::remove(path);
+}
+
+/**
+ * Маршрут с переопределёнными скоростью и временем ожидания должен совпадать
+ * с маршрутом роутера, построенного с такими настройками.
+ */
+void TestRouteProfiles() {
+  for (RouterEngine engine :
+       {RouterEngine::FLOYD_WARSHALL, RouterEngine::CONTRACTION_HIERARCHY,
+        RouterEngine::RAPTOR}) {
+    for (GraphModel graph_model :
+         {GraphModel::ALL_PAIRS, GraphModel::RIDE_CHAIN,
+          GraphModel::WAIT_FREE}) {
+      TransportCatalogue tc;
+      FillRandomCatalogue(tc, 6);
+      auto settings = GetTestRouterSettings(engine);
+      settings.graph_model = graph_model;
+      const Router router{settings, tc};
+      for (const auto &profile :
+           {RouteProfile{45.0, 5.0}, RouteProfile{20.0, nullopt},
+            RouteProfile{nullopt, 0.0}}) {
+        auto profile_settings = settings;
+        profile_settings.bus_velocity =
+            profile.bus_velocity.value_or(settings.bus_velocity);
+        profile_settings.bus_wait_time =
+            profile.bus_wait_time.value_or(settings.bus_wait_time);
+        const Router expected{profile_settings, tc};
+        for (const Stop *from : tc.GetStops()) {
+          for (const Stop *to : tc.GetStops()) {
+            const string hint =
+                "engine "s + to_string(engine) + " model "s +
+                to_string(graph_model) + " velocity "s +
+                to_string(profile_settings.bus_velocity) + " wait "s +
+                to_string(profile_settings.bus_wait_time) + " "s +
+                from->name + "->"s + to->name;
+            auto expected_route = expected.CalcRoute(from->name, to->name);
+            auto actual_route = router.CalcRoute(from->name, to->name, profile);
+            ASSERT_EQUAL_HINT(actual_route.has_value(),
+                              expected_route.has_value(), hint);
+            if (expected_route && expected_route->time > 0) {
+              ASSERT_SOFT_EQUAL_HINT(actual_route->time, expected_route->time,
+                                     hint);
+              AssertConsistent(*actual_route, hint);
+            }
+          }
+        }
+      }
+    }
+  }
+
+  TransportCatalogue tc;
+  FillSmallCatalogue(tc);
+  const Router router{GetTestRouterSettings(RouterEngine::DIJKSTRA), tc};
+  // без переопределений маршрут тот же
+  auto route = router.CalcRoute("A"sv, "D"sv, RouteProfile{});
+  ASSERT(route);
+  ASSERT_SOFT_EQUAL(route->time, 12.0 * 60);
+  // вдвое быстрее и без ожидания
+  route = router.CalcRoute("A"sv, "D"sv, RouteProfile{60.0, 0.0});
+  ASSERT(route);
+  ASSERT_SOFT_EQUAL(route->time, 4.0 * 60);
+  ASSERT_EQUAL(DescribeSteps(*route),
+               (vector<string>{"Wait A 0"s, "Bus 1 1 1"s, "Wait B 0"s,
+                               "Bus 3 1 3"s}));
+  ASSERT_THROWS(router.CalcRoute("A"sv, "D"sv, RouteProfile{0.0, nullopt}),
+                invalid_argument);
+  ASSERT_THROWS(router.CalcRoute("A"sv, "D"sv, RouteProfile{nullopt, -1.0}),
+                invalid_argument);
+  ASSERT_EQUAL(router.GetProfileCacheStats().size, 1u);
+
+  // кэш профилей ограничен и вытесняет давно не использованный
+  auto settings = GetTestRouterSettings(RouterEngine::DIJKSTRA);
+  settings.profile_cache_size = 2;
+  const Router cached{settings, tc};
+  const RouteProfile fast{60.0, 0.0};
+  const RouteProfile slow{15.0, nullopt};
+  const RouteProfile patient{nullopt, 10.0};
+  cached.CalcRoute("A"sv, "D"sv, fast);
+  cached.CalcRoute("A"sv, "D"sv, slow);
+  cached.CalcRoute("A"sv, "D"sv, fast);
+  cached.CalcRoute("A"sv, "D"sv, patient);
+  auto stats = cached.GetProfileCacheStats();
+  ASSERT_EQUAL(stats.size, 2u);
+  ASSERT_EQUAL(stats.hits, 1u);
+  ASSERT_EQUAL(stats.misses, 3u);
+  ASSERT_EQUAL(stats.evictions, 1u);
+  // fast использовался позже slow, поэтому вытеснен slow
+  route = cached.CalcRoute("A"sv, "D"sv, fast);
+  ASSERT(route);
+  ASSERT_SOFT_EQUAL(route->time, 4.0 * 60);
+  ASSERT_EQUAL(cached.GetProfileCacheStats().hits, 2u);
+  route = cached.CalcRoute("A"sv, "D"sv, slow);
+  ASSERT(route);
+  ASSERT_SOFT_EQUAL(route->time, 20.0 * 60);
+  stats = cached.GetProfileCacheStats();
+  ASSERT_EQUAL(stats.size, 2u);
+  ASSERT_EQUAL(stats.misses, 4u);
+  ASSERT_EQUAL(stats.evictions, 2u);
+
+  // без кэша хранится только последний профиль
+  settings.profile_cache_size = 0;
+  const Router uncached{settings, tc};
+  uncached.CalcRoute("A"sv, "D"sv, fast);
+  uncached.CalcRoute("A"sv, "D"sv, fast);
+  uncached.CalcRoute("A"sv, "D"sv, slow);
+  stats = uncached.GetProfileCacheStats();
+  ASSERT_EQUAL(stats.size, 1u);
+  ASSERT_EQUAL(stats.hits, 1u);
+  ASSERT_EQUAL(stats.evictions, 1u);
+}
+
+/**
+ * Статистика меток доступна только с движком на метках-хабах.
+ */
+void TestHubLabelStats() {
+  TransportCatalogue tc;
+  FillRandomCatalogue(tc, 2);
+  auto settings = GetTestRouterSettings(RouterEngine::HUB_LABELS);
+  Router router{settings, tc};
+  auto stats = router.GetHubLabelStats();
+  ASSERT(stats);
+  // у каждой остановки хотя бы одна вершина, и в обеих её метках есть
+  // запись о ней самой
+  ASSERT(stats->label_entry_count >= 2 * tc.GetStops().size());
+  ASSERT(stats->max_label_size >= 1);
+  ASSERT(stats->build_time.count() >= 0);
+
+  tc.AddStop("Extra"s, {55.7, 37.3});
+  router.Update();
+  ASSERT(router.GetHubLabelStats());
+
+  ASSERT(!Router(GetTestRouterSettings(RouterEngine::DIJKSTRA), tc)
+              .GetHubLabelStats());
+  ASSERT(!Router(GetTestRouterSettings(RouterEngine::RAPTOR), tc)
+              .GetHubLabelStats());
+  settings.tree_cache_size = 2;
+  ASSERT(!Router(settings, tc).GetHubLabelStats());
+}
+
+/**
+ * Изохрона совпадает с остановками, маршрут до которых не дольше бюджета.
+ */
+void TestIsochrone() {
+  for (RouterEngine engine : ALL_ENGINES) {
+    const string engine_hint = "engine "s + to_string(engine);
+    {
+      TransportCatalogue tc;
+      FillSmallCatalogue(tc);
+      const Router router{GetTestRouterSettings(engine), tc};
+      auto isochrone = router.CalcIsochrone("A"sv, 7.0 * 60);
+      ASSERT_HINT(isochrone, engine_hint);
+      vector<string> stops;
+      for (const auto &stop : isochrone->stops) {
+        ostringstream out;
+        out << stop.stop_name << ' ' << stop.time / 60;
+        stops.push_back(out.str());
+      }
+      ASSERT_EQUAL_HINT(stops, (vector<string>{"A 0"s, "B 4"s, "C 7"s}),
+                        engine_hint);
+      ASSERT_HINT(!router.CalcIsochrone("Z"sv, 60), engine_hint);
+      ASSERT_THROWS(router.CalcIsochrone("A"sv, -1), invalid_argument);
+    }
+    TransportCatalogue tc;
+    FillRandomCatalogue(tc, 7);
+    const Router router{GetTestRouterSettings(engine), tc};
+    for (const Stop *from : tc.GetStops()) {
+      const double max_time = 15.0 * 60;
+      auto isochrone = router.CalcIsochrone(from->name, max_time);
+      ASSERT(isochrone);
+      size_t reachable_count = 0;
+      for (const Stop *to : tc.GetStops()) {
+        const string hint = engine_hint + " "s + from->name + "->"s + to->name;
+        auto route = router.CalcRoute(from->name, to->name);
+        if (!route || route->time > max_time) {
+          continue;
+        }
+        ++reachable_count;
+        auto it = find_if(isochrone->stops.begin(), isochrone->stops.end(),
+                          [&](const ReachableStop &stop) {
+                            return stop.stop_name == to->name;
+                          });
+        ASSERT_HINT(it != isochrone->stops.end(), hint);
+        if (route->time == 0) {
+          ASSERT_EQUAL_HINT(it->time, 0.0, hint);
+        } else {
+          ASSERT_SOFT_EQUAL_HINT(it->time, route->time, hint);
+        }
+      }
+      ASSERT_EQUAL(isochrone->stops.size(), reachable_count);
+    }
+  }
+}
+
+/**
+ * RAPTOR не строит граф остановок, поэтому длинные маршруты ему не страшны.
+ * Линия из 300 остановок через каждые 500 метров и пересекающее её кольцо.
+ */
+void TestRaptorLongLines() {
+  TransportCatalogue tc;
+  vector<string> line;
+  for (size_t i = 0; i < 300; ++i) {
+    line.push_back("L"s + to_string(i));
+    tc.AddStop(line.back(), {55.6 + i * 0.001, 37.2});
+  }
+  tc.AddStop("R"s, {55.7, 37.3});
+  for (size_t i = 0; i + 1 < line.size(); ++i) {
+    tc.SetDistance(line[i], line[i + 1], 500);
+  }
+  tc.SetDistance(line[10], "R"s, 1000);
+  tc.SetDistance("R"s, line[250], 1000);
+  tc.SetDistance(line[250], line[10], 1000);
+  tc.AddBus("line"s, RouteType::LINEAR, line);
+  tc.AddBus("ring"s, RouteType::CIRCULAR,
+            {line[10], "R"s, line[250], line[10]});
+
+  Router router{GetTestRouterSettings(RouterEngine::RAPTOR), tc};
+  auto route = router.CalcRoute("L100"sv, "L200"sv);
+  ASSERT(route);
+  ASSERT_SOFT_EQUAL(route->time, (2.0 + 100) * 60);
+  ASSERT_EQUAL(DescribeSteps(*route),
+               (vector<string>{"Wait L100 2"s, "Bus line 100 100"s}));
+
+  // через кольцо с пересадкой быстрее, чем по линии
+  route = router.CalcRoute("L0"sv, "L260"sv);
+  ASSERT(route);
+  ASSERT_SOFT_EQUAL(route->time, (2 + 10 + 2 + 4 + 2 + 10) * 60.0);
+  ASSERT_EQUAL(DescribeSteps(*route),
+               (vector<string>{"Wait L0 2"s, "Bus line 10 10"s, "Wait L10 2"s,
+                               "Bus ring 2 4"s, "Wait L250 2"s,
+                               "Bus line 10 10"s}));
+
+  // обратно по линии и через конечную кольца
+  route = router.CalcRoute("L299"sv, "L10"sv);
+  ASSERT(route);
+  ASSERT_SOFT_EQUAL(route->time, (2 + 49 + 2 + 2) * 60.0);
+  ASSERT_EQUAL(DescribeSteps(*route),
+               (vector<string>{"Wait L299 2"s, "Bus line 49 49"s,
+                               "Wait L250 2"s, "Bus ring 1 2"s}));
+
+  AssertMatrixMatchesRoutes(router, {"L0"sv, "R"sv, "L299"sv},
+                            {"L5"sv, "R"sv, "L260"sv, "L0"sv}, "raptor"s);
+}
+
+/**
+ * Маршруты по расписанию на небольшом справочнике. Рейсы:
+ *  - "1" (A - B - C - B - A): в 8:00 и 8:20, от A до C 10 минут;
+ *  - "2" (C - D - E - C): в 8:12, до D 3 минуты;
+ *  - "3" (B - D - B): в 8:05, до D 20 минут.
+ */
+void TestTimetableRoutes() {
+  TransportCatalogue tc;
+  FillSmallCatalogue(tc);
+  tc.AddTrip("1"sv, {480, 484, 490, 496, 500});
+  tc.AddTrip("1"sv, {500, 504, 510, 516, 520});
+  tc.AddTrip("2"sv, {492, 495, 497, 499});
+  tc.AddTrip("3"sv, {485, 505, 525});
+  Router router{GetTestRouterSettings(RouterEngine::DIJKSTRA), tc};
+
+  // прямой рейс, ждём на A до отправления
+  auto route = router.CalcTimetableRoute("A"sv, "C"sv, 475);
+  ASSERT(route);
+  ASSERT_SOFT_EQUAL(route->time, 15.0 * 60);
+  ASSERT_EQUAL(DescribeSteps(*route),
+               (vector<string>{"Wait A 5"s, "Bus 1 2 10"s}));
+
+  // пересадка на C на "2" быстрее, чем рейс "3" с B
+  route = router.CalcTimetableRoute("A"sv, "D"sv, 480);
+  ASSERT(route);
+  ASSERT_SOFT_EQUAL(route->time, 15.0 * 60);
+  ASSERT_EQUAL(DescribeSteps(*route),
+               (vector<string>{"Wait A 0"s, "Bus 1 2 10"s, "Wait C 2"s,
+                               "Bus 2 1 3"s}));
+
+  // первый рейс ушёл, ждём второй
+  route = router.CalcTimetableRoute("A"sv, "B"sv, 481);
+  ASSERT(route);
+  ASSERT_SOFT_EQUAL(route->time, 23.0 * 60);
+
+  // обратно тем же рейсом "1"
+  route = router.CalcTimetableRoute("C"sv, "A"sv, 490);
+  ASSERT(route);
+  ASSERT_EQUAL(DescribeSteps(*route),
+               (vector<string>{"Wait C 0"s, "Bus 1 2 10"s}));
+
+  route = router.CalcTimetableRoute("B"sv, "B"sv, 600);
+  ASSERT(route);
+  ASSERT_EQUAL(route->time, 0.0);
+  ASSERT(route->steps.empty());
+
+  // после последнего рейса уехать нельзя
+  ASSERT(!router.CalcTimetableRoute("A"sv, "C"sv, 501));
+  ASSERT(!router.CalcTimetableRoute("A"sv, "F"sv, 480));
+  ASSERT(!router.CalcTimetableRoute("A"sv, "Z"sv, 480));
+
+  // без расписания маршрутов по нему нет
+  TransportCatalogue no_trips;
+  FillSmallCatalogue(no_trips);
+  Router no_trips_router{GetTestRouterSettings(RouterEngine::DIJKSTRA),
+                         no_trips};
+  ASSERT(!no_trips_router.CalcTimetableRoute("A"sv, "C"sv, 480));
+}
+
+}  // namespace transport_catalogue::router::tests
+
+void TestTransportRouter(TestRunner &tr) {
+  using namespace transport_catalogue::router::tests;
+
+  RUN_TEST(tr, TestEngines);
+  RUN_TEST(tr, TestRideChainGraphModel);
+  RUN_TEST(tr, TestWaitFreeGraphModel);
+  RUN_TEST(tr, TestPrunedBusEdges);
+  RUN_TEST(tr, TestParallelGraphBuild);
+  RUN_TEST(tr, TestRouterFile);
+  RUN_TEST(tr, TestRouterUpdate);
+  RUN_TEST(tr, TestTransferStops);
+  RUN_TEST(tr, TestVertexReordering);
+  RUN_TEST(tr, TestRouteProfiles);
+  RUN_TEST(tr, TestHubLabelStats);
+  RUN_TEST(tr, TestIsochrone);
+  RUN_TEST(tr, TestDisjointNetworks);
+  RUN_TEST(tr, TestTreeCache);
+  RUN_TEST(tr, TestRouteMatrix);
+  RUN_TEST(tr, TestRaptorLongLines);
+  RUN_TEST(tr, TestTimetableRoutes);
+}
@@ -0,0 +1,5 @@
+#pragma once
+
+class TestRunner;
+
+void TestTransportRouter(TestRunner &tr);
@@ -0,0 +1,321 @@
+#pragma once
+
+#include <algorithm>
+#include <cstdint>
+#include <functional>
+#include <limits>
+#include <optional>
+#include <queue>
+#include <stdexcept>
+#include <tuple>
+#include <utility>
+#include <vector>
+
+#include "graph.h"
+#include "router.h"
+
+namespace graph {
+
+/**
+ * Движок A*: поиск Дейкстры, в котором вершины обрабатываются в порядке
+ * "пройденный вес + нижняя оценка оставшегося пути до цели". Хорошая оценка
+ * направляет поиск к цели, и обработанных вершин становится гораздо меньше.
+ *
+ * Оценка (потенциал) передаётся снаружи. Она не должна превышать вес
+ * кратчайшего пути до цели, иначе маршрут может оказаться не кратчайшим.
+ * Согласованность оценки не требуется: вершина, до которой нашёлся путь
+ * короче, обрабатывается повторно. Если потенциал вернул `std::nullopt`,
+ * из вершины цель недостижима, и вершина отбрасывается.
+ *
+ * Буферы поиска переиспользуются между запросами, поэтому `BuildRoute` нельзя
+ * вызывать одновременно из нескольких потоков.
+ */
+template <typename Weight, typename Graph = DirectedWeightedGraph<Weight>>
+class AStarRouter final : public AbstractRouter<Weight> {
+ public:
+  using typename AbstractRouter<Weight>::RouteInfo;
+  using Potential =
+      std::function<std::optional<Weight>(VertexId vertex, VertexId target)>;
+
+  AStarRouter(const Graph &graph, Potential potential);
+
+  std::optional<RouteInfo> BuildRoute(VertexId from,
+                                      VertexId to) const override;
+
+ private:
+  // ключ очереди, пройденный вес и вершина
+  using QueueItem = std::tuple<Weight, Weight, VertexId>;
+
+  struct VertexState {
+    Weight weight{};
+    std::optional<EdgeId> prev_edge;
+    uint32_t generation = 0;
+  };
+
+  static constexpr Weight ZERO_WEIGHT{};
+  const Graph &graph_;
+  Potential potential_;
+  mutable std::vector<VertexState> states_;
+  mutable uint32_t generation_ = 0;
+
+  void StartSearch() const;
+};
+
+template <typename Weight, typename Graph>
+AStarRouter<Weight, Graph>::AStarRouter(const Graph &graph, Potential potential)
+    : graph_(graph),
+      potential_(std::move(potential)),
+      states_(graph.GetVertexCount()) {
+  for (EdgeId edge_id = 0; edge_id < graph.GetEdgeCount(); ++edge_id) {
+    if (graph.GetEdge(edge_id).weight < ZERO_WEIGHT) {
+      throw std::domain_error("Edges' weights should be non-negative");
+    }
+  }
+}
+
+template <typename Weight, typename Graph>
+void AStarRouter<Weight, Graph>::StartSearch() const {
+  ++generation_;
+  if (generation_ == 0) {
+    for (auto &state : states_) {
+      state.generation = 0;
+    }
+    generation_ = 1;
+  }
+}
+
+template <typename Weight, typename Graph>
+std::optional<typename AStarRouter<Weight, Graph>::RouteInfo>
+AStarRouter<Weight, Graph>::BuildRoute(VertexId from, VertexId to) const {
+  if (from >= states_.size() || to >= states_.size()) {
+    throw std::out_of_range("vertex id is out of range");
+  }
+  StartSearch();
+
+  const auto from_potential = potential_(from, to);
+  if (!from_potential) {
+    return std::nullopt;
+  }
+  std::priority_queue<QueueItem, std::vector<QueueItem>, std::greater<>> queue;
+  states_[from] = {ZERO_WEIGHT, std::nullopt, generation_};
+  queue.emplace(*from_potential, ZERO_WEIGHT, from);
+
+  bool found = false;
+  while (!queue.empty()) {
+    const auto [key, weight, vertex] = queue.top();
+    queue.pop();
+    if (weight > states_[vertex].weight) {
+      continue;
+    }
+    if (vertex == to) {
+      found = true;
+      break;
+    }
+    for (const EdgeId edge_id : graph_.GetIncidentEdges(vertex)) {
+      const auto &edge = graph_.GetEdge(edge_id);
+      const Weight candidate_weight = weight + edge.weight;
+      auto &state = states_[edge.to];
+      if (state.generation == generation_ &&
+          !(candidate_weight < state.weight)) {
+        continue;
+      }
+      const auto potential = potential_(edge.to, to);
+      if (!potential) {
+        continue;
+      }
+      state = {candidate_weight, edge_id, generation_};
+      queue.emplace(candidate_weight + *potential, candidate_weight, edge.to);
+    }
+  }
+  if (!found) {
+    return std::nullopt;
+  }
+
+  std::vector<EdgeId> edges;
+  for (std::optional<EdgeId> edge_id = states_[to].prev_edge; edge_id;
+       edge_id = states_[graph_.GetEdge(*edge_id).from].prev_edge) {
+    edges.push_back(*edge_id);
+  }
+  std::reverse(edges.begin(), edges.end());
+
+  return RouteInfo{states_[to].weight, std::move(edges)};
+}
+
+/**
+ * Ориентиры для оценок ALT (A*, Landmarks, Triangle inequality).
+ *
+ * Для нескольких вершин-ориентиров заранее считаются кратчайшие расстояния от
+ * ориентира до всех вершин и от всех вершин до ориентира. По неравенству
+ * треугольника для любого ориентира `L`:
+ * `d(v, t) >= d(L, t) - d(L, v)` и `d(v, t) >= d(v, L) - d(t, L)`.
+ * Памяти нужно `2 * V` весов на ориентир.
+ *
+ * Ориентиры выбираются жадно: следующим берётся вершина, которую ещё не
+ * достиг ни один ориентир (так покрываются несвязные части графа), а если
+ * таких нет - самая далёкая от уже выбранных ориентиров.
+ *
+ * Для обратных поисков у графа должен быть построен индекс входящих рёбер.
+ */
+template <typename Weight, typename Graph = DirectedWeightedGraph<Weight>>
+class Landmarks {
+ public:
+  Landmarks(const Graph &graph, size_t landmark_count);
+
+  /**
+   * Нижняя оценка веса кратчайшего пути из `from` в `to`. Если по расстояниям
+   * до ориентиров видно, что пути нет, вернёт `std::nullopt`.
+   */
+  std::optional<Weight> LowerBound(VertexId from, VertexId to) const;
+
+  const std::vector<VertexId> &GetLandmarks() const { return landmarks_; }
+
+ private:
+  static constexpr Weight ZERO_WEIGHT{};
+  static constexpr Weight UNREACHABLE = std::numeric_limits<Weight>::max();
+
+  size_t vertex_count_;
+  std::vector<VertexId> landmarks_;
+  // расстояния от ориентира `i` до вершины `v` лежат в
+  // `from_landmark_[i * vertex_count_ + v]`, до ориентира - в `to_landmark_`
+  std::vector<Weight> from_landmark_;
+  std::vector<Weight> to_landmark_;
+
+  std::vector<Weight> CalcDistances(const Graph &graph, VertexId source,
+                                    bool backward) const;
+};
+
+template <typename Weight, typename Graph>
+Landmarks<Weight, Graph>::Landmarks(const Graph &graph, size_t landmark_count)
+    : vertex_count_(graph.GetVertexCount()) {
+  if (!graph.HasIncomingEdgesIndex()) {
+    throw std::invalid_argument("landmarks need the incoming edges index");
+  }
+  landmark_count = std::min(landmark_count, vertex_count_);
+  // наименьшее расстояние от вершины до уже выбранных ориентиров (в любую
+  // сторону); `UNREACHABLE`, если ни один ориентир с вершиной не связан
+  std::vector<Weight> closest(vertex_count_, UNREACHABLE);
+  std::vector<bool> is_landmark(vertex_count_, false);
+  VertexId next = 0;
+  while (landmarks_.size() < landmark_count) {
+    landmarks_.push_back(next);
+    is_landmark[next] = true;
+    auto from = CalcDistances(graph, next, false);
+    auto to = CalcDistances(graph, next, true);
+    for (VertexId vertex = 0; vertex < vertex_count_; ++vertex) {
+      closest[vertex] = std::min({closest[vertex], from[vertex], to[vertex]});
+    }
+    from_landmark_.insert(from_landmark_.end(), from.begin(), from.end());
+    to_landmark_.insert(to_landmark_.end(), to.begin(), to.end());
+
+    std::optional<VertexId> farthest;
+    for (VertexId vertex = 0; vertex < vertex_count_; ++vertex) {
+      if (is_landmark[vertex]) {
+        continue;
+      }
+      if (closest[vertex] == UNREACHABLE) {
+        farthest = vertex;
+        break;
+      }
+      if (!farthest || closest[vertex] > closest[*farthest]) {
+        farthest = vertex;
+      }
+    }
+    if (!farthest) {
+      break;
+    }
+    next = *farthest;
+  }
+}
+
+/**
+ * Кратчайшие расстояния из `source` до всех вершин, а если `backward` - от
+ * всех вершин до `source`.
+ */
+template <typename Weight, typename Graph>
+std::vector<Weight> Landmarks<Weight, Graph>::CalcDistances(
+    const Graph &graph, VertexId source, bool backward) const {
+  using QueueItem = std::pair<Weight, VertexId>;
+  std::vector<Weight> distances(vertex_count_, UNREACHABLE);
+  std::priority_queue<QueueItem, std::vector<QueueItem>, std::greater<>> queue;
+  distances[source] = ZERO_WEIGHT;
+  queue.emplace(ZERO_WEIGHT, source);
+  while (!queue.empty()) {
+    const auto [weight, vertex] = queue.top();
+    queue.pop();
+    if (weight > distances[vertex]) {
+      continue;
+    }
+    const auto edges = backward ? graph.GetIncomingEdges(vertex)
+                                : graph.GetIncidentEdges(vertex);
+    for (const EdgeId edge_id : edges) {
+      const auto &edge = graph.GetEdge(edge_id);
+      if (edge.weight < ZERO_WEIGHT) {
+        throw std::domain_error("Edges' weights should be non-negative");
+      }
+      const VertexId next = backward ? edge.from : edge.to;
+      const Weight candidate = weight + edge.weight;
+      if (candidate < distances[next]) {
+        distances[next] = candidate;
+        queue.emplace(candidate, next);
+      }
+    }
+  }
+  return distances;
+}
+
+template <typename Weight, typename Graph>
+std::optional<Weight> Landmarks<Weight, Graph>::LowerBound(VertexId from,
+                                                           VertexId to) const {
+  Weight bound = ZERO_WEIGHT;
+  for (size_t i = 0; i < landmarks_.size(); ++i) {
+    const Weight *from_landmark = &from_landmark_[i * vertex_count_];
+    const Weight *to_landmark = &to_landmark_[i * vertex_count_];
+    if (from_landmark[from] != UNREACHABLE) {
+      // из ориентира можно дойти до `from`, но не до `to`: значит, и из
+      // `from` до `to` дойти нельзя
+      if (from_landmark[to] == UNREACHABLE) {
+        return std::nullopt;
+      }
+      bound = std::max(bound, from_landmark[to] - from_landmark[from]);
+    }
+    if (to_landmark[to] != UNREACHABLE) {
+      if (to_landmark[from] == UNREACHABLE) {
+        return std::nullopt;
+      }
+      bound = std::max(bound, to_landmark[from] - to_landmark[to]);
+    }
+  }
+  return bound;
+}
+
+/**
+ * Движок ALT: A* с оценками по ориентирам.
+ */
+template <typename Weight, typename Graph = DirectedWeightedGraph<Weight>>
+class AltRouter final : public AbstractRouter<Weight> {
+ public:
+  using typename AbstractRouter<Weight>::RouteInfo;
+
+  AltRouter(const Graph &graph, size_t landmark_count)
+      : landmarks_(graph, landmark_count),
+        search_(graph, [this](VertexId vertex, VertexId target) {
+          return landmarks_.LowerBound(vertex, target);
+        }) {}
+
+  // поиск ссылается на ориентиры этого объекта
+  AltRouter(const AltRouter &) = delete;
+  AltRouter &operator=(const AltRouter &) = delete;
+
+  std::optional<RouteInfo> BuildRoute(VertexId from,
+                                      VertexId to) const override {
+    return search_.BuildRoute(from, to);
+  }
+
+  const Landmarks<Weight, Graph> &GetLandmarks() const { return landmarks_; }
+
+ private:
+  Landmarks<Weight, Graph> landmarks_;
+  AStarRouter<Weight, Graph> search_;
+};
+
+}  // namespace graph
@@ -0,0 +1,199 @@
+#pragma once
+
+#include <algorithm>
+#include <cstdint>
+#include <functional>
+#include <optional>
+#include <queue>
+#include <stdexcept>
+#include <utility>
+#include <vector>
+
+#include "graph.h"
+#include "router.h"
+
+namespace graph {
+
+/**
+ * Движок, который на каждый запрос запускает два поиска Дейкстры навстречу
+ * друг другу: прямой из `from` по исходящим рёбрам и обратный из `to` по
+ * входящим. Заранее ничего не считается, но у графа должен быть построен
+ * индекс входящих рёбер (`BuildIncomingEdgesIndex`).
+ *
+ * Поиск останавливается, когда сумма минимальных ключей двух очередей не
+ * меньше веса лучшего найденного маршрута: любой ещё не найденный маршрут
+ * прошёл бы через вершину, не обработанную ни одним из поисков, и был бы не
+ * короче этой суммы.
+ *
+ * Буферы поиска переиспользуются между запросами, поэтому `BuildRoute` нельзя
+ * вызывать одновременно из нескольких потоков.
+ */
+template <typename Weight, typename Graph = DirectedWeightedGraph<Weight>>
+class BidirectionalDijkstraRouter final : public AbstractRouter<Weight> {
+ public:
+  using typename AbstractRouter<Weight>::RouteInfo;
+
+  explicit BidirectionalDijkstraRouter(const Graph &graph);
+
+  std::optional<RouteInfo> BuildRoute(VertexId from,
+                                      VertexId to) const override;
+
+ private:
+  using QueueItem = std::pair<Weight, VertexId>;
+  using Queue =
+      std::priority_queue<QueueItem, std::vector<QueueItem>, std::greater<>>;
+
+  struct VertexState {
+    Weight weight{};
+    std::optional<EdgeId> prev_edge;
+    uint32_t generation = 0;
+  };
+
+  // направление поиска: прямой идёт по исходящим рёбрам, обратный - по
+  // входящим
+  enum Direction {
+    FORWARD,
+    BACKWARD,
+  };
+
+  static constexpr Weight ZERO_WEIGHT{};
+  const Graph &graph_;
+  mutable std::vector<VertexState> forward_states_;
+  mutable std::vector<VertexState> backward_states_;
+  mutable uint32_t generation_ = 0;
+
+  void StartSearch() const;
+  void SearchStep(Direction direction, Queue &queue,
+                  std::optional<Weight> &best_weight,
+                  std::optional<VertexId> &meeting_vertex) const;
+};
+
+template <typename Weight, typename Graph>
+BidirectionalDijkstraRouter<Weight, Graph>::BidirectionalDijkstraRouter(
+    const Graph &graph)
+    : graph_(graph),
+      forward_states_(graph.GetVertexCount()),
+      backward_states_(graph.GetVertexCount()) {
+  if (!graph.HasIncomingEdgesIndex()) {
+    throw std::invalid_argument(
+        "bidirectional search needs the incoming edges index");
+  }
+  for (EdgeId edge_id = 0; edge_id < graph.GetEdgeCount(); ++edge_id) {
+    if (graph.GetEdge(edge_id).weight < ZERO_WEIGHT) {
+      throw std::domain_error("Edges' weights should be non-negative");
+    }
+  }
+}
+
+template <typename Weight, typename Graph>
+void BidirectionalDijkstraRouter<Weight, Graph>::StartSearch() const {
+  ++generation_;
+  if (generation_ == 0) {
+    for (auto &state : forward_states_) {
+      state.generation = 0;
+    }
+    for (auto &state : backward_states_) {
+      state.generation = 0;
+    }
+    generation_ = 1;
+  }
+}
+
+/**
+ * Обрабатывает ближайшую вершину из очереди поиска в направлении `direction`.
+ * Каждая вершина, до которой дотянулись оба поиска, - кандидат в точку
+ * встречи.
+ */
+template <typename Weight, typename Graph>
+void BidirectionalDijkstraRouter<Weight, Graph>::SearchStep(
+    Direction direction, Queue &queue, std::optional<Weight> &best_weight,
+    std::optional<VertexId> &meeting_vertex) const {
+  auto &states = direction == FORWARD ? forward_states_ : backward_states_;
+  const auto &other_states =
+      direction == FORWARD ? backward_states_ : forward_states_;
+
+  const auto [weight, vertex] = queue.top();
+  queue.pop();
+  if (weight > states[vertex].weight) {
+    return;
+  }
+  const auto edges = direction == FORWARD ? graph_.GetIncidentEdges(vertex)
+                                          : graph_.GetIncomingEdges(vertex);
+  for (const EdgeId edge_id : edges) {
+    const auto &edge = graph_.GetEdge(edge_id);
+    const VertexId next = direction == FORWARD ? edge.to : edge.from;
+    const Weight candidate = weight + edge.weight;
+    auto &state = states[next];
+    if (state.generation != generation_ || candidate < state.weight) {
+      state = {candidate, edge_id, generation_};
+      queue.emplace(candidate, next);
+    }
+    if (other_states[next].generation == generation_) {
+      const Weight route_weight = state.weight + other_states[next].weight;
+      if (!best_weight || route_weight < *best_weight) {
+        best_weight = route_weight;
+        meeting_vertex = next;
+      }
+    }
+  }
+}
+
+template <typename Weight, typename Graph>
+std::optional<typename BidirectionalDijkstraRouter<Weight, Graph>::RouteInfo>
+BidirectionalDijkstraRouter<Weight, Graph>::BuildRoute(VertexId from,
+                                                        VertexId to) const {
+  if (from >= forward_states_.size() || to >= forward_states_.size()) {
+    throw std::out_of_range("vertex id is out of range");
+  }
+  StartSearch();
+
+  Queue forward_queue;
+  Queue backward_queue;
+  forward_states_[from] = {ZERO_WEIGHT, std::nullopt, generation_};
+  backward_states_[to] = {ZERO_WEIGHT, std::nullopt, generation_};
+  forward_queue.emplace(ZERO_WEIGHT, from);
+  backward_queue.emplace(ZERO_WEIGHT, to);
+
+  std::optional<Weight> best_weight;
+  std::optional<VertexId> meeting_vertex;
+  if (from == to) {
+    best_weight = ZERO_WEIGHT;
+    meeting_vertex = from;
+  }
+  while (!forward_queue.empty() && !backward_queue.empty()) {
+    if (best_weight && forward_queue.top().first +
+                               backward_queue.top().first >=
+                           *best_weight) {
+      break;
+    }
+    // расширяем тот поиск, у которого очередь меньше: так оба поиска
+    // обрабатывают примерно одинаковое число вершин
+    if (forward_queue.size() <= backward_queue.size()) {
+      SearchStep(FORWARD, forward_queue, best_weight, meeting_vertex);
+    } else {
+      SearchStep(BACKWARD, backward_queue, best_weight, meeting_vertex);
+    }
+  }
+  if (!meeting_vertex) {
+    return std::nullopt;
+  }
+
+  std::vector<EdgeId> edges;
+  for (std::optional<EdgeId> edge_id =
+           forward_states_[*meeting_vertex].prev_edge;
+       edge_id; edge_id = forward_states_[graph_.GetEdge(*edge_id).from]
+                              .prev_edge) {
+    edges.push_back(*edge_id);
+  }
+  std::reverse(edges.begin(), edges.end());
+  for (std::optional<EdgeId> edge_id =
+           backward_states_[*meeting_vertex].prev_edge;
+       edge_id;
+       edge_id = backward_states_[graph_.GetEdge(*edge_id).to].prev_edge) {
+    edges.push_back(*edge_id);
+  }
+
+  return RouteInfo{*best_weight, std::move(edges)};
+}
+
+}  // namespace graph
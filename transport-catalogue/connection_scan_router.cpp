@@ -0,0 +1,148 @@
+#include "connection_scan_router.h"
+
+#include <algorithm>
+#include <limits>
+#include <string>
+#include <tuple>
+#include <utility>
+
+#include "domain.h"
+#include "transport_catalogue.h"
+
+using namespace std;
+
+namespace transport_catalogue::router {
+
+namespace {
+
+constexpr double UNREACHABLE = numeric_limits<double>::infinity();
+constexpr size_t NO_CONNECTION = numeric_limits<size_t>::max();
+
+/**
+ * Остановки в том порядке, в каком автобус проезжает их за рейс.
+ */
+vector<const Stop *> GetTripStops(const Bus &bus) {
+  vector<const Stop *> result = bus.stops;
+  if (bus.route_type == RouteType::LINEAR) {
+    result.insert(result.end(), next(bus.stops.rbegin()), bus.stops.rend());
+  } else if (!bus.stops.empty()) {
+    result.push_back(bus.stops.front());
+  }
+  return result;
+}
+
+}  // namespace
+
+ConnectionScanRouter::ConnectionScanRouter(
+    const TransportCatalogue &transport_catalogue)
+    : stops_(transport_catalogue.GetStops()) {
+  unordered_map<const Stop *, StopIndex> index;
+  for (StopIndex i = 0; i < stops_.size(); ++i) {
+    index[stops_[i]] = i;
+    stop_by_name_[string_view{stops_[i]->name}] = i;
+  }
+
+  for (const Bus *bus : transport_catalogue.GetBuses()) {
+    if (bus->trips.empty()) {
+      continue;
+    }
+    const auto trip_stops = GetTripStops(*bus);
+    for (const Trip &trip : bus->trips) {
+      const size_t trip_id = trip_buses_.size();
+      trip_buses_.push_back(bus);
+      const auto &times = trip.departure_times;
+      for (size_t i = 0; i + 1 < trip_stops.size(); ++i) {
+        connections_.push_back({index.at(trip_stops[i]),
+                                index.at(trip_stops[i + 1]), times[i] * 60,
+                                times[i + 1] * 60, trip_id, i});
+      }
+    }
+  }
+
+  // связи одного рейса с одинаковым временем должны остаться по порядку
+  sort(connections_.begin(), connections_.end(),
+       [](const Connection &lhs, const Connection &rhs) {
+         return tie(lhs.departure, lhs.arrival, lhs.trip, lhs.position) <
+                tie(rhs.departure, rhs.arrival, rhs.trip, rhs.position);
+       });
+}
+
+optional<ConnectionScanRouter::StopIndex> ConnectionScanRouter::FindStop(
+    string_view name) const {
+  if (auto it = stop_by_name_.find(name); it != stop_by_name_.end()) {
+    return it->second;
+  }
+  return nullopt;
+}
+
+optional<RouteResult> ConnectionScanRouter::CalcRoute(
+    string_view from, string_view to, double departure_time) const {
+  auto s_from = FindStop(from);
+  auto s_to = FindStop(to);
+  if (!s_from || !s_to) {
+    return nullopt;
+  }
+  const double start = departure_time * 60;
+
+  // самое раннее прибытие на остановку и поездка, которой туда попадаем:
+  // связь, на которой сели в рейс, и связь, после которой вышли
+  vector<double> arrivals(stops_.size(), UNREACHABLE);
+  vector<pair<size_t, size_t>> legs(stops_.size(),
+                                    {NO_CONNECTION, NO_CONNECTION});
+  // связь, на которой сели в рейс
+  vector<size_t> boardings(trip_buses_.size(), NO_CONNECTION);
+  arrivals[*s_from] = start;
+
+  auto first = lower_bound(
+      connections_.begin(), connections_.end(), start,
+      [](const Connection &c, double time) { return c.departure < time; });
+  for (auto it = first; it != connections_.end(); ++it) {
+    const Connection &c = *it;
+    // ни одна связь дальше не приедет в `to` раньше
+    if (c.departure >= arrivals[*s_to]) {
+      break;
+    }
+    const size_t c_index = it - connections_.begin();
+    if (boardings[c.trip] == NO_CONNECTION &&
+        arrivals[c.from] <= c.departure) {
+      boardings[c.trip] = c_index;
+    }
+    if (boardings[c.trip] != NO_CONNECTION && c.arrival < arrivals[c.to]) {
+      arrivals[c.to] = c.arrival;
+      legs[c.to] = {boardings[c.trip], c_index};
+    }
+  }
+  if (arrivals[*s_to] == UNREACHABLE) {
+    return nullopt;
+  }
+
+  // Связь, на которой сели в рейс, всегда в массиве раньше связи, которой
+  // приехали на остановку посадки: более поздняя связь не может улучшить
+  // время прибытия на остановку, с которой уже уехали. Поэтому цепочка
+  // поездок конечна.
+  vector<pair<size_t, size_t>> route_legs;
+  for (StopIndex stop = *s_to; stop != *s_from;) {
+    route_legs.push_back(legs[stop]);
+    stop = connections_[legs[stop].first].from;
+  }
+  reverse(route_legs.begin(), route_legs.end());
+
+  RouteResult result;
+  result.time = arrivals[*s_to] - start;
+  double time = start;
+  for (const auto &[board, alight] : route_legs) {
+    const Connection &first_connection = connections_[board];
+    const Connection &last_connection = connections_[alight];
+    result.steps.push_back(
+        WaitAction{string_view{stops_[first_connection.from]->name},
+                   first_connection.departure - time});
+    result.steps.push_back(BusAction{
+        string_view{trip_buses_[first_connection.trip]->name},
+        last_connection.position - first_connection.position + 1,
+        last_connection.arrival - first_connection.departure});
+    time = last_connection.arrival;
+  }
+  return result;
+}
+
+}  // namespace transport_catalogue::router
@@ -0,0 +1,69 @@
+#pragma once
+
+#include <cstddef>
+#include <optional>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+#include "transport_router.h"
+
+namespace transport_catalogue {
+struct Stop;
+struct Bus;
+class TransportCatalogue;
+} /* namespace transport_catalogue */
+
+namespace transport_catalogue::router {
+
+/**
+ * Поиск маршрутов по расписанию алгоритмом Connection Scan (CSA).
+ *
+ * Каждый рейс каждого автобуса разбивается на перегоны между соседними
+ * остановками - "связи" с временем отправления и прибытия. Все связи один раз
+ * сортируются по времени отправления, и запрос - это один проход по массиву
+ * связей начиная с момента отправления: связь годится, если в её начальную
+ * остановку уже можно успеть к отправлению или если уже едем этим рейсом.
+ * Граф остановок не нужен, а проход по массиву хорошо ложится на кэш.
+ *
+ * Ищется самое раннее прибытие. Время ожидания в ответе - сколько на самом
+ * деле придётся ждать рейса на остановке, время поездки - по расписанию.
+ */
+class ConnectionScanRouter {
+ public:
+  explicit ConnectionScanRouter(const TransportCatalogue &transport_catalogue);
+
+  /**
+   * Маршрут из `from` в `to` с отправлением не раньше `departure_time`
+   * минут от начала суток. `RouteResult::time` - время от `departure_time`
+   * до прибытия.
+   */
+  std::optional<RouteResult> CalcRoute(std::string_view from,
+                                       std::string_view to,
+                                       double departure_time) const;
+
+ private:
+  using StopIndex = size_t;
+
+  // перегон рейса между соседними остановками, время в секундах
+  struct Connection {
+    StopIndex from;
+    StopIndex to;
+    double departure;
+    double arrival;
+    size_t trip;
+    // номер перегона в рейсе
+    size_t position;
+  };
+
+  std::vector<const Stop *> stops_;
+  std::unordered_map<std::string_view, StopIndex> stop_by_name_;
+  // автобус каждого рейса
+  std::vector<const Bus *> trip_buses_;
+  // отсортированы по времени отправления
+  std::vector<Connection> connections_;
+
+  std::optional<StopIndex> FindStop(std::string_view name) const;
+};
+
+}  // namespace transport_catalogue::router
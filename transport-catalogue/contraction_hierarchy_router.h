@@ -0,0 +1,459 @@
+#pragma once
+
+#include <algorithm>
+#include <cstdint>
+#include <functional>
+#include <optional>
+#include <queue>
+#include <stdexcept>
+#include <utility>
+#include <vector>
+
+#include "graph.h"
+#include "router.h"
+
+namespace graph {
+
+/**
+ * Движок на иерархиях сжатия (Contraction Hierarchies).
+ *
+ * В конструкторе вершины по одной "сжимаются" в порядке важности: вершина
+ * убирается из графа, а чтобы кратчайшие расстояния между оставшимися
+ * вершинами не изменились, вместо путей через неё добавляются рёбра-сокращения.
+ * Запрос - это двунаправленный поиск Дейкстры, который из `from` идёт только
+ * по рёбрам в более важные вершины, а из `to` - только по рёбрам из более
+ * важных вершин. Найденный путь раскрывается обратно в рёбра исходного графа,
+ * поэтому `RouteInfo::edges` содержит те же `EdgeId`, что и у остальных
+ * движков.
+ *
+ * Буферы поиска переиспользуются между запросами, поэтому `BuildRoute` нельзя
+ * вызывать одновременно из нескольких потоков.
+ */
+template <typename Weight, typename Graph = DirectedWeightedGraph<Weight>>
+class ContractionHierarchyRouter final : public AbstractRouter<Weight> {
+ public:
+  using typename AbstractRouter<Weight>::RouteInfo;
+
+  explicit ContractionHierarchyRouter(const Graph &graph);
+
+  std::optional<RouteInfo> BuildRoute(VertexId from,
+                                      VertexId to) const override;
+
+  /**
+   * Сколько рёбер-сокращений было добавлено при подготовке.
+   */
+  size_t GetShortcutCount() const { return shortcuts_.size(); }
+
+ private:
+  // ребро иерархии: исходное ребро графа или сокращение. Идентификаторы
+  // `0 .. E-1` совпадают с `EdgeId` исходного графа, сокращения идут следом
+  using ArcId = size_t;
+
+  struct Arc {
+    VertexId from;
+    VertexId to;
+    Weight weight;
+  };
+
+  // сокращение заменяет путь из двух рёбер иерархии
+  struct Shortcut {
+    ArcId first;
+    ArcId second;
+  };
+
+  // ребро в графе поиска: куда ведёт (для обратного поиска - откуда),
+  // с каким весом и какое ребро иерархии обозначает
+  struct SearchArc {
+    VertexId vertex;
+    Weight weight;
+    ArcId arc;
+  };
+
+  struct VertexState {
+    Weight weight{};
+    std::optional<ArcId> prev_arc;
+    uint32_t generation = 0;
+  };
+
+  using QueueItem = std::pair<Weight, VertexId>;
+  using Queue =
+      std::priority_queue<QueueItem, std::vector<QueueItem>, std::greater<>>;
+
+  // сколько вершин может обработать поиск свидетеля, прежде чем сдаться и
+  // считать, что сокращение нужно. Лишнее сокращение не ломает ответы
+  static constexpr size_t WITNESS_SETTLED_LIMIT = 500;
+  static constexpr Weight ZERO_WEIGHT{};
+
+  size_t edge_count_;
+  std::vector<Arc> arcs_;
+  std::vector<Shortcut> shortcuts_;
+
+  // граф поиска в формате CSR: рёбра из вершины `v` в более важные вершины
+  // лежат в `up_arcs_[up_offsets_[v] .. up_offsets_[v + 1])`, а рёбра в `v`
+  // из более важных вершин - в `down_arcs_`.
+  std::vector<size_t> up_offsets_;
+  std::vector<SearchArc> up_arcs_;
+  std::vector<size_t> down_offsets_;
+  std::vector<SearchArc> down_arcs_;
+
+  mutable std::vector<VertexState> forward_states_;
+  mutable std::vector<VertexState> backward_states_;
+  mutable uint32_t generation_ = 0;
+
+  void Contract(const Graph &graph);
+  void StartSearch() const;
+  void SearchStep(Queue &queue, std::vector<VertexState> &states,
+                  const std::vector<VertexState> &other_states,
+                  const std::vector<size_t> &offsets,
+                  const std::vector<SearchArc> &search_arcs,
+                  std::optional<Weight> &best_weight,
+                  std::optional<VertexId> &meeting_vertex) const;
+  void UnpackArc(ArcId arc, std::vector<EdgeId> &edges) const;
+};
+
+namespace detail {
+
+/**
+ * Рабочий граф, из которого при подготовке иерархии удаляются сжатые вершины.
+ */
+template <typename Weight>
+struct ContractionGraph {
+  explicit ContractionGraph(size_t vertex_count)
+      : out_arcs(vertex_count),
+        in_arcs(vertex_count),
+        witness_weights(vertex_count),
+        witness_generations(vertex_count, 0) {}
+
+  std::vector<std::vector<size_t>> out_arcs;
+  std::vector<std::vector<size_t>> in_arcs;
+
+  // буферы поиска свидетеля
+  std::vector<Weight> witness_weights;
+  std::vector<uint32_t> witness_generations;
+  uint32_t witness_generation = 0;
+};
+
+}  // namespace detail
+
+template <typename Weight, typename Graph>
+ContractionHierarchyRouter<Weight, Graph>::ContractionHierarchyRouter(
+    const Graph &graph)
+    : edge_count_(graph.GetEdgeCount()),
+      forward_states_(graph.GetVertexCount()),
+      backward_states_(graph.GetVertexCount()) {
+  arcs_.reserve(edge_count_);
+  for (EdgeId edge_id = 0; edge_id < edge_count_; ++edge_id) {
+    const auto &edge = graph.GetEdge(edge_id);
+    if (edge.weight < ZERO_WEIGHT) {
+      throw std::domain_error("Edges' weights should be non-negative");
+    }
+    arcs_.push_back({edge.from, edge.to, edge.weight});
+  }
+  Contract(graph);
+}
+
+/**
+ * Сжимает вершины графа по одной и строит граф поиска.
+ *
+ * Порядок сжатия выбирается жадно: первой сжимается вершина, для которой
+ * разница между числом добавляемых сокращений и числом удаляемых рёбер
+ * (плюс число уже сжатых соседей) минимальна. Приоритеты пересчитываются
+ * лениво: если у вынутой из очереди вершины приоритет вырос, она
+ * возвращается в очередь.
+ */
+template <typename Weight, typename Graph>
+void ContractionHierarchyRouter<Weight, Graph>::Contract(const Graph &graph) {
+  const size_t vertex_count = graph.GetVertexCount();
+  detail::ContractionGraph<Weight> work{vertex_count};
+  for (ArcId arc = 0; arc < arcs_.size(); ++arc) {
+    // петли никогда не лежат на кратчайшем пути
+    if (arcs_[arc].from != arcs_[arc].to) {
+      work.out_arcs[arcs_[arc].from].push_back(arc);
+      work.in_arcs[arcs_[arc].to].push_back(arc);
+    }
+  }
+
+  // Ищет из `source` расстояния до вершин оставшегося графа, не проходя через
+  // `skipped`. Поиск прекращается, когда расстояние превысит `limit`.
+  auto witness_search = [this, &work](VertexId source, VertexId skipped,
+                                      Weight limit) {
+    if (++work.witness_generation == 0) {
+      std::fill(work.witness_generations.begin(),
+                work.witness_generations.end(), 0);
+      work.witness_generation = 1;
+    }
+    const uint32_t generation = work.witness_generation;
+    Queue queue;
+    work.witness_weights[source] = ZERO_WEIGHT;
+    work.witness_generations[source] = generation;
+    queue.emplace(ZERO_WEIGHT, source);
+    size_t settled = 0;
+    while (!queue.empty() && settled < WITNESS_SETTLED_LIMIT) {
+      const auto [weight, vertex] = queue.top();
+      queue.pop();
+      if (weight > work.witness_weights[vertex]) {
+        continue;
+      }
+      if (weight > limit) {
+        break;
+      }
+      ++settled;
+      for (ArcId arc : work.out_arcs[vertex]) {
+        const VertexId to = arcs_[arc].to;
+        if (to == skipped) {
+          continue;
+        }
+        const Weight candidate = weight + arcs_[arc].weight;
+        if (work.witness_generations[to] != generation ||
+            candidate < work.witness_weights[to]) {
+          work.witness_weights[to] = candidate;
+          work.witness_generations[to] = generation;
+          queue.emplace(candidate, to);
+        }
+      }
+    }
+  };
+
+  // Перебирает сокращения, которые нужны при сжатии `vertex`. Для каждого
+  // вызывает `on_shortcut(in_arc, out_arc)`.
+  auto find_shortcuts = [this, &work, &witness_search](VertexId vertex,
+                                                       auto on_shortcut) {
+    for (ArcId in_arc : work.in_arcs[vertex]) {
+      const VertexId from = arcs_[in_arc].from;
+      Weight limit = ZERO_WEIGHT;
+      bool has_targets = false;
+      for (ArcId out_arc : work.out_arcs[vertex]) {
+        if (arcs_[out_arc].to != from) {
+          limit = std::max(limit, arcs_[in_arc].weight + arcs_[out_arc].weight);
+          has_targets = true;
+        }
+      }
+      if (!has_targets) {
+        continue;
+      }
+      witness_search(from, vertex, limit);
+      for (ArcId out_arc : work.out_arcs[vertex]) {
+        const VertexId to = arcs_[out_arc].to;
+        if (to == from) {
+          continue;
+        }
+        const Weight via_weight = arcs_[in_arc].weight + arcs_[out_arc].weight;
+        const bool has_witness =
+            work.witness_generations[to] == work.witness_generation &&
+            work.witness_weights[to] <= via_weight;
+        if (!has_witness) {
+          on_shortcut(in_arc, out_arc);
+        }
+      }
+    }
+  };
+
+  std::vector<int> contracted_neighbours(vertex_count, 0);
+  auto calc_priority = [&](VertexId vertex) {
+    int shortcut_count = 0;
+    find_shortcuts(vertex, [&shortcut_count](ArcId, ArcId) {
+      ++shortcut_count;
+    });
+    return shortcut_count -
+           static_cast<int>(work.in_arcs[vertex].size() +
+                            work.out_arcs[vertex].size()) +
+           contracted_neighbours[vertex];
+  };
+
+  using PriorityItem = std::pair<int, VertexId>;
+  std::priority_queue<PriorityItem, std::vector<PriorityItem>, std::greater<>>
+      order_queue;
+  for (VertexId vertex = 0; vertex < vertex_count; ++vertex) {
+    order_queue.emplace(calc_priority(vertex), vertex);
+  }
+
+  // вершины в порядке сжатия вместе с рёбрами, которые у них остались на
+  // момент сжатия: все эти рёбра ведут в более важные вершины
+  std::vector<std::vector<ArcId>> up_arcs(vertex_count);
+  std::vector<std::vector<ArcId>> down_arcs(vertex_count);
+
+  while (!order_queue.empty()) {
+    const VertexId vertex = order_queue.top().second;
+    order_queue.pop();
+    const int priority = calc_priority(vertex);
+    if (!order_queue.empty() && priority > order_queue.top().first) {
+      order_queue.emplace(priority, vertex);
+      continue;
+    }
+
+    std::vector<std::pair<ArcId, ArcId>> new_shortcuts;
+    find_shortcuts(vertex, [&new_shortcuts](ArcId in_arc, ArcId out_arc) {
+      new_shortcuts.emplace_back(in_arc, out_arc);
+    });
+
+    up_arcs[vertex] = work.out_arcs[vertex];
+    down_arcs[vertex] = work.in_arcs[vertex];
+    for (ArcId arc : work.in_arcs[vertex]) {
+      auto &neighbour_arcs = work.out_arcs[arcs_[arc].from];
+      neighbour_arcs.erase(
+          std::remove(neighbour_arcs.begin(), neighbour_arcs.end(), arc),
+          neighbour_arcs.end());
+      ++contracted_neighbours[arcs_[arc].from];
+    }
+    for (ArcId arc : work.out_arcs[vertex]) {
+      auto &neighbour_arcs = work.in_arcs[arcs_[arc].to];
+      neighbour_arcs.erase(
+          std::remove(neighbour_arcs.begin(), neighbour_arcs.end(), arc),
+          neighbour_arcs.end());
+      ++contracted_neighbours[arcs_[arc].to];
+    }
+    work.out_arcs[vertex].clear();
+    work.in_arcs[vertex].clear();
+
+    for (const auto &[in_arc, out_arc] : new_shortcuts) {
+      const ArcId arc = arcs_.size();
+      arcs_.push_back({arcs_[in_arc].from, arcs_[out_arc].to,
+                       arcs_[in_arc].weight + arcs_[out_arc].weight});
+      shortcuts_.push_back({in_arc, out_arc});
+      work.out_arcs[arcs_[arc].from].push_back(arc);
+      work.in_arcs[arcs_[arc].to].push_back(arc);
+    }
+  }
+
+  up_offsets_.reserve(vertex_count + 1);
+  down_offsets_.reserve(vertex_count + 1);
+  for (VertexId vertex = 0; vertex < vertex_count; ++vertex) {
+    up_offsets_.push_back(up_arcs_.size());
+    for (ArcId arc : up_arcs[vertex]) {
+      up_arcs_.push_back({arcs_[arc].to, arcs_[arc].weight, arc});
+    }
+    down_offsets_.push_back(down_arcs_.size());
+    for (ArcId arc : down_arcs[vertex]) {
+      down_arcs_.push_back({arcs_[arc].from, arcs_[arc].weight, arc});
+    }
+  }
+  up_offsets_.push_back(up_arcs_.size());
+  down_offsets_.push_back(down_arcs_.size());
+}
+
+template <typename Weight, typename Graph>
+void ContractionHierarchyRouter<Weight, Graph>::StartSearch() const {
+  ++generation_;
+  if (generation_ == 0) {
+    for (auto &state : forward_states_) {
+      state.generation = 0;
+    }
+    for (auto &state : backward_states_) {
+      state.generation = 0;
+    }
+    generation_ = 1;
+  }
+}
+
+/**
+ * Делает один шаг поиска в одном направлении: обрабатывает ближайшую вершину
+ * из `queue` и, если она уже достигнута поиском с другой стороны, обновляет
+ * лучший найденный маршрут.
+ */
+template <typename Weight, typename Graph>
+void ContractionHierarchyRouter<Weight, Graph>::SearchStep(
+    Queue &queue, std::vector<VertexState> &states,
+    const std::vector<VertexState> &other_states,
+    const std::vector<size_t> &offsets,
+    const std::vector<SearchArc> &search_arcs,
+    std::optional<Weight> &best_weight,
+    std::optional<VertexId> &meeting_vertex) const {
+  const auto [weight, vertex] = queue.top();
+  queue.pop();
+  if (weight > states[vertex].weight) {
+    return;
+  }
+  if (other_states[vertex].generation == generation_) {
+    const Weight route_weight = weight + other_states[vertex].weight;
+    if (!best_weight || route_weight < *best_weight) {
+      best_weight = route_weight;
+      meeting_vertex = vertex;
+    }
+  }
+  for (size_t i = offsets[vertex]; i < offsets[vertex + 1]; ++i) {
+    const auto &search_arc = search_arcs[i];
+    const Weight candidate = weight + search_arc.weight;
+    auto &state = states[search_arc.vertex];
+    if (state.generation != generation_ || candidate < state.weight) {
+      state = {candidate, search_arc.arc, generation_};
+      queue.emplace(candidate, search_arc.vertex);
+    }
+  }
+}
+
+template <typename Weight, typename Graph>
+std::optional<typename ContractionHierarchyRouter<Weight, Graph>::RouteInfo>
+ContractionHierarchyRouter<Weight, Graph>::BuildRoute(VertexId from,
+                                                      VertexId to) const {
+  if (from >= forward_states_.size() || to >= forward_states_.size()) {
+    throw std::out_of_range("vertex id is out of range");
+  }
+  StartSearch();
+
+  Queue forward_queue;
+  Queue backward_queue;
+  forward_states_[from] = {ZERO_WEIGHT, std::nullopt, generation_};
+  backward_states_[to] = {ZERO_WEIGHT, std::nullopt, generation_};
+  forward_queue.emplace(ZERO_WEIGHT, from);
+  backward_queue.emplace(ZERO_WEIGHT, to);
+
+  std::optional<Weight> best_weight;
+  std::optional<VertexId> meeting_vertex;
+  // поиски идут только вверх по иерархии, поэтому останавливать их можно лишь
+  // когда каждая очередь сама по себе не может улучшить лучший маршрут
+  auto is_exhausted = [&best_weight](const Queue &queue) {
+    return queue.empty() || (best_weight && queue.top().first >= *best_weight);
+  };
+  while (!is_exhausted(forward_queue) || !is_exhausted(backward_queue)) {
+    if (!is_exhausted(forward_queue)) {
+      SearchStep(forward_queue, forward_states_, backward_states_, up_offsets_,
+                 up_arcs_, best_weight, meeting_vertex);
+    }
+    if (!is_exhausted(backward_queue)) {
+      SearchStep(backward_queue, backward_states_, forward_states_,
+                 down_offsets_, down_arcs_, best_weight, meeting_vertex);
+    }
+  }
+  if (!meeting_vertex) {
+    return std::nullopt;
+  }
+
+  std::vector<ArcId> forward_arcs;
+  for (std::optional<ArcId> arc = forward_states_[*meeting_vertex].prev_arc;
+       arc; arc = forward_states_[arcs_[*arc].from].prev_arc) {
+    forward_arcs.push_back(*arc);
+  }
+  std::vector<EdgeId> edges;
+  for (auto it = forward_arcs.rbegin(); it != forward_arcs.rend(); ++it) {
+    UnpackArc(*it, edges);
+  }
+  for (std::optional<ArcId> arc = backward_states_[*meeting_vertex].prev_arc;
+       arc; arc = backward_states_[arcs_[*arc].to].prev_arc) {
+    UnpackArc(*arc, edges);
+  }
+
+  return RouteInfo{*best_weight, std::move(edges)};
+}
+
+/**
+ * Раскрывает ребро иерархии в последовательность рёбер исходного графа и
+ * дописывает их в `edges`.
+ */
+template <typename Weight, typename Graph>
+void ContractionHierarchyRouter<Weight, Graph>::UnpackArc(
+    ArcId arc, std::vector<EdgeId> &edges) const {
+  std::vector<ArcId> stack{arc};
+  while (!stack.empty()) {
+    const ArcId current = stack.back();
+    stack.pop_back();
+    if (current < edge_count_) {
+      edges.push_back(current);
+    } else {
+      const auto &shortcut = shortcuts_[current - edge_count_];
+      stack.push_back(shortcut.second);
+      stack.push_back(shortcut.first);
+    }
+  }
+}
+
+}  // namespace graph
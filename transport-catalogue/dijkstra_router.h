@@ -0,0 +1,228 @@
+#pragma once
+
+#include <algorithm>
+#include <cstdint>
+#include <functional>
+#include <limits>
+#include <optional>
+#include <queue>
+#include <stdexcept>
+#include <utility>
+#include <vector>
+
+#include "graph.h"
+#include "router.h"
+
+namespace graph {
+
+/**
+ * Движок, который ничего не считает заранее, а на каждый запрос запускает
+ * алгоритм Дейкстры из вершины `from` и останавливается, как только вершина
+ * `to` будет окончательно обработана.
+ *
+ * Подготовка занимает O(E) на проверку весов, память - O(V + E).
+ *
+ * Буферы поиска переиспользуются между запросами, поэтому `BuildRoute` нельзя
+ * вызывать одновременно из нескольких потоков.
+ */
+template <typename Weight, typename Graph = DirectedWeightedGraph<Weight>>
+class DijkstraRouter final : public AbstractRouter<Weight> {
+ public:
+  using typename AbstractRouter<Weight>::RouteInfo;
+
+  explicit DijkstraRouter(const Graph &graph);
+
+  std::optional<RouteInfo> BuildRoute(VertexId from,
+                                      VertexId to) const override;
+
+ private:
+  using QueueItem = std::pair<Weight, VertexId>;
+
+  /**
+   * Состояние вершины в текущем поиске. Вершина считается нетронутой, если её
+   * `generation` не совпадает с номером текущего поиска - так не приходится
+   * обнулять весь массив перед каждым запросом.
+   */
+  struct VertexState {
+    Weight weight{};
+    std::optional<EdgeId> prev_edge;
+    uint32_t generation = 0;
+  };
+
+  static constexpr Weight ZERO_WEIGHT{};
+  const Graph &graph_;
+  mutable std::vector<VertexState> states_;
+  mutable uint32_t generation_ = 0;
+
+  void StartSearch() const;
+  bool IsReached(VertexId vertex) const {
+    return states_[vertex].generation == generation_;
+  }
+};
+
+template <typename Weight, typename Graph>
+DijkstraRouter<Weight, Graph>::DijkstraRouter(const Graph &graph)
+    : graph_(graph), states_(graph.GetVertexCount()) {
+  for (EdgeId edge_id = 0; edge_id < graph.GetEdgeCount(); ++edge_id) {
+    if (graph.GetEdge(edge_id).weight < ZERO_WEIGHT) {
+      throw std::domain_error("Edges' weights should be non-negative");
+    }
+  }
+}
+
+template <typename Weight, typename Graph>
+void DijkstraRouter<Weight, Graph>::StartSearch() const {
+  ++generation_;
+  // счётчик переполнился: старые отметки могут совпасть с новыми
+  if (generation_ == 0) {
+    for (auto &state : states_) {
+      state.generation = 0;
+    }
+    generation_ = 1;
+  }
+}
+
+template <typename Weight, typename Graph>
+std::optional<typename DijkstraRouter<Weight, Graph>::RouteInfo>
+DijkstraRouter<Weight, Graph>::BuildRoute(VertexId from, VertexId to) const {
+  if (from >= states_.size() || to >= states_.size()) {
+    throw std::out_of_range("vertex id is out of range");
+  }
+  StartSearch();
+
+  std::priority_queue<QueueItem, std::vector<QueueItem>, std::greater<>> queue;
+  states_[from] = {ZERO_WEIGHT, std::nullopt, generation_};
+  queue.emplace(ZERO_WEIGHT, from);
+
+  bool found = false;
+  while (!queue.empty()) {
+    const auto [weight, vertex] = queue.top();
+    queue.pop();
+    // в очереди могут остаться устаревшие записи с большим весом
+    if (weight > states_[vertex].weight) {
+      continue;
+    }
+    if (vertex == to) {
+      found = true;
+      break;
+    }
+    for (const EdgeId edge_id : graph_.GetIncidentEdges(vertex)) {
+      const auto &edge = graph_.GetEdge(edge_id);
+      const Weight candidate_weight = weight + edge.weight;
+      auto &state = states_[edge.to];
+      if (!IsReached(edge.to) || candidate_weight < state.weight) {
+        state = {candidate_weight, edge_id, generation_};
+        queue.emplace(candidate_weight, edge.to);
+      }
+    }
+  }
+  if (!found) {
+    return std::nullopt;
+  }
+
+  std::vector<EdgeId> edges;
+  for (std::optional<EdgeId> edge_id = states_[to].prev_edge; edge_id;
+       edge_id = states_[graph_.GetEdge(*edge_id).from].prev_edge) {
+    edges.push_back(*edge_id);
+  }
+  std::reverse(edges.begin(), edges.end());
+
+  return RouteInfo{states_[to].weight, std::move(edges)};
+}
+
+/**
+ * Дерево кратчайших путей из вершины `source` во все остальные: вес пути и
+ * последнее ребро пути для каждой вершины. Строится одним полным поиском
+ * Дейкстры, после чего маршрут до любой вершины восстанавливается без поиска.
+ * Занимает O(V) памяти.
+ *
+ * Если задан `max_weight`, поиск не идёт дальше путей такого веса, и вершины
+ * за этой границей считаются недостижимыми.
+ */
+template <typename Weight, typename Graph = DirectedWeightedGraph<Weight>>
+class ShortestPathTree {
+ public:
+  using RouteInfo = typename AbstractRouter<Weight>::RouteInfo;
+
+  ShortestPathTree(const Graph &graph, VertexId source,
+                   std::optional<Weight> max_weight = std::nullopt);
+
+  VertexId GetSource() const { return source_; }
+  std::optional<RouteInfo> BuildRoute(VertexId to) const;
+
+  /**
+   * Вес кратчайшего пути до `to` без восстановления самого пути.
+   */
+  std::optional<Weight> GetWeight(VertexId to) const {
+    const Weight weight = weights_.at(to);
+    return weight == UNREACHABLE ? std::nullopt : std::optional{weight};
+  }
+
+ private:
+  using QueueItem = std::pair<Weight, VertexId>;
+
+  static constexpr Weight ZERO_WEIGHT{};
+  static constexpr Weight UNREACHABLE = std::numeric_limits<Weight>::max();
+  static constexpr EdgeId NO_EDGE = std::numeric_limits<EdgeId>::max();
+
+  const Graph &graph_;
+  VertexId source_;
+  std::vector<Weight> weights_;
+  std::vector<EdgeId> prev_edges_;
+};
+
+template <typename Weight, typename Graph>
+ShortestPathTree<Weight, Graph>::ShortestPathTree(
+    const Graph &graph, VertexId source, std::optional<Weight> max_weight)
+    : graph_(graph),
+      source_(source),
+      weights_(graph.GetVertexCount(), UNREACHABLE),
+      prev_edges_(graph.GetVertexCount(), NO_EDGE) {
+  if (source >= weights_.size()) {
+    throw std::out_of_range("vertex id is out of range");
+  }
+  std::priority_queue<QueueItem, std::vector<QueueItem>, std::greater<>> queue;
+  weights_[source] = ZERO_WEIGHT;
+  queue.emplace(ZERO_WEIGHT, source);
+  while (!queue.empty()) {
+    const auto [weight, vertex] = queue.top();
+    queue.pop();
+    if (weight > weights_[vertex]) {
+      continue;
+    }
+    for (const EdgeId edge_id : graph_.GetIncidentEdges(vertex)) {
+      const auto &edge = graph_.GetEdge(edge_id);
+      if (edge.weight < ZERO_WEIGHT) {
+        throw std::domain_error("Edges' weights should be non-negative");
+      }
+      const Weight candidate_weight = weight + edge.weight;
+      if (candidate_weight < weights_[edge.to] &&
+          !(max_weight && *max_weight < candidate_weight)) {
+        weights_[edge.to] = candidate_weight;
+        prev_edges_[edge.to] = edge_id;
+        queue.emplace(candidate_weight, edge.to);
+      }
+    }
+  }
+}
+
+template <typename Weight, typename Graph>
+std::optional<typename ShortestPathTree<Weight, Graph>::RouteInfo>
+ShortestPathTree<Weight, Graph>::BuildRoute(VertexId to) const {
+  if (to >= weights_.size()) {
+    throw std::out_of_range("vertex id is out of range");
+  }
+  if (weights_[to] == UNREACHABLE) {
+    return std::nullopt;
+  }
+  std::vector<EdgeId> edges;
+  for (EdgeId edge_id = prev_edges_[to]; edge_id != NO_EDGE;
+       edge_id = prev_edges_[graph_.GetEdge(edge_id).from]) {
+    edges.push_back(edge_id);
+  }
+  std::reverse(edges.begin(), edges.end());
+
+  return RouteInfo{weights_[to], std::move(edges)};
+}
+
+}  // namespace graph
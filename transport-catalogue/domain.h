@@ -21,6 +21,16 @@ struct Stop {
   geo::Coordinates coords;
 };
 
+/**
+ * Рейс автобуса по расписанию: время отправления с каждой остановки маршрута
+ * в минутах от начала суток. Остановки перечислены в том порядке, в каком
+ * автобус их проезжает за рейс, см. `Bus`: у линейного маршрута туда и
+ * обратно, у кольцевого - с первой остановкой ещё раз в конце.
+ */
+struct Trip {
+  std::vector<double> departure_times;
+};
+
 /**
  * Маршрут.
  * Бывает линейным, тогда он идёт так:
@@ -35,6 +45,8 @@ struct Bus {
   RouteType route_type = RouteType::LINEAR;
   // указатель смотрит на элемент `deque` в транспортном справочнике
   std::vector<const Stop*> stops;
+  // рейсы по расписанию, если оно задано
+  std::vector<Trip> trips;
 };
 
 /**
@@ -1,6 +1,10 @@
 #pragma once
 
 #include <cstddef>
+#include <cstdint>
+#include <iterator>
+#include <limits>
+#include <stdexcept>
 #include <vector>
 
 #include "ranges.h"
@@ -34,9 +38,20 @@ class DirectedWeightedGraph {
   const Edge<Weight>& GetEdge(EdgeId edge_id) const;
   IncidentEdgesRange GetIncidentEdges(VertexId vertex) const;
 
+  /**
+   * Построить индекс входящих рёбер. После этого он поддерживается при
+   * добавлении рёбер, а `GetIncomingEdges` становится доступен. Индекс нужен
+   * только алгоритмам, которые ищут маршруты от конечной вершины.
+   */
+  void BuildIncomingEdgesIndex();
+  bool HasIncomingEdgesIndex() const;
+  IncidentEdgesRange GetIncomingEdges(VertexId vertex) const;
+
  private:
   std::vector<Edge<Weight>> edges_;
   std::vector<IncidenceList> incidence_lists_;
+  std::vector<IncidenceList> incoming_lists_;
+  bool has_incoming_index_ = false;
 };
 
 template <typename Weight>
@@ -48,6 +63,9 @@ EdgeId DirectedWeightedGraph<Weight>::AddEdge(const Edge<Weight>& edge) {
   edges_.push_back(edge);
   const EdgeId id = edges_.size() - 1;
   incidence_lists_.at(edge.from).push_back(id);
+  if (has_incoming_index_) {
+    incoming_lists_.at(edge.to).push_back(id);
+  }
   return id;
 }
 
@@ -72,4 +90,251 @@ typename DirectedWeightedGraph<Weight>::IncidentEdgesRange
 DirectedWeightedGraph<Weight>::GetIncidentEdges(VertexId vertex) const {
   return ranges::AsRange(incidence_lists_.at(vertex));
 }
+
+template <typename Weight>
+void DirectedWeightedGraph<Weight>::BuildIncomingEdgesIndex() {
+  if (has_incoming_index_) {
+    return;
+  }
+  incoming_lists_.assign(incidence_lists_.size(), {});
+  for (EdgeId id = 0; id < edges_.size(); ++id) {
+    incoming_lists_[edges_[id].to].push_back(id);
+  }
+  has_incoming_index_ = true;
+}
+
+template <typename Weight>
+bool DirectedWeightedGraph<Weight>::HasIncomingEdgesIndex() const {
+  return has_incoming_index_;
+}
+
+/**
+ * Рёбра, входящие в вершину `vertex`. Кидает `logic_error`, если индекс
+ * входящих рёбер не был построен.
+ */
+template <typename Weight>
+typename DirectedWeightedGraph<Weight>::IncidentEdgesRange
+DirectedWeightedGraph<Weight>::GetIncomingEdges(VertexId vertex) const {
+  if (!has_incoming_index_) {
+    throw std::logic_error("incoming edges index has not been built");
+  }
+  return ranges::AsRange(incoming_lists_.at(vertex));
+}
+
+/**
+ * Неизменяемый граф в формате CSR (compressed sparse row). Рёбра лежат
+ * в массивах подряд, сгруппированные по начальной вершине: рёбра вершины `v`
+ * имеют номера `[offsets[v], offsets[v + 1])`, так что обход соседей -
+ * это проход по непрерывным кускам `targets` и `weights` без отдельного
+ * вектора на каждую вершину. Номера вершин и рёбер хранятся в 32 битах,
+ * индекс входящих рёбер строится сразу.
+ *
+ * Строится из `DirectedWeightedGraph`. Порядок рёбер одной вершины
+ * сохраняется, но номера рёбер меняются, исходный номер ребра возвращает
+ * `GetSourceEdgeId`. Интерфейс тот же, что у `DirectedWeightedGraph`, кроме
+ * `AddEdge`, поэтому граф годится для всех алгоритмов поиска маршрутов.
+ * Проверки границ нет: номера должны быть валидными.
+ *
+ * Массивы графа доступны через `GetData`, а граф можно создать поверх
+ * готовых массивов, например из отображённого в память файла, без
+ * копирования. Такой граф не владеет памятью, она должна жить дольше него.
+ */
+template <typename Weight>
+class CsrGraph {
+ public:
+  using Index = uint32_t;
+
+  struct Data {
+    size_t vertex_count = 0;
+    size_t edge_count = 0;
+    // `offsets` и `incoming_offsets` длины `vertex_count + 1`, остальные
+    // массивы - длины `edge_count`
+    const Index* offsets = nullptr;
+    const Index* sources = nullptr;
+    const Index* targets = nullptr;
+    const Weight* weights = nullptr;
+    const Index* incoming_offsets = nullptr;
+    const Index* incoming_edges = nullptr;
+    const Index* source_edge_ids = nullptr;
+  };
+
+ private:
+  /**
+   * Итератор по номерам рёбер: либо подряд идущие номера, либо номера,
+   * перечисленные в массиве `ids`. Нужен, чтобы исходящие и входящие рёбра
+   * были диапазонами одного типа.
+   */
+  class EdgeIdIterator {
+   public:
+    using iterator_category = std::forward_iterator_tag;
+    using value_type = EdgeId;
+    using difference_type = std::ptrdiff_t;
+    using pointer = const EdgeId*;
+    using reference = EdgeId;
+
+    EdgeIdIterator(const Index* ids, Index position)
+        : ids_(ids), position_(position) {}
+
+    EdgeId operator*() const {
+      return ids_ == nullptr ? position_ : ids_[position_];
+    }
+    EdgeIdIterator& operator++() {
+      ++position_;
+      return *this;
+    }
+    bool operator==(const EdgeIdIterator& other) const {
+      return position_ == other.position_;
+    }
+    bool operator!=(const EdgeIdIterator& other) const {
+      return position_ != other.position_;
+    }
+
+   private:
+    const Index* ids_;
+    Index position_;
+  };
+
+  using IncidentEdgesRange = ranges::Range<EdgeIdIterator>;
+
+ public:
+  CsrGraph() = default;
+  explicit CsrGraph(const DirectedWeightedGraph<Weight>& graph);
+  explicit CsrGraph(const Data& data) : data_(data) {}
+
+  // `data_` смотрит в `storage_`: копия смотрела бы в чужие массивы, а при
+  // перемещении буферы векторов остаются на месте
+  CsrGraph(const CsrGraph&) = delete;
+  CsrGraph& operator=(const CsrGraph&) = delete;
+  CsrGraph(CsrGraph&&) = default;
+  CsrGraph& operator=(CsrGraph&&) = default;
+
+  size_t GetVertexCount() const;
+  size_t GetEdgeCount() const;
+  Edge<Weight> GetEdge(EdgeId edge_id) const;
+  IncidentEdgesRange GetIncidentEdges(VertexId vertex) const;
+  bool HasIncomingEdgesIndex() const;
+  IncidentEdgesRange GetIncomingEdges(VertexId vertex) const;
+  EdgeId GetSourceEdgeId(EdgeId edge_id) const;
+  const Data& GetData() const;
+
+ private:
+  // массивы графа, построенного из `DirectedWeightedGraph`
+  struct Storage {
+    std::vector<Index> offsets;
+    std::vector<Index> sources;
+    std::vector<Index> targets;
+    std::vector<Weight> weights;
+    std::vector<Index> incoming_offsets;
+    std::vector<Index> incoming_edges;
+    std::vector<Index> source_edge_ids;
+  };
+
+  Storage storage_;
+  Data data_;
+};
+
+/**
+ * Кидает `out_of_range`, если вершины или рёбра графа не помещаются
+ * в 32-битные номера.
+ */
+template <typename Weight>
+CsrGraph<Weight>::CsrGraph(const DirectedWeightedGraph<Weight>& graph) {
+  const size_t vertex_count = graph.GetVertexCount();
+  const size_t edge_count = graph.GetEdgeCount();
+  if (vertex_count >= std::numeric_limits<Index>::max() ||
+      edge_count >= std::numeric_limits<Index>::max()) {
+    throw std::out_of_range("graph is too large for 32-bit ids");
+  }
+
+  auto& s = storage_;
+  s.offsets.reserve(vertex_count + 1);
+  s.sources.reserve(edge_count);
+  s.targets.reserve(edge_count);
+  s.weights.reserve(edge_count);
+  s.source_edge_ids.reserve(edge_count);
+  s.incoming_offsets.assign(vertex_count + 1, 0);
+  for (VertexId vertex = 0; vertex < vertex_count; ++vertex) {
+    s.offsets.push_back(static_cast<Index>(s.targets.size()));
+    for (const EdgeId edge_id : graph.GetIncidentEdges(vertex)) {
+      const auto& edge = graph.GetEdge(edge_id);
+      s.sources.push_back(static_cast<Index>(edge.from));
+      s.targets.push_back(static_cast<Index>(edge.to));
+      s.weights.push_back(edge.weight);
+      s.source_edge_ids.push_back(static_cast<Index>(edge_id));
+      ++s.incoming_offsets[edge.to + 1];
+    }
+  }
+  s.offsets.push_back(static_cast<Index>(s.targets.size()));
+
+  // входящие рёбра раскладываем подсчётом, в порядке номеров рёбер
+  for (size_t i = 1; i <= vertex_count; ++i) {
+    s.incoming_offsets[i] += s.incoming_offsets[i - 1];
+  }
+  s.incoming_edges.resize(edge_count);
+  std::vector<Index> positions(s.incoming_offsets.begin(),
+                               s.incoming_offsets.end() - 1);
+  for (Index id = 0; id < edge_count; ++id) {
+    s.incoming_edges[positions[s.targets[id]]++] = id;
+  }
+
+  data_.vertex_count = vertex_count;
+  data_.edge_count = edge_count;
+  data_.offsets = s.offsets.data();
+  data_.sources = s.sources.data();
+  data_.targets = s.targets.data();
+  data_.weights = s.weights.data();
+  data_.incoming_offsets = s.incoming_offsets.data();
+  data_.incoming_edges = s.incoming_edges.data();
+  data_.source_edge_ids = s.source_edge_ids.data();
+}
+
+template <typename Weight>
+size_t CsrGraph<Weight>::GetVertexCount() const {
+  return data_.vertex_count;
+}
+
+template <typename Weight>
+size_t CsrGraph<Weight>::GetEdgeCount() const {
+  return data_.edge_count;
+}
+
+template <typename Weight>
+Edge<Weight> CsrGraph<Weight>::GetEdge(EdgeId edge_id) const {
+  return {data_.sources[edge_id], data_.targets[edge_id],
+          data_.weights[edge_id]};
+}
+
+template <typename Weight>
+typename CsrGraph<Weight>::IncidentEdgesRange
+CsrGraph<Weight>::GetIncidentEdges(VertexId vertex) const {
+  return {EdgeIdIterator{nullptr, data_.offsets[vertex]},
+          EdgeIdIterator{nullptr, data_.offsets[vertex + 1]}};
+}
+
+template <typename Weight>
+bool CsrGraph<Weight>::HasIncomingEdgesIndex() const {
+  return true;
+}
+
+template <typename Weight>
+typename CsrGraph<Weight>::IncidentEdgesRange
+CsrGraph<Weight>::GetIncomingEdges(VertexId vertex) const {
+  const Index* ids = data_.incoming_edges;
+  return {EdgeIdIterator{ids, data_.incoming_offsets[vertex]},
+          EdgeIdIterator{ids, data_.incoming_offsets[vertex + 1]}};
+}
+
+/**
+ * Номер ребра `edge_id` в графе, из которого построен этот.
+ */
+template <typename Weight>
+EdgeId CsrGraph<Weight>::GetSourceEdgeId(EdgeId edge_id) const {
+  return data_.source_edge_ids[edge_id];
+}
+
+template <typename Weight>
+const typename CsrGraph<Weight>::Data& CsrGraph<Weight>::GetData() const {
+  return data_;
+}
+
 }  // namespace graph
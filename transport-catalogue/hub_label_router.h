@@ -0,0 +1,335 @@
+#pragma once
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <functional>
+#include <limits>
+#include <optional>
+#include <queue>
+#include <stdexcept>
+#include <utility>
+#include <vector>
+
+#include "graph.h"
+#include "router.h"
+
+namespace graph {
+
+/**
+ * Статистика подготовки движка на метках-хабах.
+ */
+struct HubLabelStats {
+  // сколько всего записей во всех метках (прямых и обратных)
+  size_t label_entry_count = 0;
+  // размер самой большой метки
+  size_t max_label_size = 0;
+  std::chrono::duration<double> build_time{};
+};
+
+/**
+ * Движок на метках-хабах (hub labeling, 2-hop cover).
+ *
+ * Для каждой вершины `v` хранятся две метки: прямая - расстояния от `v` до
+ * некоторых вершин-хабов, и обратная - расстояния от хабов до `v`. Метки
+ * строятся так, что на кратчайшем пути между любыми двумя вершинами лежит
+ * хаб, который есть и в прямой метке начала, и в обратной метке конца.
+ * Запрос сводится к слиянию двух отсортированных массивов меток без обхода
+ * графа.
+ *
+ * Метки строятся алгоритмом Pruned Landmark Labeling: вершины по очереди,
+ * от самых важных, запускают прямой и обратный поиски Дейкстры, которые не
+ * идут дальше вершин, расстояние до которых уже покрыто метками предыдущих
+ * хабов. Важность вершины - число её рёбер: в графе остановок это
+ * пересадочные узлы. В каждой записи метки хранится ребро, по которому поиск
+ * хаба пришёл в вершину, и по этим рёбрам маршрут раскрывается в рёбра
+ * исходного графа.
+ *
+ * Для обратных поисков у графа должен быть построен индекс входящих рёбер.
+ * `BuildRoute` не меняет состояние движка и может вызываться из нескольких
+ * потоков одновременно.
+ */
+template <typename Weight, typename Graph = DirectedWeightedGraph<Weight>>
+class HubLabelRouter final : public AbstractRouter<Weight> {
+ public:
+  using typename AbstractRouter<Weight>::RouteInfo;
+
+  explicit HubLabelRouter(const Graph &graph);
+
+  std::optional<RouteInfo> BuildRoute(VertexId from,
+                                      VertexId to) const override;
+
+  const HubLabelStats &GetStats() const { return stats_; }
+
+ private:
+  // хаб в метках обозначается своим номером в порядке важности, поэтому
+  // записи каждой метки отсортированы по хабу сами собой
+  using HubRank = VertexId;
+
+  // метки в формате CSR: записи метки вершины `v` лежат в
+  // `[offsets[v] .. offsets[v + 1])` параллельных массивов `hubs`, `weights`
+  // и `edges`. Запрос читает только хабы и веса, рёбра нужны для раскрытия
+  // маршрута
+  struct Labels {
+    std::vector<size_t> offsets;
+    std::vector<HubRank> hubs;
+    std::vector<Weight> weights;
+    std::vector<EdgeId> edges;
+
+    std::optional<size_t> FindHub(VertexId vertex, HubRank hub) const;
+  };
+
+  // метки в процессе построения
+  struct LabelEntry {
+    HubRank hub;
+    Weight weight;
+    EdgeId edge;
+  };
+  using BuildLabels = std::vector<std::vector<LabelEntry>>;
+
+  // состояние вершины в поиске при построении: расстояние от корня и ребро,
+  // по которому поиск пришёл в вершину
+  struct SearchState {
+    Weight weight;
+    EdgeId edge;
+  };
+
+  // направление поиска при построении: прямой заполняет обратные метки
+  // достигнутых вершин, обратный - прямые
+  enum Direction {
+    FORWARD,
+    BACKWARD,
+  };
+
+  static constexpr Weight ZERO_WEIGHT{};
+  static constexpr Weight UNREACHABLE = std::numeric_limits<Weight>::max();
+  // ребро записи хаба о самом себе
+  static constexpr EdgeId NO_EDGE = std::numeric_limits<EdgeId>::max();
+
+  const Graph &graph_;
+  std::vector<VertexId> vertex_by_rank_;
+  // `out_labels_` - расстояния от вершины до хабов, `in_labels_` - от хабов
+  // до вершины
+  Labels out_labels_;
+  Labels in_labels_;
+  HubLabelStats stats_;
+
+  void PrunedSearch(Direction direction, HubRank rank, BuildLabels &out_labels,
+                    BuildLabels &in_labels, std::vector<Weight> &root_label,
+                    std::vector<SearchState> &states) const;
+  static Labels Flatten(BuildLabels &labels);
+};
+
+template <typename Weight, typename Graph>
+std::optional<size_t> HubLabelRouter<Weight, Graph>::Labels::FindHub(
+    VertexId vertex, HubRank hub) const {
+  const auto begin = hubs.begin() + offsets[vertex];
+  const auto end = hubs.begin() + offsets[vertex + 1];
+  const auto it = std::lower_bound(begin, end, hub);
+  if (it == end || *it != hub) {
+    return std::nullopt;
+  }
+  return it - hubs.begin();
+}
+
+template <typename Weight, typename Graph>
+HubLabelRouter<Weight, Graph>::HubLabelRouter(const Graph &graph)
+    : graph_(graph) {
+  const auto start_time = std::chrono::steady_clock::now();
+  if (!graph.HasIncomingEdgesIndex()) {
+    throw std::invalid_argument("hub labeling needs the incoming edges index");
+  }
+  for (EdgeId edge_id = 0; edge_id < graph.GetEdgeCount(); ++edge_id) {
+    if (graph.GetEdge(edge_id).weight < ZERO_WEIGHT) {
+      throw std::domain_error("Edges' weights should be non-negative");
+    }
+  }
+
+  const size_t vertex_count = graph.GetVertexCount();
+  std::vector<size_t> degrees(vertex_count, 0);
+  for (EdgeId edge_id = 0; edge_id < graph.GetEdgeCount(); ++edge_id) {
+    const auto &edge = graph.GetEdge(edge_id);
+    ++degrees[edge.from];
+    ++degrees[edge.to];
+  }
+  vertex_by_rank_.resize(vertex_count);
+  for (VertexId vertex = 0; vertex < vertex_count; ++vertex) {
+    vertex_by_rank_[vertex] = vertex;
+  }
+  std::stable_sort(vertex_by_rank_.begin(), vertex_by_rank_.end(),
+                   [&degrees](VertexId lhs, VertexId rhs) {
+                     return degrees[lhs] > degrees[rhs];
+                   });
+
+  BuildLabels out_labels(vertex_count);
+  BuildLabels in_labels(vertex_count);
+  // расстояния в метке хаба, который сейчас строится, по номерам хабов
+  std::vector<Weight> root_label(vertex_count, UNREACHABLE);
+  std::vector<SearchState> states(vertex_count, {UNREACHABLE, NO_EDGE});
+  for (HubRank rank = 0; rank < vertex_count; ++rank) {
+    PrunedSearch(FORWARD, rank, out_labels, in_labels, root_label, states);
+    PrunedSearch(BACKWARD, rank, out_labels, in_labels, root_label, states);
+  }
+  out_labels_ = Flatten(out_labels);
+  in_labels_ = Flatten(in_labels);
+
+  stats_.label_entry_count = out_labels_.hubs.size() + in_labels_.hubs.size();
+  for (VertexId vertex = 0; vertex < vertex_count; ++vertex) {
+    for (const Labels *labels : {&out_labels_, &in_labels_}) {
+      stats_.max_label_size =
+          std::max(stats_.max_label_size,
+                   labels->offsets[vertex + 1] - labels->offsets[vertex]);
+    }
+  }
+  stats_.build_time = std::chrono::steady_clock::now() - start_time;
+}
+
+/**
+ * Поиск Дейкстры из хаба номер `rank`. Вершина, расстояние до которой уже
+ * покрывают метки предыдущих хабов, не получает записи и не раскрывается.
+ */
+template <typename Weight, typename Graph>
+void HubLabelRouter<Weight, Graph>::PrunedSearch(
+    Direction direction, HubRank rank, BuildLabels &out_labels,
+    BuildLabels &in_labels, std::vector<Weight> &root_label,
+    std::vector<SearchState> &states) const {
+  using QueueItem = std::pair<Weight, VertexId>;
+
+  const VertexId root = vertex_by_rank_[rank];
+  // прямой поиск проверяет покрытие по прямой метке корня и обратным меткам
+  // достигнутых вершин, обратный - наоборот
+  const auto &root_entries =
+      direction == FORWARD ? out_labels[root] : in_labels[root];
+  BuildLabels &target_labels = direction == FORWARD ? in_labels : out_labels;
+  for (const auto &entry : root_entries) {
+    root_label[entry.hub] = entry.weight;
+  }
+
+  // поиски обычно отсекаются рано, поэтому после поиска сбрасываются только
+  // затронутые вершины, а не весь массив
+  std::vector<VertexId> touched{root};
+  std::priority_queue<QueueItem, std::vector<QueueItem>, std::greater<>> queue;
+  states[root] = {ZERO_WEIGHT, NO_EDGE};
+  queue.emplace(ZERO_WEIGHT, root);
+  while (!queue.empty()) {
+    const auto [weight, vertex] = queue.top();
+    queue.pop();
+    if (weight > states[vertex].weight) {
+      continue;
+    }
+    auto &label = target_labels[vertex];
+    const bool is_covered =
+        std::any_of(label.begin(), label.end(), [&](const LabelEntry &entry) {
+          return root_label[entry.hub] != UNREACHABLE &&
+                 root_label[entry.hub] + entry.weight <= weight;
+        });
+    if (is_covered) {
+      continue;
+    }
+    label.push_back({rank, weight, states[vertex].edge});
+
+    const auto edges = direction == FORWARD ? graph_.GetIncidentEdges(vertex)
+                                            : graph_.GetIncomingEdges(vertex);
+    for (const EdgeId edge_id : edges) {
+      const auto &edge = graph_.GetEdge(edge_id);
+      const VertexId next = direction == FORWARD ? edge.to : edge.from;
+      const Weight candidate = weight + edge.weight;
+      if (candidate < states[next].weight) {
+        if (states[next].weight == UNREACHABLE) {
+          touched.push_back(next);
+        }
+        states[next] = {candidate, edge_id};
+        queue.emplace(candidate, next);
+      }
+    }
+  }
+
+  for (const auto &entry : root_entries) {
+    root_label[entry.hub] = UNREACHABLE;
+  }
+  for (const VertexId vertex : touched) {
+    states[vertex] = {UNREACHABLE, NO_EDGE};
+  }
+}
+
+template <typename Weight, typename Graph>
+typename HubLabelRouter<Weight, Graph>::Labels
+HubLabelRouter<Weight, Graph>::Flatten(BuildLabels &labels) {
+  Labels result;
+  result.offsets.reserve(labels.size() + 1);
+  result.offsets.push_back(0);
+  for (auto &label : labels) {
+    for (const auto &entry : label) {
+      result.hubs.push_back(entry.hub);
+      result.weights.push_back(entry.weight);
+      result.edges.push_back(entry.edge);
+    }
+    result.offsets.push_back(result.hubs.size());
+    label.clear();
+    label.shrink_to_fit();
+  }
+  return result;
+}
+
+template <typename Weight, typename Graph>
+std::optional<typename HubLabelRouter<Weight, Graph>::RouteInfo>
+HubLabelRouter<Weight, Graph>::BuildRoute(VertexId from, VertexId to) const {
+  const size_t vertex_count = vertex_by_rank_.size();
+  if (from >= vertex_count || to >= vertex_count) {
+    throw std::out_of_range("vertex id is out of range");
+  }
+  if (from == to) {
+    return RouteInfo{ZERO_WEIGHT, {}};
+  }
+
+  std::optional<Weight> best_weight;
+  HubRank best_hub = 0;
+  size_t out_index = out_labels_.offsets[from];
+  const size_t out_end = out_labels_.offsets[from + 1];
+  size_t in_index = in_labels_.offsets[to];
+  const size_t in_end = in_labels_.offsets[to + 1];
+  while (out_index < out_end && in_index < in_end) {
+    const HubRank out_hub = out_labels_.hubs[out_index];
+    const HubRank in_hub = in_labels_.hubs[in_index];
+    if (out_hub < in_hub) {
+      ++out_index;
+    } else if (in_hub < out_hub) {
+      ++in_index;
+    } else {
+      const Weight weight =
+          out_labels_.weights[out_index] + in_labels_.weights[in_index];
+      if (!best_weight || weight < *best_weight) {
+        best_weight = weight;
+        best_hub = out_hub;
+      }
+      ++out_index;
+      ++in_index;
+    }
+  }
+  if (!best_weight) {
+    return std::nullopt;
+  }
+
+  // каждая вершина на пути от корня поиска хаба тоже получила запись этого
+  // хаба, иначе поиск не прошёл бы через неё
+  const VertexId hub_vertex = vertex_by_rank_[best_hub];
+  std::vector<EdgeId> edges;
+  for (VertexId vertex = from; vertex != hub_vertex;) {
+    const EdgeId edge_id =
+        out_labels_.edges[*out_labels_.FindHub(vertex, best_hub)];
+    edges.push_back(edge_id);
+    vertex = graph_.GetEdge(edge_id).to;
+  }
+  const size_t first_half_size = edges.size();
+  for (VertexId vertex = to; vertex != hub_vertex;) {
+    const EdgeId edge_id =
+        in_labels_.edges[*in_labels_.FindHub(vertex, best_hub)];
+    edges.push_back(edge_id);
+    vertex = graph_.GetEdge(edge_id).from;
+  }
+  std::reverse(edges.begin() + first_half_size, edges.end());
+
+  return RouteInfo{*best_weight, std::move(edges)};
+}
+
+}  // namespace graph
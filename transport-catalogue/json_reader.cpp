@@ -2,8 +2,10 @@
 
 #include <algorithm>
 #include <map>
+#include <sstream>
 #include <stdexcept>
 #include <string>
+#include <string_view>
 #include <variant>
 
 #include "domain.h"
@@ -40,11 +42,22 @@ AddBusCmd ParseBusCmd(const json::Dict &request) {
     stop_names.emplace_back(node.AsString());
   }
 
+  vector<vector<double>> trips;
+  if (request.count("trips"s) > 0) {
+    for (const auto &trip_node : request.at("trips"s).AsArray()) {
+      auto &trip = trips.emplace_back();
+      for (const auto &node : trip_node.AsArray()) {
+        trip.push_back(node.AsDouble());
+      }
+    }
+  }
+
   return {
       request.at("name"s).AsString(),
       request.at("is_roundtrip"s).AsBool() ? RouteType::CIRCULAR
                                            : RouteType::LINEAR,
       move(stop_names),
+      move(trips),
   };
 }
 
@@ -76,11 +89,48 @@ BusStatRequest ParseBusStatRequest(const json::Dict &request) {
 }
 
 RouteRequest ParseRouteRequest(const json::Dict &request) {
-  return {
-      request.at("id"s).AsInt(),
-      request.at("from"s).AsString(),
-      request.at("to"s).AsString(),
-  };
+  RouteRequest result;
+  result.id = request.at("id"s).AsInt();
+  result.from = request.at("from"s).AsString();
+  result.to = request.at("to"s).AsString();
+  if (request.count("departure_time"s) > 0) {
+    result.departure_time = request.at("departure_time"s).AsDouble();
+  }
+  if (request.count("bus_velocity"s) > 0) {
+    result.profile.bus_velocity = request.at("bus_velocity"s).AsDouble();
+  }
+  if (request.count("bus_wait_time"s) > 0) {
+    result.profile.bus_wait_time = request.at("bus_wait_time"s).AsDouble();
+  }
+  return result;
+}
+
+IsochroneRequest ParseIsochroneRequest(const json::Dict &request) {
+  IsochroneRequest result;
+  result.id = request.at("id"s).AsInt();
+  result.from = request.at("from"s).AsString();
+  result.max_time = request.at("max_time"s).AsDouble();
+  return result;
+}
+
+vector<string> ParseStopNames(const json::Array &stop_names) {
+  vector<string> result;
+  result.reserve(stop_names.size());
+  for (const auto &node : stop_names) {
+    result.push_back(node.AsString());
+  }
+  return result;
+}
+
+RouteMatrixRequest ParseRouteMatrixRequest(const json::Dict &request) {
+  RouteMatrixRequest result;
+  result.id = request.at("id"s).AsInt();
+  result.from = ParseStopNames(request.at("from"s).AsArray());
+  result.to = ParseStopNames(request.at("to"s).AsArray());
+  if (request.count("with_steps"s) > 0) {
+    result.with_steps = request.at("with_steps"s).AsBool();
+  }
+  return result;
 }
 
 vector<StatRequest> ParseStatRequests(const json::Array &stat_requests) {
@@ -98,6 +148,10 @@ vector<StatRequest> ParseStatRequests(const json::Array &stat_requests) {
       result.emplace_back(MapRequest{request.at("id"s).AsInt()});
     } else if (type == "Route"s) {
       result.emplace_back(ParseRouteRequest(request));
+    } else if (type == "RouteMatrix"s) {
+      result.emplace_back(ParseRouteMatrixRequest(request));
+    } else if (type == "Isochrone"s) {
+      result.emplace_back(ParseIsochroneRequest(request));
     } else {
       throw invalid_argument("Unknown stat request with type '"s + type + "'"s);
     }
@@ -159,17 +213,85 @@ struct ResponseVariantPrinter {
   }
 
   void operator()(const router::RouteResult &route_result) {
-    auto items = StartCommonJsonDict().Key("items"s).StartArray();
+    PrintRoute(SerializeRoute(route_result));
+  }
 
+  /**
+   * Поля ответа на запрос маршрута без "request_id": он один отличается у
+   * повторных запросов того же маршрута. Печатаются `PrintRoute`.
+   */
+  static SerializedRoute SerializeRoute(
+      const router::RouteResult &route_result) {
+    json::Array items;
     for (const auto &action : route_result.steps) {
-      items.Value(GetRouteActionJson(action));
+      items.push_back(GetRouteActionJson(action));
     }
-    json::Print(json::Document{items.EndArray()
-                                   .Key("total_time"s)
-                                   .Value(route_result.time / 60)
-                                   .EndDict()
-                                   .Build()},
-                out);
+    SerializedRoute result;
+    ostringstream sout;
+    json::Print(json::Document{move(items)}, sout);
+    result.items = sout.str();
+    sout.str({});
+    json::Print(json::Document{route_result.time / 60}, sout);
+    result.total_time = sout.str();
+    return result;
+  }
+
+  /**
+   * Напечатать словарь ответа из полей `serialized` и "request_id" в том же
+   * порядке ключей, что и у `json::Print`.
+   */
+  void PrintRoute(const SerializedRoute &serialized) {
+    out << "{\"items\":"sv << serialized.items << ",\"request_id\":"sv;
+    json::Print(json::Document{request_id}, out);
+    out << ",\"total_time\":"sv << serialized.total_time << '}';
+  }
+
+  void operator()(const router::RouteMatrix &matrix) {
+    json::Array times;
+    json::Array items;
+    for (size_t i = 0; i < matrix.from_count; ++i) {
+      json::Array times_row;
+      json::Array items_row;
+      for (size_t j = 0; j < matrix.to_count; ++j) {
+        const size_t index = i * matrix.to_count + j;
+        const auto &time = matrix.times[index];
+        times_row.push_back(time ? json::Node{*time / 60}
+                                 : json::Node{nullptr});
+        if (!matrix.steps.empty()) {
+          if (!time) {
+            items_row.push_back(nullptr);
+            continue;
+          }
+          json::Array route_items;
+          for (const auto &action : matrix.steps[index]) {
+            route_items.push_back(GetRouteActionJson(action));
+          }
+          items_row.push_back(move(route_items));
+        }
+      }
+      times.push_back(move(times_row));
+      items.push_back(move(items_row));
+    }
+
+    auto response = StartCommonJsonDict().Key("times"s).Value(move(times));
+    if (!matrix.steps.empty()) {
+      response = response.Key("items"s).Value(move(items));
+    }
+    json::Print(json::Document{response.EndDict().Build()}, out);
+  }
+
+  void operator()(const router::Isochrone &isochrone) {
+    auto stops = StartCommonJsonDict().Key("stops"s).StartArray();
+    for (const auto &stop : isochrone.stops) {
+      stops.Value(
+          // clang-format off
+          json::Builder{}.StartDict()
+            .Key("stop_name"s).Value(string{stop.stop_name})
+            .Key("time"s).Value(stop.time / 60)
+          .EndDict().Build().AsMap());
+      // clang-format on
+    }
+    json::Print(json::Document{stops.EndArray().EndDict().Build()}, out);
   }
 
   static json::Dict GetRouteActionJson(const router::RouteAction &step) {
@@ -268,10 +390,99 @@ RenderSettings ParseRenderSettings(const json::Dict &rs) {
   return result;
 }
 
+/**
+ * Парсит название алгоритма поиска маршрутов
+ */
+router::RouterEngine ParseRouterEngine(const string &name) {
+  if (name == "floyd_warshall"s) {
+    return router::RouterEngine::FLOYD_WARSHALL;
+  } else if (name == "dijkstra"s) {
+    return router::RouterEngine::DIJKSTRA;
+  } else if (name == "bidirectional_dijkstra"s) {
+    return router::RouterEngine::BIDIRECTIONAL_DIJKSTRA;
+  } else if (name == "a_star"s) {
+    return router::RouterEngine::A_STAR;
+  } else if (name == "alt"s) {
+    return router::RouterEngine::ALT;
+  } else if (name == "contraction_hierarchy"s) {
+    return router::RouterEngine::CONTRACTION_HIERARCHY;
+  } else if (name == "hub_labels"s) {
+    return router::RouterEngine::HUB_LABELS;
+  } else if (name == "raptor"s) {
+    return router::RouterEngine::RAPTOR;
+  }
+  throw invalid_argument("Unknown router engine '"s + name + "'"s);
+}
+
+/**
+ * Парсит название модели графа остановок
+ */
+router::GraphModel ParseGraphModel(const string &name) {
+  if (name == "all_pairs"s) {
+    return router::GraphModel::ALL_PAIRS;
+  } else if (name == "ride_chain"s) {
+    return router::GraphModel::RIDE_CHAIN;
+  } else if (name == "wait_free"s) {
+    return router::GraphModel::WAIT_FREE;
+  }
+  throw invalid_argument("Unknown graph model '"s + name + "'"s);
+}
+
+/**
+ * Неотрицательное целое под ключом `key`: отрицательное число при записи в
+ * `size_t` превратилось бы в огромное. Кидает `invalid_argument`.
+ */
+size_t ParseRouterSize(const json::Dict &map, const string &key) {
+  const int value = map.at(key).AsInt();
+  if (value < 0) {
+    throw invalid_argument("Router setting '"s + key +
+                           "' should be non-negative"s);
+  }
+  return static_cast<size_t>(value);
+}
+
 RouterSettings ParseRouterSettings(const json::Dict &map) {
   RouterSettings result;
   result.bus_velocity = map.at("bus_velocity"s).AsDouble();
   result.bus_wait_time = map.at("bus_wait_time"s).AsDouble();
+  if (map.count("router_engine"s) > 0) {
+    result.engine = ParseRouterEngine(map.at("router_engine"s).AsString());
+  }
+  if (map.count("graph_model"s) > 0) {
+    result.graph_model = ParseGraphModel(map.at("graph_model"s).AsString());
+  }
+  if (map.count("prune_bus_edges"s) > 0) {
+    result.prune_bus_edges = map.at("prune_bus_edges"s).AsBool();
+  }
+  if (map.count("reduce_to_transfer_stops"s) > 0) {
+    result.reduce_to_transfer_stops =
+        map.at("reduce_to_transfer_stops"s).AsBool();
+  }
+  if (map.count("reorder_vertices"s) > 0) {
+    result.reorder_vertices = map.at("reorder_vertices"s).AsBool();
+  }
+  if (map.count("use_reachability_index"s) > 0) {
+    result.use_reachability_index =
+        map.at("use_reachability_index"s).AsBool();
+  }
+  if (map.count("landmark_count"s) > 0) {
+    result.landmark_count = ParseRouterSize(map, "landmark_count"s);
+  }
+  if (map.count("router_threads"s) > 0) {
+    result.router_threads = ParseRouterSize(map, "router_threads"s);
+  }
+  if (map.count("tree_cache_size"s) > 0) {
+    result.tree_cache_size = ParseRouterSize(map, "tree_cache_size"s);
+  }
+  if (map.count("profile_cache_size"s) > 0) {
+    result.profile_cache_size = ParseRouterSize(map, "profile_cache_size"s);
+  }
+  if (map.count("route_cache_size"s) > 0) {
+    result.route_cache_size = ParseRouterSize(map, "route_cache_size"s);
+  }
+  if (map.count("cache_file"s) > 0) {
+    result.cache_file = map.at("cache_file"s).AsString();
+  }
   return result;
 }
 
@@ -315,6 +526,26 @@ void ResponsePrinter::PrintResponse(int request_id,
   printed_something_ = true;
 }
 
+/**
+ * Печатает ответ на запрос маршрута из `serialized`, а если он пустой -
+ * сначала сохраняет туда поля ответа без "request_id".
+ */
+void ResponsePrinter::PrintRouteResponse(int request_id,
+                                         const router::RouteResult &route,
+                                         SerializedRoute &serialized) {
+  if (printed_something_) {
+    out_.put(',');
+  } else {
+    Begin();
+  }
+  if (serialized.items.empty()) {
+    serialized = detail::ResponseVariantPrinter::SerializeRoute(route);
+  }
+  detail::ResponseVariantPrinter printer{request_id, out_};
+  printer.PrintRoute(serialized);
+  printed_something_ = true;
+}
+
 ResponsePrinter::~ResponsePrinter() {
   if (printed_something_) {
     End();
@@ -2,6 +2,7 @@
 
 #include <iostream>
 #include <optional>
+#include <string>
 #include <vector>
 
 #include "map_renderer.h"
@@ -16,6 +17,7 @@ using transport_catalogue::request_handler::BaseRequest;
 using transport_catalogue::request_handler::StatRequest;
 
 using transport_catalogue::request_handler::AbstractStatResponsePrinter;
+using transport_catalogue::request_handler::SerializedRoute;
 using transport_catalogue::request_handler::StatResponse;
 using transport_catalogue::router::RouterSettings;
 
@@ -32,6 +34,8 @@ using transport_catalogue::router::RouterSettings;
  *   "stat_requests": [<запросы на получение статистики из справочника>],
  *   // может отсутствовать
  *   "render_settings": { <настройки отрисовки карты в SVG формате> },
+ *   // может отсутствовать
+ *   "routing_settings": { <настройки поиска маршрутов> },
  * }
  * ```
  *
@@ -62,7 +66,15 @@ using transport_catalogue::router::RouterSettings;
  *     "Улица Докучаева",
  *     "Улица Лизы Чайкиной"
  *   ],
- *   "is_roundtrip": true
+ *   "is_roundtrip": true,
+ *   // рейсы по расписанию, необязательный параметр: время отправления с
+ *   // каждой остановки рейса в минутах от начала суток. Линейный маршрут
+ *   // проезжается туда и обратно, у кольцевого последняя остановка -
+ *   // снова первая
+ *   "trips": [
+ *     [480, 485, 492, 500],
+ *     [540, 545, 552, 560]
+ *   ]
  * }
  * ```
  *
@@ -99,6 +111,62 @@ using transport_catalogue::router::RouterSettings;
  * }
  * ```
  *
+ * Настройки поиска маршрутов:
+ * ```
+ * {
+ *   "bus_velocity": 40,    // скорость автобуса в км/ч
+ *   "bus_wait_time": 6,    // время ожидания автобуса на остановке в минутах
+ *   // алгоритм поиска маршрутов, необязательный параметр:
+ *   // "floyd_warshall" (по умолчанию), "dijkstra", "bidirectional_dijkstra",
+ *   // "a_star", "alt", "contraction_hierarchy", "hub_labels", "raptor"
+ *   "router_engine": "dijkstra",
+ *   // как автобусы представлены в графе остановок, необязательный параметр:
+ *   // "all_pairs" (по умолчанию) - ребро между каждой парой остановок
+ *   // автобуса, "ride_chain" - цепочка перегонов с посадкой и высадкой,
+ *   // линейная по длине маршрута, "wait_free" - рёбра как в "all_pairs",
+ *   // но с ожиданием в весе рёбер автобусов и вдвое меньшим числом вершин
+ *   "graph_model": "ride_chain",
+ *   // для "all_pairs" и "wait_free": оставлять между парой остановок только
+ *   // самое быстрое ребро из всех автобусов, необязательный параметр, по
+ *   // умолчанию false
+ *   "prune_bus_edges": true,
+ *   // для "floyd_warshall" и "all_pairs": считать таблицу маршрутов только
+ *   // между пересадочными остановками (с несколькими автобусами и
+ *   // конечными), остальные присоединять при запросе. Необязательный
+ *   // параметр, по умолчанию false
+ *   "reduce_to_transfer_stops": true,
+ *   // нумеровать вершины графа остановок вдоль кривой Гильберта по
+ *   // координатам остановок для локальности в памяти, необязательный
+ *   // параметр, по умолчанию false
+ *   "reorder_vertices": true,
+ *   // строить индекс достижимости, чтобы маршруты между несвязанными
+ *   // сетями отвечались без поиска, необязательный параметр, по умолчанию
+ *   // false
+ *   "use_reachability_index": true,
+ *   // сколько ориентиров выбирать для "alt", необязательный параметр
+ *   "landmark_count": 8,
+ *   // сколько потоков строят граф остановок и считают таблицу
+ *   // "floyd_warshall", 0 - по числу ядер, необязательный параметр,
+ *   // по умолчанию 1
+ *   "router_threads": 4,
+ *   // сколько деревьев кратчайших путей из популярных остановок держать в
+ *   // кэше, необязательный параметр, по умолчанию 0 - кэш выключен
+ *   "tree_cache_size": 16,
+ *   // сколько графов с весами под скорость и время ожидания из запросов
+ *   // "Route" держать в кэше, необязательный параметр, по умолчанию 4
+ *   "profile_cache_size": 4,
+ *   // сколько ответов на запросы "Route" держать в кэше, чтобы повторный
+ *   // запрос того же маршрута не искался и не печатался заново,
+ *   // необязательный параметр, по умолчанию 0 - кэш выключен. Число
+ *   // попаданий и промахов кэша печатается в stderr
+ *   "route_cache_size": 256,
+ *   // файл, в который сохраняется граф остановок с посчитанной таблицей
+ *   // маршрутов и из которого они загружаются при следующем запуске, если
+ *   // справочник и настройки не изменились. Необязательный параметр
+ *   "cache_file": "router.bin"
+ * }
+ * ```
+ *
  * Запросы на получение статистики бывают такими.
  *
  * Получить статистику по остановке:
@@ -126,6 +194,49 @@ using transport_catalogue::router::RouterSettings;
  *   "type": "Map"
  * }
  * ```
+ *
+ * Получить маршрут между остановками:
+ * ```
+ * {
+ *   "id": 12348,
+ *   "type": "Route",
+ *   "from": "Улица Докучаева",
+ *   "to": "Электросети",
+ *   // время отправления в минутах от начала суток, необязательный параметр.
+ *   // Если задано, маршрут ищется по расписанию рейсов ("trips") с самым
+ *   // ранним прибытием, а время ожидания в ответе - до отправления рейса
+ *   "departure_time": 475,
+ *   // скорость автобусов и время ожидания для этого запроса вместо
+ *   // "routing_settings", необязательные параметры. Граф остановок не
+ *   // перестраивается, по расписанию эти параметры не используются
+ *   "bus_velocity": 30,
+ *   "bus_wait_time": 4
+ * }
+ * ```
+ *
+ * Получить матрицу маршрутов из каждой остановки `from` в каждую остановку
+ * `to`:
+ * ```
+ * {
+ *   "id": 12347,
+ *   "type": "RouteMatrix",
+ *   "from": ["Улица Докучаева", "Электросети"],
+ *   "to": ["Ривьерский мост"],
+ *   // нужны ли шаги маршрутов, необязательный параметр, по умолчанию false
+ *   "with_steps": false
+ * }
+ * ```
+ *
+ * Получить все остановки, до которых можно доехать из `from` не дольше
+ * `max_time` минут:
+ * ```
+ * {
+ *   "id": 12349,
+ *   "type": "Isochrone",
+ *   "from": "Улица Докучаева",
+ *   "max_time": 15
+ * }
+ * ```
  */
 class BufferingRequestReader final : public AbstractBufferingRequestReader {
  public:
@@ -198,6 +309,29 @@ class BufferingRequestReader final : public AbstractBufferingRequestReader {
  * }
  * ```
  *
+ * Матрица маршрутов: время в пути в минутах по строкам начальных остановок,
+ * `null` - маршрута нет. Если запрошены шаги маршрутов, они лежат в "items" в
+ * том же порядке, в том же формате, что и в ответе на запрос маршрута:
+ * ```
+ * {
+ *   "request_id": 12347,
+ *   "times": [[11.5], [null]],
+ *   "items": [[[{"type": "Wait", ...}, {"type": "Bus", ...}]], [null]]
+ * }
+ * ```
+ *
+ * Остановки в пределах времени: время в пути в минутах, по возрастанию
+ * времени:
+ * ```
+ * {
+ *   "request_id": 12349,
+ *   "stops": [
+ *     {"stop_name": "Улица Докучаева", "time": 0},
+ *     {"stop_name": "Электросети", "time": 11.5}
+ *   ]
+ * }
+ * ```
+ *
  * Если был сделан запрос на статистику по несуществующему объекту,
  * печатается сообщение об ошибке:
  * ```
@@ -211,6 +345,9 @@ class ResponsePrinter final : public AbstractStatResponsePrinter {
  public:
   ResponsePrinter(std::ostream&);
   virtual void PrintResponse(int request_id, const StatResponse&) override;
+  virtual void PrintRouteResponse(int request_id,
+                                  const router::RouteResult& route,
+                                  SerializedRoute& serialized) override;
   ~ResponsePrinter();
 
  private:
@@ -1,4 +1,5 @@
 #include <iostream>
+#include <string_view>
 
 #include "json_reader.h"
 #include "request_handler.h"
@@ -15,4 +16,12 @@ int main() {
   json_reader::ResponsePrinter response_printer{cout};
 
   request_handler.ProcessRequests(response_printer);
+
+  // в stdout только ответы, статистика кэша - в stderr
+  const auto &route_cache_stats = request_handler.GetRouteCacheStats();
+  if (route_cache_stats.hits + route_cache_stats.misses > 0) {
+    cerr << "route cache: "sv << route_cache_stats.hits << " hits, "sv
+         << route_cache_stats.misses << " misses, "sv
+         << route_cache_stats.evictions << " evictions"sv << endl;
+  }
 }
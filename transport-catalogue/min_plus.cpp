@@ -0,0 +1,193 @@
+#include "min_plus.h"
+
+#include <initializer_list>
+
+#if defined(__x86_64__) && (defined(__GNUC__) || defined(__clang__))
+#define MIN_PLUS_X86
+#include <immintrin.h>
+#endif
+
+namespace graph::detail {
+
+namespace {
+
+#ifdef MIN_PLUS_X86
+
+/**
+ * Побитовый выбор: биты `b` там, где в `mask` единицы, иначе биты `a`.
+ * В SSE2 нет `blendv`.
+ */
+__m128i Blend(__m128i a, __m128i b, __m128i mask) {
+  return _mm_or_si128(_mm_and_si128(mask, b), _mm_andnot_si128(mask, a));
+}
+
+template <typename EdgeIndex>
+void RelaxRowSse2(double weight_from, const double *through_weights,
+                  EdgeIndex prev_edge_from,
+                  const EdgeIndex *through_prev_edges, double *row_weights,
+                  EdgeIndex *row_prev_edges, size_t count) {
+  const __m128d from = _mm_set1_pd(weight_from);
+  const __m128i all_ones = _mm_set1_epi32(-1);
+  size_t i = 0;
+  for (; i + 2 <= count; i += 2) {
+    const __m128d candidate =
+        _mm_add_pd(from, _mm_loadu_pd(through_weights + i));
+    const __m128d current = _mm_loadu_pd(row_weights + i);
+    const __m128d less = _mm_cmplt_pd(candidate, current);
+    if (_mm_movemask_pd(less) == 0) {
+      continue;
+    }
+    _mm_storeu_pd(row_weights + i, _mm_or_pd(_mm_and_pd(less, candidate),
+                                             _mm_andnot_pd(less, current)));
+    const __m128i less_mask = _mm_castpd_si128(less);
+    if constexpr (sizeof(EdgeIndex) == sizeof(uint32_t)) {
+      // маски 64-битных весов сжимаются до 32-битных номеров рёбер
+      const __m128i mask =
+          _mm_shuffle_epi32(less_mask, _MM_SHUFFLE(2, 0, 2, 0));
+      const __m128i through = _mm_loadl_epi64(
+          reinterpret_cast<const __m128i *>(through_prev_edges + i));
+      const __m128i prev = Blend(
+          through, _mm_set1_epi32(static_cast<int>(prev_edge_from)),
+          _mm_cmpeq_epi32(through, all_ones));
+      auto *row_prev = reinterpret_cast<__m128i *>(row_prev_edges + i);
+      _mm_storel_epi64(row_prev, Blend(_mm_loadl_epi64(row_prev), prev, mask));
+    } else {
+      const __m128i through = _mm_loadu_si128(
+          reinterpret_cast<const __m128i *>(through_prev_edges + i));
+      // в SSE2 нет сравнения 64-битных чисел: обе половины должны совпасть
+      const __m128i equal_halves = _mm_cmpeq_epi32(through, all_ones);
+      const __m128i swapped_halves =
+          _mm_shuffle_epi32(equal_halves, _MM_SHUFFLE(2, 3, 0, 1));
+      const __m128i no_edge = _mm_and_si128(equal_halves, swapped_halves);
+      const __m128i prev = Blend(
+          through, _mm_set1_epi64x(static_cast<long long>(prev_edge_from)),
+          no_edge);
+      auto *row_prev = reinterpret_cast<__m128i *>(row_prev_edges + i);
+      _mm_storeu_si128(row_prev,
+                       Blend(_mm_loadu_si128(row_prev), prev, less_mask));
+    }
+  }
+  RelaxRowMinPlusScalar(weight_from, through_weights + i, prev_edge_from,
+                        through_prev_edges + i, row_weights + i,
+                        row_prev_edges + i, count - i);
+}
+
+template <typename EdgeIndex>
+__attribute__((target("avx2"))) void RelaxRowAvx2(
+    double weight_from, const double *through_weights,
+    EdgeIndex prev_edge_from, const EdgeIndex *through_prev_edges,
+    double *row_weights, EdgeIndex *row_prev_edges, size_t count) {
+  const __m256d from = _mm256_set1_pd(weight_from);
+  size_t i = 0;
+  for (; i + 4 <= count; i += 4) {
+    const __m256d candidate =
+        _mm256_add_pd(from, _mm256_loadu_pd(through_weights + i));
+    const __m256d current = _mm256_loadu_pd(row_weights + i);
+    const __m256d less = _mm256_cmp_pd(candidate, current, _CMP_LT_OQ);
+    if (_mm256_movemask_pd(less) == 0) {
+      continue;
+    }
+    _mm256_storeu_pd(row_weights + i,
+                     _mm256_blendv_pd(current, candidate, less));
+    const __m256i less_mask = _mm256_castpd_si256(less);
+    if constexpr (sizeof(EdgeIndex) == sizeof(uint32_t)) {
+      // маски 64-битных весов сжимаются до 32-битных номеров рёбер
+      const __m128i mask = _mm256_castsi256_si128(_mm256_permutevar8x32_epi32(
+          less_mask, _mm256_setr_epi32(0, 2, 4, 6, 0, 2, 4, 6)));
+      const __m128i through = _mm_loadu_si128(
+          reinterpret_cast<const __m128i *>(through_prev_edges + i));
+      const __m128i prev = _mm_blendv_epi8(
+          through, _mm_set1_epi32(static_cast<int>(prev_edge_from)),
+          _mm_cmpeq_epi32(through, _mm_set1_epi32(-1)));
+      auto *row_prev = reinterpret_cast<__m128i *>(row_prev_edges + i);
+      _mm_storeu_si128(row_prev,
+                       _mm_blendv_epi8(_mm_loadu_si128(row_prev), prev, mask));
+    } else {
+      const __m256i through = _mm256_loadu_si256(
+          reinterpret_cast<const __m256i *>(through_prev_edges + i));
+      const __m256i prev = _mm256_blendv_epi8(
+          through, _mm256_set1_epi64x(static_cast<long long>(prev_edge_from)),
+          _mm256_cmpeq_epi64(through, _mm256_set1_epi64x(-1)));
+      auto *row_prev = reinterpret_cast<__m256i *>(row_prev_edges + i);
+      _mm256_storeu_si256(row_prev, _mm256_blendv_epi8(
+                                        _mm256_loadu_si256(row_prev), prev,
+                                        less_mask));
+    }
+  }
+  RelaxRowMinPlusScalar(weight_from, through_weights + i, prev_edge_from,
+                        through_prev_edges + i, row_weights + i,
+                        row_prev_edges + i, count - i);
+}
+
+#endif  // MIN_PLUS_X86
+
+template <typename EdgeIndex>
+void RelaxRow(MinPlusKernel kernel, double weight_from,
+              const double *through_weights, EdgeIndex prev_edge_from,
+              const EdgeIndex *through_prev_edges, double *row_weights,
+              EdgeIndex *row_prev_edges, size_t count) {
+  switch (kernel) {
+#ifdef MIN_PLUS_X86
+    case MinPlusKernel::AVX2:
+      RelaxRowAvx2(weight_from, through_weights, prev_edge_from,
+                   through_prev_edges, row_weights, row_prev_edges, count);
+      return;
+    case MinPlusKernel::SSE2:
+      RelaxRowSse2(weight_from, through_weights, prev_edge_from,
+                   through_prev_edges, row_weights, row_prev_edges, count);
+      return;
+#endif
+    default:
+      RelaxRowMinPlusScalar(weight_from, through_weights, prev_edge_from,
+                            through_prev_edges, row_weights, row_prev_edges,
+                            count);
+      return;
+  }
+}
+
+}  // namespace
+
+bool IsMinPlusKernelSupported(MinPlusKernel kernel) {
+  switch (kernel) {
+    case MinPlusKernel::SCALAR:
+      return true;
+#ifdef MIN_PLUS_X86
+    case MinPlusKernel::SSE2:
+      return true;
+    case MinPlusKernel::AVX2:
+      return __builtin_cpu_supports("avx2");
+#endif
+    default:
+      return false;
+  }
+}
+
+MinPlusKernel GetBestMinPlusKernel() {
+  static const MinPlusKernel best_kernel = [] {
+    for (MinPlusKernel kernel : {MinPlusKernel::AVX2, MinPlusKernel::SSE2}) {
+      if (IsMinPlusKernelSupported(kernel)) {
+        return kernel;
+      }
+    }
+    return MinPlusKernel::SCALAR;
+  }();
+  return best_kernel;
+}
+
+void RelaxRowMinPlus(MinPlusKernel kernel, double weight_from,
+                     const double *through_weights, uint32_t prev_edge_from,
+                     const uint32_t *through_prev_edges, double *row_weights,
+                     uint32_t *row_prev_edges, size_t count) {
+  RelaxRow(kernel, weight_from, through_weights, prev_edge_from,
+           through_prev_edges, row_weights, row_prev_edges, count);
+}
+
+void RelaxRowMinPlus(MinPlusKernel kernel, double weight_from,
+                     const double *through_weights, uint64_t prev_edge_from,
+                     const uint64_t *through_prev_edges, double *row_weights,
+                     uint64_t *row_prev_edges, size_t count) {
+  RelaxRow(kernel, weight_from, through_weights, prev_edge_from,
+           through_prev_edges, row_weights, row_prev_edges, count);
+}
+
+}  // namespace graph::detail
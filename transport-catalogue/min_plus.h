@@ -0,0 +1,66 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+
+namespace graph::detail {
+
+/**
+ * Реализация релаксации строки таблицы `graph::Router` для весов `double`.
+ */
+enum MinPlusKernel {
+  // поэлементный цикл, работает везде
+  SCALAR,
+  // по 2 ячейки за шаг, есть на любом x86-64
+  SSE2,
+  // по 4 ячейки за шаг, выбирается, если процессор поддерживает AVX2
+  AVX2,
+};
+
+bool IsMinPlusKernelSupported(MinPlusKernel kernel);
+
+/**
+ * Самая быстрая реализация, которую поддерживает процессор. Определяется
+ * при первом вызове.
+ */
+MinPlusKernel GetBestMinPlusKernel();
+
+/**
+ * Для каждой ячейки `i < count`: если `weight_from + through_weights[i]`
+ * меньше `row_weights[i]`, записывает сумму в `row_weights[i]`, а в
+ * `row_prev_edges[i]` - `through_prev_edges[i]` или, если там `NO_EDGE`,
+ * `prev_edge_from`. Недостижимые ячейки - бесконечность.
+ *
+ * Все реализации складывают и сравнивают те же числа, поэтому результат
+ * не зависит от `kernel`.
+ */
+template <typename EdgeIndex>
+void RelaxRowMinPlusScalar(double weight_from, const double *through_weights,
+                           EdgeIndex prev_edge_from,
+                           const EdgeIndex *through_prev_edges,
+                           double *row_weights, EdgeIndex *row_prev_edges,
+                           size_t count) {
+  constexpr EdgeIndex NO_EDGE = std::numeric_limits<EdgeIndex>::max();
+  for (size_t i = 0; i < count; ++i) {
+    const double candidate_weight = weight_from + through_weights[i];
+    if (candidate_weight < row_weights[i]) {
+      row_weights[i] = candidate_weight;
+      row_prev_edges[i] = through_prev_edges[i] != NO_EDGE
+                              ? through_prev_edges[i]
+                              : prev_edge_from;
+    }
+  }
+}
+
+void RelaxRowMinPlus(MinPlusKernel kernel, double weight_from,
+                     const double *through_weights, uint32_t prev_edge_from,
+                     const uint32_t *through_prev_edges, double *row_weights,
+                     uint32_t *row_prev_edges, size_t count);
+
+void RelaxRowMinPlus(MinPlusKernel kernel, double weight_from,
+                     const double *through_weights, uint64_t prev_edge_from,
+                     const uint64_t *through_prev_edges, double *row_weights,
+                     uint64_t *row_prev_edges, size_t count);
+
+}  // namespace graph::detail
@@ -0,0 +1,287 @@
+#include "raptor_router.h"
+
+#include <algorithm>
+#include <limits>
+#include <string>
+#include <utility>
+
+#include "domain.h"
+#include "transport_catalogue.h"
+
+using namespace std;
+
+namespace transport_catalogue::router {
+
+namespace {
+
+constexpr double UNREACHABLE = numeric_limits<double>::infinity();
+constexpr size_t NO_POSITION = numeric_limits<size_t>::max();
+
+}  // namespace
+
+RaptorRouter::RaptorRouter(const RouterSettings &settings,
+                           const TransportCatalogue &transport_catalogue)
+    : bus_velocity_(settings.bus_velocity * 1000 / 3600),
+      bus_wait_time_(settings.bus_wait_time * 60),
+      stops_(transport_catalogue.GetStops()) {
+  unordered_map<const Stop *, StopIndex> index;
+  for (StopIndex i = 0; i < stops_.size(); ++i) {
+    index[stops_[i]] = i;
+    stop_by_name_[string_view{stops_[i]->name}] = i;
+  }
+
+  for (const Bus *bus : transport_catalogue.GetBuses()) {
+    if (bus->stops.size() < 2) {
+      continue;
+    }
+    if (bus->route_type == RouteType::CIRCULAR) {
+      auto stops = bus->stops;
+      stops.push_back(stops.front());
+      AddPattern(transport_catalogue, bus, move(stops), false, index);
+    } else {
+      AddPattern(transport_catalogue, bus, bus->stops, false, index);
+      AddPattern(transport_catalogue, bus,
+                 {bus->stops.rbegin(), bus->stops.rend()}, true, index);
+    }
+  }
+
+  // индекс "остановка -> проезды" в формате CSR
+  stop_pattern_offsets_.assign(stops_.size() + 1, 0);
+  for (const auto &pattern : patterns_) {
+    for (StopIndex stop : pattern.stops) {
+      ++stop_pattern_offsets_[stop + 1];
+    }
+  }
+  for (size_t i = 0; i < stops_.size(); ++i) {
+    stop_pattern_offsets_[i + 1] += stop_pattern_offsets_[i];
+  }
+  stop_patterns_.resize(stop_pattern_offsets_.back());
+  vector<size_t> fill = stop_pattern_offsets_;
+  for (size_t p = 0; p < patterns_.size(); ++p) {
+    const auto &pattern_stops = patterns_[p].stops;
+    for (size_t position = 0; position < pattern_stops.size(); ++position) {
+      stop_patterns_[fill[pattern_stops[position]]++] = {p, position};
+    }
+  }
+}
+
+void RaptorRouter::AddPattern(
+    const TransportCatalogue &transport_catalogue, const Bus *bus,
+    vector<const Stop *> stops, bool is_reversed,
+    const unordered_map<const Stop *, StopIndex> &index) {
+  Pattern pattern;
+  pattern.bus = bus;
+  pattern.is_reversed = is_reversed;
+  pattern.stops.reserve(stops.size());
+  pattern.prefix_lengths.reserve(stops.size());
+  pattern.prefix_lengths.push_back(0);
+  for (size_t i = 0; i < stops.size(); ++i) {
+    pattern.stops.push_back(index.at(stops[i]));
+    if (i + 1 < stops.size()) {
+      pattern.prefix_lengths.push_back(
+          pattern.prefix_lengths.back() +
+          transport_catalogue.GetRealDistance(stops[i], stops[i + 1]));
+    }
+  }
+  patterns_.push_back(move(pattern));
+}
+
+optional<RaptorRouter::StopIndex> RaptorRouter::FindStop(
+    string_view name) const {
+  if (auto it = stop_by_name_.find(name); it != stop_by_name_.end()) {
+    return it->second;
+  }
+  return nullopt;
+}
+
+/**
+ * Раунды поиска из остановки `from`. Если задана `to`, поездки, которые не
+ * быстрее уже найденного маршрута до `to`, отбрасываются.
+ *
+ * Метки раунда `k` начинаются с копии меток раунда `k - 1`, так что в
+ * последнем раунде лежит лучшее время до каждой остановки.
+ */
+RaptorRouter::Rounds RaptorRouter::Search(StopIndex from,
+                                          optional<StopIndex> to) const {
+  const size_t stop_count = stops_.size();
+  Rounds rounds;
+  rounds.emplace_back(stop_count, Label{UNREACHABLE, nullopt, 0});
+  rounds[0][from].time = 0;
+  vector<double> best_times(stop_count, UNREACHABLE);
+  best_times[from] = 0;
+
+  vector<bool> is_marked(stop_count, false);
+  vector<StopIndex> marked_stops{from};
+  is_marked[from] = true;
+  // с какой позиции просматривать проезд в текущем раунде
+  vector<size_t> first_positions(patterns_.size(), NO_POSITION);
+  vector<size_t> queued_patterns;
+
+  while (!marked_stops.empty()) {
+    const size_t round = rounds.size();
+    rounds.push_back(rounds.back());
+    const auto &prev = rounds[round - 1];
+    auto &current = rounds[round];
+
+    for (StopIndex stop : marked_stops) {
+      is_marked[stop] = false;
+      for (size_t i = stop_pattern_offsets_[stop];
+           i < stop_pattern_offsets_[stop + 1]; ++i) {
+        const auto [pattern, position] = stop_patterns_[i];
+        if (first_positions[pattern] == NO_POSITION) {
+          queued_patterns.push_back(pattern);
+        }
+        first_positions[pattern] = min(first_positions[pattern], position);
+      }
+    }
+    marked_stops.clear();
+
+    for (size_t p : queued_patterns) {
+      const auto &pattern = patterns_[p];
+      const size_t length = pattern.stops.size();
+      // позиция посадки и время отправления с неё, включая ожидание
+      optional<size_t> board;
+      double departure = 0;
+      for (size_t position = first_positions[p]; position < length;
+           ++position) {
+        const StopIndex stop = pattern.stops[position];
+        double arrival = UNREACHABLE;
+        if (board) {
+          arrival = departure + (pattern.prefix_lengths[position] -
+                                 pattern.prefix_lengths[*board]) /
+                                    bus_velocity_;
+          const double bound =
+              to ? min(best_times[stop], best_times[*to]) : best_times[stop];
+          if (arrival < bound) {
+            current[stop] = {arrival, Leg{p, *board, position}, round};
+            best_times[stop] = arrival;
+            if (!is_marked[stop]) {
+              is_marked[stop] = true;
+              marked_stops.push_back(stop);
+            }
+          }
+        }
+        // сесть здесь заново, с ожиданием, выгоднее, чем остаться в автобусе
+        if (position + 1 < length && prev[stop].time != UNREACHABLE) {
+          const double stop_departure = prev[stop].time + bus_wait_time_;
+          if (!board || stop_departure < arrival) {
+            board = position;
+            departure = stop_departure;
+          }
+        }
+      }
+      first_positions[p] = NO_POSITION;
+    }
+    queued_patterns.clear();
+  }
+
+  return rounds;
+}
+
+/**
+ * Длина поездки, сложенная в том же порядке, что и длина ребра графа
+ * остановок, чтобы время шага совпадало до последнего бита.
+ */
+double RaptorRouter::GetLegLength(const Leg &leg) const {
+  const auto &prefix = patterns_[leg.pattern].prefix_lengths;
+  double length = 0;
+  if (patterns_[leg.pattern].is_reversed) {
+    for (size_t i = leg.alight; i > leg.board; --i) {
+      length += prefix[i] - prefix[i - 1];
+    }
+  } else {
+    for (size_t i = leg.board; i < leg.alight; ++i) {
+      length += prefix[i + 1] - prefix[i];
+    }
+  }
+  return length;
+}
+
+vector<RouteAction> RaptorRouter::ExtractSteps(const Rounds &rounds,
+                                               StopIndex to) const {
+  vector<Leg> legs;
+  const Label *label = &rounds.back()[to];
+  while (label->leg) {
+    const Leg &leg = *label->leg;
+    legs.push_back(leg);
+    label = &rounds[label->round - 1]
+                   [patterns_[leg.pattern].stops[leg.board]];
+  }
+  reverse(legs.begin(), legs.end());
+
+  vector<RouteAction> steps;
+  steps.reserve(legs.size() * 2);
+  for (const Leg &leg : legs) {
+    const auto &pattern = patterns_[leg.pattern];
+    steps.push_back(WaitAction{
+        string_view{stops_[pattern.stops[leg.board]]->name}, bus_wait_time_});
+    steps.push_back(BusAction{string_view{pattern.bus->name},
+                              leg.alight - leg.board,
+                              GetLegLength(leg) / bus_velocity_});
+  }
+  return steps;
+}
+
+optional<RouteResult> RaptorRouter::CalcRoute(string_view from,
+                                              string_view to) const {
+  auto s_from = FindStop(from);
+  auto s_to = FindStop(to);
+  if (!s_from || !s_to) {
+    return nullopt;
+  }
+  const auto rounds = Search(*s_from, *s_to);
+  if (rounds.back()[*s_to].time == UNREACHABLE) {
+    return nullopt;
+  }
+  RouteResult result;
+  result.steps = ExtractSteps(rounds, *s_to);
+  for (const auto &step : result.steps) {
+    result.time += holds_alternative<WaitAction>(step)
+                       ? get<WaitAction>(step).time
+                       : get<BusAction>(step).time;
+  }
+  return result;
+}
+
+/**
+ * Матрица маршрутов: один поиск без цели на каждую начальную остановку.
+ */
+RouteMatrix RaptorRouter::CalcRouteMatrix(const vector<string_view> &from,
+                                          const vector<string_view> &to,
+                                          bool with_steps) const {
+  RouteMatrix result;
+  result.from_count = from.size();
+  result.to_count = to.size();
+  result.times.resize(from.size() * to.size());
+  if (with_steps) {
+    result.steps.resize(from.size() * to.size());
+  }
+
+  vector<optional<StopIndex>> to_stops;
+  to_stops.reserve(to.size());
+  for (string_view stop : to) {
+    to_stops.push_back(FindStop(stop));
+  }
+
+  for (size_t i = 0; i < from.size(); ++i) {
+    auto s_from = FindStop(from[i]);
+    if (!s_from) {
+      continue;
+    }
+    const auto rounds = Search(*s_from, nullopt);
+    for (size_t j = 0; j < to.size(); ++j) {
+      if (!to_stops[j] || rounds.back()[*to_stops[j]].time == UNREACHABLE) {
+        continue;
+      }
+      const size_t index = i * to.size() + j;
+      result.times[index] = rounds.back()[*to_stops[j]].time;
+      if (with_steps) {
+        result.steps[index] = ExtractSteps(rounds, *to_stops[j]);
+      }
+    }
+  }
+
+  return result;
+}
+
+}  // namespace transport_catalogue::router
@@ -0,0 +1,108 @@
+#pragma once
+
+#include <cstddef>
+#include <optional>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+#include "transport_router.h"
+
+namespace transport_catalogue {
+struct Stop;
+struct Bus;
+class TransportCatalogue;
+} /* namespace transport_catalogue */
+
+namespace transport_catalogue::router {
+
+/**
+ * Поиск маршрутов в духе RAPTOR (Round-bAsed Public Transit Optimized
+ * Router) прямо по спискам остановок автобусов, без графа остановок.
+ *
+ * Граф остановок содержит ребро для каждой пары остановок каждого автобуса,
+ * то есть O(n^2) рёбер на маршрут из n остановок. Здесь же хранятся только
+ * сами последовательности остановок с длинами перегонов - O(n) на маршрут.
+ *
+ * Поиск идёт раундами: в раунде `k` находится лучшее время до остановок, до
+ * которых можно доехать не более чем на `k` автобусах. Каждый раунд
+ * просматривает только автобусы через остановки, время до которых улучшилось
+ * в прошлом раунде. Посадка на любой автобус стоит `bus_wait_time`, время
+ * поездки - длина пути, делённая на `bus_velocity`, как и в графе
+ * остановок, поэтому маршруты получаются такими же по времени и из таких же
+ * шагов "Wait" и "Bus".
+ */
+class RaptorRouter {
+ public:
+  RaptorRouter(const RouterSettings &settings,
+               const TransportCatalogue &transport_catalogue);
+
+  std::optional<RouteResult> CalcRoute(std::string_view from,
+                                       std::string_view to) const;
+  RouteMatrix CalcRouteMatrix(const std::vector<std::string_view> &from,
+                              const std::vector<std::string_view> &to,
+                              bool with_steps) const;
+
+ private:
+  using StopIndex = size_t;
+
+  /**
+   * Проезд автобуса в одну сторону. Линейный автобус даёт два проезда, туда
+   * и обратно, кольцевой - один, с первой остановкой ещё раз в конце.
+   *
+   * В графе остановок нельзя проехать кольцо целиком, из первой остановки в
+   * неё же. Здесь такая поездка возможна, но никогда не улучшает время до
+   * первой остановки, поэтому отдельно её запрещать не нужно.
+   */
+  struct Pattern {
+    const Bus *bus;
+    std::vector<StopIndex> stops;
+    // `prefix_lengths[i]` - длина пути от первой остановки до `i`-й
+    std::vector<double> prefix_lengths;
+    // обратный проезд линейного автобуса
+    bool is_reversed = false;
+  };
+
+  // остановка проезда: номер проезда и позиция остановки в нём
+  struct PatternStop {
+    size_t pattern;
+    size_t position;
+  };
+
+  // поездка на автобусе: проезд, позиции посадки и высадки
+  struct Leg {
+    size_t pattern;
+    size_t board;
+    size_t alight;
+  };
+
+  // лучшее время до остановки в раунде, поездка, которой остановка
+  // достигнута, и раунд, в котором это случилось
+  struct Label {
+    double time;
+    std::optional<Leg> leg;
+    size_t round = 0;
+  };
+  using Rounds = std::vector<std::vector<Label>>;
+
+  double bus_velocity_;
+  double bus_wait_time_;
+  std::vector<const Stop *> stops_;
+  std::unordered_map<std::string_view, StopIndex> stop_by_name_;
+  std::vector<Pattern> patterns_;
+  // проезды через остановку `s` лежат в
+  // `stop_patterns_[stop_pattern_offsets_[s] .. stop_pattern_offsets_[s + 1])`
+  std::vector<size_t> stop_pattern_offsets_;
+  std::vector<PatternStop> stop_patterns_;
+
+  void AddPattern(const TransportCatalogue &transport_catalogue, const Bus *bus,
+                  std::vector<const Stop *> stops, bool is_reversed,
+                  const std::unordered_map<const Stop *, StopIndex> &index);
+  std::optional<StopIndex> FindStop(std::string_view name) const;
+  Rounds Search(StopIndex from, std::optional<StopIndex> to) const;
+  double GetLegLength(const Leg &leg) const;
+  std::vector<RouteAction> ExtractSteps(const Rounds &rounds,
+                                        StopIndex to) const;
+};
+
+}  // namespace transport_catalogue::router
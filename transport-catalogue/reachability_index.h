@@ -0,0 +1,221 @@
+#pragma once
+
+#include <algorithm>
+#include <cstdint>
+#include <limits>
+#include <numeric>
+#include <vector>
+
+#include "graph.h"
+
+namespace graph {
+
+/**
+ * Индекс достижимости: за O(1) отвечает, есть ли в графе путь из одной
+ * вершины в другую, чтобы не искать маршрут, которого нет. Веса рёбер не
+ * важны.
+ *
+ * В конструкторе граф разбивается на компоненты сильной связности
+ * алгоритмом Тарьяна. Компоненты нумеруются в порядке завершения, так что
+ * рёбра сжатого графа идут из компоненты в компоненту с меньшим номером, и
+ * битовые множества достижимых компонент считаются одним проходом по
+ * возрастанию номеров. Подготовка - O(V + E) плюс O(C / 64) на каждое ребро
+ * между компонентами, память - C^2 бит, где C - число компонент.
+ *
+ * Если компонент больше `max_bitset_components`, битовые множества не
+ * строятся, и вершины сравниваются только по компонентам слабой связности:
+ * `false` по-прежнему значит, что пути нет, а `true` - лишь что он может
+ * быть.
+ */
+template <typename Graph>
+class ReachabilityIndex {
+ public:
+  static constexpr size_t DEFAULT_MAX_BITSET_COMPONENTS = 1 << 14;
+
+  ReachabilityIndex() = default;
+  explicit ReachabilityIndex(
+      const Graph &graph,
+      size_t max_bitset_components = DEFAULT_MAX_BITSET_COMPONENTS);
+
+  bool IsReachable(VertexId from, VertexId to) const;
+
+  size_t GetComponentCount() const { return component_count_; }
+  size_t GetComponent(VertexId vertex) const { return components_[vertex]; }
+  /**
+   * Построены ли битовые множества, то есть точен ли ответ `IsReachable`.
+   */
+  bool IsExact() const { return weak_components_.empty(); }
+
+ private:
+  static constexpr uint32_t NO_INDEX = std::numeric_limits<uint32_t>::max();
+
+  size_t component_count_ = 0;
+  // компонента сильной связности каждой вершины
+  std::vector<uint32_t> components_;
+  // строка `c` длиной `row_size_` слов - компоненты, достижимые из `c`
+  size_t row_size_ = 0;
+  std::vector<uint64_t> reachable_;
+  // компонента слабой связности каждой вершины, если битовых множеств нет
+  std::vector<uint32_t> weak_components_;
+
+  void FindComponents(const Graph &graph);
+  void BuildReachableSets(const Graph &graph);
+  void FindWeakComponents(const Graph &graph);
+};
+
+template <typename Graph>
+ReachabilityIndex<Graph>::ReachabilityIndex(const Graph &graph,
+                                            size_t max_bitset_components) {
+  FindComponents(graph);
+  if (component_count_ <= max_bitset_components) {
+    BuildReachableSets(graph);
+  } else {
+    FindWeakComponents(graph);
+  }
+}
+
+template <typename Graph>
+bool ReachabilityIndex<Graph>::IsReachable(VertexId from, VertexId to) const {
+  const size_t component_from = components_[from];
+  const size_t component_to = components_[to];
+  if (component_from == component_to) {
+    return true;
+  }
+  if (!IsExact()) {
+    return weak_components_[from] == weak_components_[to];
+  }
+  const uint64_t word =
+      reachable_[component_from * row_size_ + component_to / 64];
+  return (word >> (component_to % 64)) & 1;
+}
+
+/**
+ * Алгоритм Тарьяна без рекурсии: граф остановок может быть слишком глубоким
+ * для стека вызовов.
+ */
+template <typename Graph>
+void ReachabilityIndex<Graph>::FindComponents(const Graph &graph) {
+  const size_t vertex_count = graph.GetVertexCount();
+  using EdgeIterator = decltype(graph.GetIncidentEdges(0).begin());
+  struct Frame {
+    VertexId vertex;
+    EdgeIterator next_edge;
+    EdgeIterator end;
+  };
+
+  components_.assign(vertex_count, NO_INDEX);
+  std::vector<uint32_t> indices(vertex_count, NO_INDEX);
+  std::vector<uint32_t> low_links(vertex_count);
+  std::vector<VertexId> component_stack;
+  std::vector<Frame> frames;
+  uint32_t next_index = 0;
+
+  auto enter = [&](VertexId vertex) {
+    indices[vertex] = low_links[vertex] = next_index++;
+    component_stack.push_back(vertex);
+    const auto edges = graph.GetIncidentEdges(vertex);
+    frames.push_back({vertex, edges.begin(), edges.end()});
+  };
+  for (VertexId root = 0; root < vertex_count; ++root) {
+    if (indices[root] != NO_INDEX) {
+      continue;
+    }
+    enter(root);
+    while (!frames.empty()) {
+      Frame &frame = frames.back();
+      if (frame.next_edge != frame.end) {
+        const VertexId to = graph.GetEdge(*frame.next_edge).to;
+        ++frame.next_edge;
+        if (indices[to] == NO_INDEX) {
+          enter(to);
+        } else if (components_[to] == NO_INDEX) {
+          // `to` ещё в стеке компонент
+          low_links[frame.vertex] =
+              std::min(low_links[frame.vertex], indices[to]);
+        }
+        continue;
+      }
+      const VertexId vertex = frame.vertex;
+      frames.pop_back();
+      if (!frames.empty()) {
+        uint32_t &parent_low_link = low_links[frames.back().vertex];
+        parent_low_link = std::min(parent_low_link, low_links[vertex]);
+      }
+      if (low_links[vertex] == indices[vertex]) {
+        VertexId member;
+        do {
+          member = component_stack.back();
+          component_stack.pop_back();
+          components_[member] = static_cast<uint32_t>(component_count_);
+        } while (member != vertex);
+        ++component_count_;
+      }
+    }
+  }
+}
+
+template <typename Graph>
+void ReachabilityIndex<Graph>::BuildReachableSets(const Graph &graph) {
+  // вершины по компонентам
+  std::vector<size_t> offsets(component_count_ + 1, 0);
+  for (const uint32_t component : components_) {
+    ++offsets[component + 1];
+  }
+  std::partial_sum(offsets.begin(), offsets.end(), offsets.begin());
+  std::vector<VertexId> members(components_.size());
+  {
+    std::vector<size_t> positions(offsets.begin(), offsets.end() - 1);
+    for (VertexId vertex = 0; vertex < components_.size(); ++vertex) {
+      members[positions[components_[vertex]]++] = vertex;
+    }
+  }
+
+  row_size_ = (component_count_ + 63) / 64;
+  reachable_.assign(component_count_ * row_size_, 0);
+  // последняя компонента, из которой встретилось ребро в данную: каждое
+  // множество добавляется в строку один раз
+  std::vector<uint32_t> last_source(component_count_, NO_INDEX);
+  for (size_t component = 0; component < component_count_; ++component) {
+    uint64_t *row = &reachable_[component * row_size_];
+    row[component / 64] |= uint64_t{1} << (component % 64);
+    for (size_t i = offsets[component]; i < offsets[component + 1]; ++i) {
+      for (const EdgeId edge_id : graph.GetIncidentEdges(members[i])) {
+        const uint32_t target = components_[graph.GetEdge(edge_id).to];
+        if (target == component || last_source[target] == component) {
+          continue;
+        }
+        last_source[target] = static_cast<uint32_t>(component);
+        const uint64_t *target_row = &reachable_[target * row_size_];
+        for (size_t word = 0; word < row_size_; ++word) {
+          row[word] |= target_row[word];
+        }
+      }
+    }
+  }
+}
+
+template <typename Graph>
+void ReachabilityIndex<Graph>::FindWeakComponents(const Graph &graph) {
+  // система непересекающихся множеств со сжатием путей
+  std::vector<uint32_t> parents(graph.GetVertexCount());
+  std::iota(parents.begin(), parents.end(), 0);
+  auto find_root = [&parents](uint32_t vertex) {
+    while (parents[vertex] != vertex) {
+      parents[vertex] = parents[parents[vertex]];
+      vertex = parents[vertex];
+    }
+    return vertex;
+  };
+  for (EdgeId edge_id = 0; edge_id < graph.GetEdgeCount(); ++edge_id) {
+    const auto edge = graph.GetEdge(edge_id);
+    const uint32_t from_root = find_root(static_cast<uint32_t>(edge.from));
+    const uint32_t to_root = find_root(static_cast<uint32_t>(edge.to));
+    parents[std::max(from_root, to_root)] = std::min(from_root, to_root);
+  }
+  weak_components_.resize(parents.size());
+  for (uint32_t vertex = 0; vertex < parents.size(); ++vertex) {
+    weak_components_[vertex] = find_root(vertex);
+  }
+}
+
+}  // namespace graph
@@ -55,6 +55,9 @@ class BaseRequestVariantProcessor {
   void FlushBusRequests() {
     for (const AddBusCmd *cmd : add_bus_requests_) {
       transport_catalogue_.AddBus(cmd->name, cmd->route_type, cmd->stop_names);
+      for (const auto &trip : cmd->trips) {
+        transport_catalogue_.AddTrip(cmd->name, trip);
+      }
     }
   }
 
@@ -74,11 +77,12 @@ class StatRequestVariantProcessor {
       TransportCatalogue &transport_catalogue,
       AbstractStatResponsePrinter &stat_response_printer,
       const optional<map_renderer::RenderSettings> &render_settings,
-      const router::Router *router)
+      const router::Router *router, RouteResponseCache &route_cache)
       : transport_catalogue_(transport_catalogue),
         stat_response_printer_(stat_response_printer),
         render_settings_(render_settings),
-        router_(router) {}
+        router_(router),
+        route_cache_(route_cache) {}
 
   void operator()(const StopStatRequest &request) {
     auto stop_info = transport_catalogue_.GetStopInfo(request.name);
@@ -116,13 +120,48 @@ class StatRequestVariantProcessor {
       stat_response_printer_.PrintResponse(request.id, {});
       return;
     }
-    auto route =
-        router_->CalcRoute(string_view{request.from}, string_view{request.to});
-    if (!route) {
+    if (route_cache_.GetCapacity() == 0) {
+      auto route = CalcRoute(request);
+      if (!route) {
+        stat_response_printer_.PrintResponse(request.id, {});
+        return;
+      }
+      stat_response_printer_.PrintResponse(request.id, *route);
+      return;
+    }
+    auto *entry = route_cache_.Find(request);
+    if (entry == nullptr) {
+      entry = &route_cache_.Insert(request, CalcRoute(request));
+    }
+    if (!entry->route) {
+      stat_response_printer_.PrintResponse(request.id, {});
+      return;
+    }
+    stat_response_printer_.PrintRouteResponse(request.id, *entry->route,
+                                              entry->serialized);
+  }
+
+  void operator()(const RouteMatrixRequest &request) {
+    if (router_ == nullptr) {
       stat_response_printer_.PrintResponse(request.id, {});
       return;
     }
-    stat_response_printer_.PrintResponse(request.id, *route);
+    const vector<string_view> from{request.from.begin(), request.from.end()};
+    const vector<string_view> to{request.to.begin(), request.to.end()};
+    stat_response_printer_.PrintResponse(
+        request.id, router_->CalcRouteMatrix(from, to, request.with_steps));
+  }
+
+  void operator()(const IsochroneRequest &request) {
+    auto isochrone =
+        router_ == nullptr
+            ? nullopt
+            : router_->CalcIsochrone(request.from, request.max_time * 60);
+    if (!isochrone) {
+      stat_response_printer_.PrintResponse(request.id, {});
+      return;
+    }
+    stat_response_printer_.PrintResponse(request.id, move(*isochrone));
   }
 
  private:
@@ -130,10 +169,53 @@ class StatRequestVariantProcessor {
   AbstractStatResponsePrinter &stat_response_printer_;
   const optional<map_renderer::RenderSettings> &render_settings_;
   const router::Router *router_ = nullptr;
+  RouteResponseCache &route_cache_;
+
+  optional<router::RouteResult> CalcRoute(const RouteRequest &request) const {
+    if (request.departure_time) {
+      return router_->CalcTimetableRoute(string_view{request.from},
+                                         string_view{request.to},
+                                         *request.departure_time);
+    }
+    return router_->CalcRoute(string_view{request.from},
+                              string_view{request.to}, request.profile);
+  }
 };
 
 }  // namespace detail
 
+RouteResponseCache::Entry *RouteResponseCache::Find(
+    const RouteRequest &request) {
+  auto it = entry_by_key_.find(MakeKey(request));
+  if (it == entry_by_key_.end()) {
+    ++stats_.misses;
+    return nullptr;
+  }
+  ++stats_.hits;
+  entries_.splice(entries_.begin(), entries_, it->second);
+  return &entries_.front().second;
+}
+
+RouteResponseCache::Entry &RouteResponseCache::Insert(
+    const RouteRequest &request, optional<router::RouteResult> route) {
+  if (entries_.size() == capacity_) {
+    entry_by_key_.erase(entries_.back().first);
+    entries_.pop_back();
+    ++stats_.evictions;
+  }
+  Key key = MakeKey(request);
+  entries_.emplace_front(key, Entry{move(route), {}});
+  entry_by_key_.emplace(move(key), entries_.begin());
+  stats_.size = entries_.size();
+  return entries_.front().second;
+}
+
+RouteResponseCache::Key RouteResponseCache::MakeKey(
+    const RouteRequest &request) {
+  return {request.from, request.to, request.departure_time,
+          request.profile.bus_velocity, request.profile.bus_wait_time};
+}
+
 /**
  * Прочитать все запросы к транспортному справочнику из `request_reader_`,
  * отправить эти запросы в `transport_catalogue_` и напечатать ответы на запросы
@@ -149,14 +231,17 @@ void BufferingRequestHandler::ProcessRequests(
   base_request_processor.FlushStopRequests();
   base_request_processor.FlushBusRequests();
   unique_ptr<router::Router> router = nullptr;
+  route_cache_ = RouteResponseCache{};
   if (request_reader_.GetRouterSettings()) {
     router = make_unique<router::Router>(*request_reader_.GetRouterSettings(),
                                          transport_catalogue_);
+    route_cache_ = RouteResponseCache{
+        request_reader_.GetRouterSettings()->route_cache_size};
   }
 
   detail::StatRequestVariantProcessor stat_request_processor{
       transport_catalogue_, stat_response_printer,
-      request_reader_.GetRenderSettings(), router.get()};
+      request_reader_.GetRenderSettings(), router.get(), route_cache_};
   for (const auto &stat_request : request_reader_.GetStatRequests()) {
     visit(stat_request_processor, stat_request);
   }
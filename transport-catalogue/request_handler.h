@@ -1,8 +1,11 @@
 #pragma once
 
 #include <cstddef>
+#include <list>
+#include <map>
 #include <optional>
 #include <string>
+#include <tuple>
 #include <utility>
 #include <variant>
 #include <vector>
@@ -65,6 +68,12 @@ struct AddBusCmd {
    * В кольцевом маршруте первая и последняя остановка совпадают.
    */
   std::vector<std::string> stop_names;
+
+  /**
+   * Рейсы по расписанию: время отправления с каждой остановки рейса в
+   * минутах, см. `Trip`. Может быть пустым.
+   */
+  std::vector<std::vector<double>> trips = {};
 };
 
 /**
@@ -93,9 +102,35 @@ struct StopStatRequest : public BaseStatRequest {
  */
 struct MapRequest : public BaseStatRequest {};
 
+/**
+ * Запрос на маршрут между остановками. Если задано `departure_time` (в минутах
+ * от начала суток), маршрут ищется по расписанию рейсов.
+ */
 struct RouteRequest : public BaseStatRequest {
   std::string from;
   std::string to;
+  std::optional<double> departure_time;
+  // переопределения настроек роутера для этого запроса
+  router::RouteProfile profile;
+};
+
+/**
+ * Запрос на матрицу маршрутов из каждой остановки `from` в каждую остановку
+ * `to`. Если `with_steps` не выставлен, считается только время в пути.
+ */
+struct RouteMatrixRequest : public BaseStatRequest {
+  std::vector<std::string> from;
+  std::vector<std::string> to;
+  bool with_steps = false;
+};
+
+/**
+ * Запрос на все остановки, до которых можно доехать из `from` не дольше
+ * `max_time` минут.
+ */
+struct IsochroneRequest : public BaseStatRequest {
+  std::string from;
+  double max_time = 0;
 };
 
 /**
@@ -108,7 +143,8 @@ using BaseRequest = std::variant<AddStopCmd, AddBusCmd>;
  * справочника.
  */
 using StatRequest =
-    std::variant<BusStatRequest, StopStatRequest, MapRequest, RouteRequest>;
+    std::variant<BusStatRequest, StopStatRequest, MapRequest, RouteRequest,
+                 RouteMatrixRequest, IsochroneRequest>;
 
 /**
  * Базовый класс для получения запросов к транспортному справочнику.
@@ -166,7 +202,17 @@ struct MapResponse {
  */
 using StatResponse =
     std::variant<std::monostate, BusStatResponse, StopStatResponse, MapResponse,
-                 router::RouteResult>;
+                 router::RouteResult, router::RouteMatrix, router::Isochrone>;
+
+/**
+ * Напечатанные поля ответа на запрос маршрута, которые не зависят от
+ * `request_id`: массив шагов и общее время. Пустой `items` - ответ ещё не
+ * напечатан.
+ */
+struct SerializedRoute {
+  std::string items;
+  std::string total_time;
+};
 
 /**
  * Базовый класс для печати ответов на запросы к транспортному справочнику.
@@ -175,10 +221,68 @@ class AbstractStatResponsePrinter {
  public:
   virtual void PrintResponse(int request_id, const StatResponse &) = 0;
 
+  /**
+   * Напечатать ответ на запрос маршрута `route`, который хранится в кэше
+   * вместе с `serialized`. Принтер может сохранить в пустой `serialized`
+   * напечатанные поля ответа и при следующих вызовах печатать их, не строя
+   * заново. По умолчанию `route` печатается как обычный ответ.
+   */
+  virtual void PrintRouteResponse(int request_id,
+                                  const router::RouteResult &route,
+                                  SerializedRoute & /*serialized*/) {
+    PrintResponse(request_id, route);
+  }
+
  protected:
   ~AbstractStatResponsePrinter() = default;
 };
 
+/**
+ * Кэш ответов на запросы маршрута: повторный запрос с теми же остановками и
+ * параметрами не ищется роутером заново. Хранит ответы на `capacity`
+ * последних использованных запросов, в том числе то, что маршрута нет.
+ */
+class RouteResponseCache {
+ public:
+  struct Entry {
+    std::optional<router::RouteResult> route;
+    // см. `AbstractStatResponsePrinter::PrintRouteResponse`
+    SerializedRoute serialized;
+  };
+
+  explicit RouteResponseCache(size_t capacity = 0) : capacity_(capacity) {}
+
+  size_t GetCapacity() const { return capacity_; }
+  const router::CacheStats &GetStats() const { return stats_; }
+
+  /**
+   * Ответ на `request` из кэша, `nullptr` - его там нет.
+   */
+  Entry *Find(const RouteRequest &request);
+
+  /**
+   * Положить в кэш ответ на `request`, которого там нет, вытеснив ответ,
+   * который дольше всех не использовался, если кэш заполнен.
+   */
+  Entry &Insert(const RouteRequest &request,
+                std::optional<router::RouteResult> route);
+
+ private:
+  // остановки "from" и "to" по порядку: маршрут в обратную сторону другой,
+  // расстояния между остановками и ожидание на них зависят от направления
+  using Key = std::tuple<std::string, std::string, std::optional<double>,
+                         std::optional<double>, std::optional<double>>;
+  // недавно использованные - в начале списка
+  using EntryList = std::list<std::pair<Key, Entry>>;
+
+  size_t capacity_;
+  EntryList entries_;
+  std::map<Key, EntryList::iterator> entry_by_key_;
+  router::CacheStats stats_;
+
+  static Key MakeKey(const RouteRequest &request);
+};
+
 class BufferingRequestHandler {
  public:
   BufferingRequestHandler(TransportCatalogue &transport_catalogue,
@@ -188,9 +292,18 @@ class BufferingRequestHandler {
   void ProcessRequests(AbstractStatResponsePrinter &stat_response_printer);
   void RenderMap(MapRenderer &);
 
+  /**
+   * Статистика кэша ответов на запросы маршрута после `ProcessRequests`,
+   * см. `RouterSettings::route_cache_size`.
+   */
+  const router::CacheStats &GetRouteCacheStats() const {
+    return route_cache_.GetStats();
+  }
+
  private:
   TransportCatalogue &transport_catalogue_;
   const AbstractBufferingRequestReader &request_reader_;
+  RouteResponseCache route_cache_;
 };
 
 }  // namespace transport_catalogue::request_handler
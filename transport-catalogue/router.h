@@ -1,116 +1,618 @@
 #pragma once
 
 #include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <limits>
+#include <mutex>
 #include <optional>
+#include <queue>
 #include <stdexcept>
+#include <thread>
+#include <type_traits>
+#include <unordered_map>
+#include <utility>
+#include <variant>
 #include <vector>
 
 #include "graph.h"
+#include "min_plus.h"
 
 namespace graph {
 
+/**
+ * Интерфейс движка поиска кратчайших маршрутов в графе.
+ *
+ * Движки отличаются тем, сколько работы делают заранее в конструкторе и
+ * сколько - на каждый запрос, но контракт `BuildRoute` у всех одинаковый.
+ */
 template <typename Weight>
-class Router {
- private:
-  using Graph = DirectedWeightedGraph<Weight>;
-
+class AbstractRouter {
  public:
-  explicit Router(const Graph &graph);
-
   struct RouteInfo {
     Weight weight;
     std::vector<EdgeId> edges;
   };
 
-  std::optional<RouteInfo> BuildRoute(VertexId from, VertexId to) const;
+  /**
+   * Найти кратчайший маршрут из `from` в `to`. Если маршрута нет, вернёт
+   * `std::nullopt`.
+   */
+  virtual std::optional<RouteInfo> BuildRoute(VertexId from,
+                                              VertexId to) const = 0;
+
+  virtual ~AbstractRouter() = default;
+};
+
+namespace detail {
+
+/**
+ * Барьер для фиксированного числа потоков: `Wait` возвращается, когда его
+ * вызвали все потоки. Барьер можно проходить сколько угодно раз.
+ */
+class Barrier {
+ public:
+  explicit Barrier(size_t thread_count) : thread_count_(thread_count) {}
+
+  void Wait() {
+    std::unique_lock lock{mutex_};
+    const size_t phase = phase_;
+    if (++waiting_count_ == thread_count_) {
+      waiting_count_ = 0;
+      ++phase_;
+      condition_.notify_all();
+    } else {
+      condition_.wait(lock, [this, phase] { return phase_ != phase; });
+    }
+  }
 
  private:
-  struct RouteInternalData {
-    Weight weight;
-    std::optional<EdgeId> prev_edge;
-  };
-  using RoutesInternalData =
-      std::vector<std::vector<std::optional<RouteInternalData>>>;
-
-  void InitializeRoutesInternalData(const Graph &graph) {
-    const size_t vertex_count = graph.GetVertexCount();
-    for (VertexId vertex = 0; vertex < vertex_count; ++vertex) {
-      routes_internal_data_[vertex][vertex] =
-          RouteInternalData{ZERO_WEIGHT, std::nullopt};
+  std::mutex mutex_;
+  std::condition_variable condition_;
+  size_t thread_count_;
+  size_t waiting_count_ = 0;
+  size_t phase_ = 0;
+};
+
+}  // namespace detail
+
+/**
+ * Движок, который в конструкторе считает кратчайшие маршруты между всеми парами
+ * вершин алгоритмом Флойда-Уоршелла. Запросы отвечаются за длину маршрута, но
+ * подготовка стоит O(V^3) времени и O(V^2) памяти.
+ *
+ * Таблица маршрутов хранится двумя плоскими массивами по строкам: веса и
+ * последние рёбра маршрутов. Отсутствие маршрута и ребра обозначается
+ * значениями-заглушками, а номера рёбер хранятся в 32 битах, если все они туда
+ * помещаются. Так ячейка занимает 12 байт вместо 32 для `double`.
+ *
+ * Промежуточные вершины обрабатываются блоками по `PIVOT_BLOCK_SIZE`: каждая
+ * строка таблицы релаксируется сразу через все вершины блока, пока она лежит в
+ * кэше, а строки делятся между `thread_count` потоками (0 - по числу ядер).
+ * Каждая ячейка релаксируется через те же промежуточные вершины, в том же
+ * порядке и с теми же слагаемыми, что и в обычном алгоритме, поэтому
+ * результаты не зависят ни от числа потоков, ни от размера блока.
+ *
+ * Для весов `double` строка релаксируется векторно, по несколько ячеек за
+ * раз, если процессор это умеет, см. `detail::MinPlusKernel`.
+ *
+ * Готовую таблицу можно забрать через `GetWeights` и `GetPrevEdges` и потом
+ * создать движок прямо поверх неё, не пересчитывая и не копируя.
+ *
+ * Если рёбра графа изменились, а вершины остались те же, `Update` обновляет
+ * таблицу без пересчёта с нуля, когда изменений немного.
+ */
+template <typename Weight, typename Graph = DirectedWeightedGraph<Weight>>
+class Router final : public AbstractRouter<Weight> {
+ public:
+  using typename AbstractRouter<Weight>::RouteInfo;
+  // последние рёбра маршрутов, см. `PrevEdges`
+  using PrevEdgesData = std::variant<const uint32_t *, const uint64_t *>;
+
+  explicit Router(const Graph &graph, size_t thread_count = 1);
+  /**
+   * Движок над таблицей, которую раньше отдал движок над тем же графом,
+   * например сохранённой в файл. В обеих таблицах `GetVertexCount()^2`
+   * ячеек по строкам. Таблица не копируется и должна жить дольше движка.
+   */
+  Router(const Graph &graph, const Weight *weights, PrevEdgesData prev_edges);
+
+  // таблица смотрит в свои же векторы, копия смотрела бы в чужие
+  Router(const Router &) = delete;
+  Router &operator=(const Router &) = delete;
+
+  std::optional<RouteInfo> BuildRoute(VertexId from,
+                                      VertexId to) const override;
+
+  /**
+   * Обновить таблицу после того, как граф движка изменился, а вершины
+   * остались те же. `old_graph` - граф, по которому посчитана текущая
+   * таблица.
+   *
+   * Пары вершин сравниваются по самому лёгкому ребру между ними. Строки,
+   * в деревьях кратчайших путей которых есть подорожавшая или пропавшая
+   * пара, пересчитываются алгоритмом Дейкстры, в остальных рёбра только
+   * получают новые номера. Затем через каждое подешевевшее или новое ребро
+   * релаксируется вся таблица за O(V^2).
+   *
+   * Если подешевевших рёбер или строк для пересчёта больше
+   * `V / UPDATE_RECOMPUTE_DIVISOR`, таблица считается заново в
+   * `thread_count` потоках, как в конструкторе. Возвращает `false`, если
+   * таблица посчитана заново.
+   */
+  bool Update(const Graph &old_graph, size_t thread_count = 1);
+
+  const Weight *GetWeights() const { return weights_data_; }
+  PrevEdgesData GetPrevEdges() const { return prev_edges_data_; }
+
+ private:
+  // последние рёбра маршрутов: 32-битные номера, если рёбер меньше 2^32 - 1,
+  // иначе 64-битные. Наибольшее значение типа означает "ребра нет"
+  using PrevEdges =
+      std::variant<std::vector<uint32_t>, std::vector<uint64_t>>;
+
+  template <typename EdgeIndex>
+  static constexpr EdgeIndex NO_EDGE = std::numeric_limits<EdgeIndex>::max();
+
+  template <typename EdgeIndex>
+  void InitializeRoutesInternalData(const Graph &graph,
+                                    std::vector<EdgeIndex> &prev_edges) {
+    for (VertexId vertex = 0; vertex < vertex_count_; ++vertex) {
+      const size_t row = vertex * vertex_count_;
+      weights_[row + vertex] = ZERO_WEIGHT;
       for (const EdgeId edge_id : graph.GetIncidentEdges(vertex)) {
         const auto &edge = graph.GetEdge(edge_id);
         if (edge.weight < ZERO_WEIGHT) {
           throw std::domain_error("Edges' weights should be non-negative");
         }
-        auto &route_internal_data = routes_internal_data_[vertex][edge.to];
-        if (!route_internal_data || route_internal_data->weight > edge.weight) {
-          route_internal_data = RouteInternalData{edge.weight, edge_id};
+        Weight &weight = weights_[row + edge.to];
+        if (weight == UNREACHABLE || weight > edge.weight) {
+          weight = edge.weight;
+          prev_edges[row + edge.to] = static_cast<EdgeIndex>(edge_id);
         }
       }
     }
   }
 
-  void RelaxRoute(VertexId vertex_from, VertexId vertex_to,
-                  const RouteInternalData &route_from,
-                  const RouteInternalData &route_to) {
-    auto &route_relaxing = routes_internal_data_[vertex_from][vertex_to];
-    const Weight candidate_weight = route_from.weight + route_to.weight;
-    if (!route_relaxing || candidate_weight < route_relaxing->weight) {
-      route_relaxing = {candidate_weight, route_to.prev_edge
-                                              ? route_to.prev_edge
-                                              : route_from.prev_edge};
+  /**
+   * Релаксирует строку `vertex_from` через вершину `vertex_through`, строка
+   * которой - `through_weights` и `through_prev_edges`. Строка самой
+   * `vertex_through` при этом не меняется: путь до неё нулевой, а сравнение
+   * строгое.
+   */
+  template <typename EdgeIndex>
+  void RelaxRowThroughVertex(VertexId vertex_from, VertexId vertex_through,
+                             const Weight *through_weights,
+                             const EdgeIndex *through_prev_edges,
+                             std::vector<EdgeIndex> &prev_edges) {
+    const size_t row = vertex_from * vertex_count_;
+    const Weight weight_from = weights_[row + vertex_through];
+    if (weight_from == UNREACHABLE) {
+      return;
+    }
+    const EdgeIndex prev_edge_from = prev_edges[row + vertex_through];
+    Weight *row_weights = &weights_[row];
+    EdgeIndex *row_prev_edges = &prev_edges[row];
+    if constexpr (std::is_same_v<Weight, double>) {
+      detail::RelaxRowMinPlus(min_plus_kernel_, weight_from, through_weights,
+                              prev_edge_from, through_prev_edges, row_weights,
+                              row_prev_edges, vertex_count_);
+      return;
+    }
+    for (VertexId vertex_to = 0; vertex_to < vertex_count_; ++vertex_to) {
+      const Weight weight_to = through_weights[vertex_to];
+      // бесконечность в сумме остаётся бесконечностью и ничего не улучшит,
+      // а вот наибольшее значение типа проверять приходится
+      if constexpr (!std::numeric_limits<Weight>::has_infinity) {
+        if (weight_to == UNREACHABLE) {
+          continue;
+        }
+      }
+      const Weight candidate_weight = weight_from + weight_to;
+      if (candidate_weight < row_weights[vertex_to]) {
+        row_weights[vertex_to] = candidate_weight;
+        row_prev_edges[vertex_to] =
+            through_prev_edges[vertex_to] != NO_EDGE<EdgeIndex>
+                ? through_prev_edges[vertex_to]
+                : prev_edge_from;
+      }
     }
   }
 
-  void RelaxRoutesInternalDataThroughVertex(size_t vertex_count,
-                                            VertexId vertex_through) {
-    for (VertexId vertex_from = 0; vertex_from < vertex_count; ++vertex_from) {
-      if (const auto &route_from =
-              routes_internal_data_[vertex_from][vertex_through]) {
-        for (VertexId vertex_to = 0; vertex_to < vertex_count; ++vertex_to) {
-          if (const auto &route_to =
-                  routes_internal_data_[vertex_through][vertex_to]) {
-            RelaxRoute(vertex_from, vertex_to, *route_from, *route_to);
-          }
+  /**
+   * Обычный Флойд-Уоршелл через вершины блока, но только для строк самого
+   * блока. В `pivot_weights` и `pivot_prev_edges` сохраняются строки
+   * промежуточных вершин в том виде, в котором их видят остальные строки на
+   * шаге своей вершины.
+   */
+  template <typename EdgeIndex>
+  void RelaxPivotRows(VertexId block_begin, VertexId block_end,
+                      std::vector<Weight> &pivot_weights,
+                      std::vector<EdgeIndex> &pivot_prev_edges,
+                      std::vector<EdgeIndex> &prev_edges) {
+    for (VertexId vertex_through = block_begin; vertex_through < block_end;
+         ++vertex_through) {
+      const size_t row = vertex_through * vertex_count_;
+      const size_t pivot_row = (vertex_through - block_begin) * vertex_count_;
+      std::copy_n(&weights_[row], vertex_count_, &pivot_weights[pivot_row]);
+      std::copy_n(&prev_edges[row], vertex_count_,
+                  &pivot_prev_edges[pivot_row]);
+      for (VertexId vertex_from = block_begin; vertex_from < block_end;
+           ++vertex_from) {
+        if (vertex_from != vertex_through) {
+          RelaxRowThroughVertex(vertex_from, vertex_through,
+                                &pivot_weights[pivot_row],
+                                &pivot_prev_edges[pivot_row], prev_edges);
         }
       }
     }
   }
 
+  template <typename EdgeIndex>
+  void RelaxRoutesInternalData(size_t thread_count,
+                               std::vector<EdgeIndex> &prev_edges);
+
+  // самое лёгкое ребро между каждой парой вершин `from * vertex_count_ +
+  // to`, первое из равных - как в `InitializeRoutesInternalData`
+  std::unordered_map<size_t, EdgeId> FindLightestEdges(
+      const Graph &graph) const;
+
+  template <typename EdgeIndex>
+  bool UpdateRoutesInternalData(const Graph &old_graph, size_t thread_count,
+                                std::vector<EdgeIndex> &prev_edges);
+
+  template <typename EdgeIndex>
+  void RecalculateRow(VertexId vertex_from,
+                      std::vector<EdgeIndex> &prev_edges);
+
+  // сколько промежуточных вершин обрабатывается за один проход по строкам
+  static constexpr size_t PIVOT_BLOCK_SIZE = 16;
+  // сколько строк подряд забирает поток
+  static constexpr size_t ROW_CHUNK_SIZE = 8;
+  // каждое подешевевшее ребро стоит `Update` прохода по всей таблице, а
+  // каждая пересчитанная строка - алгоритма Дейкстры, тогда как пересчёт с
+  // нуля - это V проходов блоками, векторно и в несколько потоков. Поэтому
+  // с нуля таблица считается, как только тех или других больше V / 4
+  static constexpr size_t UPDATE_RECOMPUTE_DIVISOR = 4;
   static constexpr Weight ZERO_WEIGHT{};
+  static constexpr Weight UNREACHABLE =
+      std::numeric_limits<Weight>::has_infinity
+          ? std::numeric_limits<Weight>::infinity()
+          : std::numeric_limits<Weight>::max();
   const Graph &graph_;
-  RoutesInternalData routes_internal_data_;
+  size_t vertex_count_;
+  // релаксация строк для весов `double`, векторная, если процессор умеет
+  detail::MinPlusKernel min_plus_kernel_ = detail::GetBestMinPlusKernel();
+  // вес маршрута из `from` в `to` лежит в `weights_[from * vertex_count_ +
+  // to]`, последнее ребро этого маршрута - в `prev_edges_` по тому же индексу
+  std::vector<Weight> weights_;
+  PrevEdges prev_edges_;
+  // таблица, по которой отвечаются запросы: `weights_` и `prev_edges_` или
+  // внешняя
+  const Weight *weights_data_;
+  PrevEdgesData prev_edges_data_;
 };
 
-template <typename Weight>
-Router<Weight>::Router(const Graph &graph)
+template <typename Weight, typename Graph>
+Router<Weight, Graph>::Router(const Graph &graph, size_t thread_count)
     : graph_(graph),
-      routes_internal_data_(graph.GetVertexCount(),
-                            std::vector<std::optional<RouteInternalData>>(
-                                graph.GetVertexCount())) {
-  InitializeRoutesInternalData(graph);
+      vertex_count_(graph.GetVertexCount()),
+      weights_(vertex_count_ * vertex_count_, UNREACHABLE) {
+  const size_t cell_count = vertex_count_ * vertex_count_;
+  if (graph.GetEdgeCount() < NO_EDGE<uint32_t>) {
+    prev_edges_ = std::vector<uint32_t>(cell_count, NO_EDGE<uint32_t>);
+  } else {
+    prev_edges_ = std::vector<uint64_t>(cell_count, NO_EDGE<uint64_t>);
+  }
+  if (thread_count == 0) {
+    thread_count = std::max(1u, std::thread::hardware_concurrency());
+  }
+  std::visit(
+      [this, &graph, thread_count](auto &prev_edges) {
+        InitializeRoutesInternalData(graph, prev_edges);
+        RelaxRoutesInternalData(thread_count, prev_edges);
+        prev_edges_data_ = prev_edges.data();
+      },
+      prev_edges_);
+  weights_data_ = weights_.data();
+}
+
+template <typename Weight, typename Graph>
+Router<Weight, Graph>::Router(const Graph &graph, const Weight *weights,
+                              PrevEdgesData prev_edges)
+    : graph_(graph),
+      vertex_count_(graph.GetVertexCount()),
+      weights_data_(weights),
+      prev_edges_data_(prev_edges) {}
+
+template <typename Weight, typename Graph>
+template <typename EdgeIndex>
+void Router<Weight, Graph>::RelaxRoutesInternalData(
+    size_t thread_count, std::vector<EdgeIndex> &prev_edges) {
+  const size_t vertex_count = vertex_count_;
+  thread_count = std::max<size_t>(
+      1, std::min(thread_count, vertex_count / ROW_CHUNK_SIZE));
+  const size_t pivot_cell_count =
+      std::min(PIVOT_BLOCK_SIZE, vertex_count) * vertex_count;
+  std::vector<Weight> pivot_weights(pivot_cell_count);
+  std::vector<EdgeIndex> pivot_prev_edges(pivot_cell_count);
+  std::atomic<VertexId> next_row{0};
+  detail::Barrier barrier{thread_count};
+
+  // строки блока готовит один поток, затем все потоки разбирают остальные
+  // строки; строки на этом этапе друг от друга не зависят
+  auto relax = [&](bool is_main_thread) {
+    for (VertexId block_begin = 0; block_begin < vertex_count;
+         block_begin += PIVOT_BLOCK_SIZE) {
+      const VertexId block_end =
+          std::min(block_begin + PIVOT_BLOCK_SIZE, vertex_count);
+      if (is_main_thread) {
+        RelaxPivotRows(block_begin, block_end, pivot_weights, pivot_prev_edges,
+                       prev_edges);
+        next_row = 0;
+      }
+      barrier.Wait();
+      for (VertexId chunk_begin = next_row.fetch_add(ROW_CHUNK_SIZE);
+           chunk_begin < vertex_count;
+           chunk_begin = next_row.fetch_add(ROW_CHUNK_SIZE)) {
+        const VertexId chunk_end =
+            std::min(chunk_begin + ROW_CHUNK_SIZE, vertex_count);
+        for (VertexId vertex_from = chunk_begin; vertex_from < chunk_end;
+             ++vertex_from) {
+          if (block_begin <= vertex_from && vertex_from < block_end) {
+            continue;
+          }
+          for (VertexId vertex_through = block_begin;
+               vertex_through < block_end; ++vertex_through) {
+            const size_t pivot_row =
+                (vertex_through - block_begin) * vertex_count;
+            RelaxRowThroughVertex(vertex_from, vertex_through,
+                                  &pivot_weights[pivot_row],
+                                  &pivot_prev_edges[pivot_row], prev_edges);
+          }
+        }
+      }
+      barrier.Wait();
+    }
+  };
 
-  const size_t vertex_count = graph.GetVertexCount();
-  for (VertexId vertex_through = 0; vertex_through < vertex_count;
-       ++vertex_through) {
-    RelaxRoutesInternalDataThroughVertex(vertex_count, vertex_through);
+  std::vector<std::thread> threads;
+  threads.reserve(thread_count - 1);
+  for (size_t i = 1; i < thread_count; ++i) {
+    threads.emplace_back(relax, false);
+  }
+  relax(true);
+  for (auto &thread : threads) {
+    thread.join();
   }
 }
 
-template <typename Weight>
-std::optional<typename Router<Weight>::RouteInfo> Router<Weight>::BuildRoute(
-    VertexId from, VertexId to) const {
-  const auto &route_internal_data = routes_internal_data_.at(from).at(to);
-  if (!route_internal_data) {
+/**
+ * Кидает `invalid_argument`, если изменилось число вершин.
+ */
+template <typename Weight, typename Graph>
+bool Router<Weight, Graph>::Update(const Graph &old_graph,
+                                   size_t thread_count) {
+  if (old_graph.GetVertexCount() != vertex_count_ ||
+      graph_.GetVertexCount() != vertex_count_) {
+    throw std::invalid_argument("graph's vertex count has changed");
+  }
+  // внешнюю таблицу менять нельзя, её нужно скопировать
+  const size_t cell_count = vertex_count_ * vertex_count_;
+  if (weights_data_ != weights_.data()) {
+    weights_.assign(weights_data_, weights_data_ + cell_count);
+    std::visit(
+        [this, cell_count](const auto *prev_edges) {
+          using EdgeIndex = std::remove_const_t<
+              std::remove_pointer_t<decltype(prev_edges)>>;
+          prev_edges_ =
+              std::vector<EdgeIndex>(prev_edges, prev_edges + cell_count);
+        },
+        prev_edges_data_);
+  }
+  // новые номера рёбер могут не поместиться в 32 бита
+  if (const auto *prev_edges = std::get_if<std::vector<uint32_t>>(
+          &prev_edges_);
+      prev_edges != nullptr && graph_.GetEdgeCount() >= NO_EDGE<uint32_t>) {
+    std::vector<uint64_t> wide_prev_edges(cell_count);
+    for (size_t i = 0; i < cell_count; ++i) {
+      wide_prev_edges[i] = (*prev_edges)[i] == NO_EDGE<uint32_t>
+                               ? NO_EDGE<uint64_t>
+                               : (*prev_edges)[i];
+    }
+    prev_edges_ = std::move(wide_prev_edges);
+  }
+
+  if (thread_count == 0) {
+    thread_count = std::max(1u, std::thread::hardware_concurrency());
+  }
+  bool updated = false;
+  std::visit(
+      [this, &old_graph, thread_count, &updated](auto &prev_edges) {
+        updated = UpdateRoutesInternalData(old_graph, thread_count, prev_edges);
+        prev_edges_data_ = prev_edges.data();
+      },
+      prev_edges_);
+  weights_data_ = weights_.data();
+  return updated;
+}
+
+template <typename Weight, typename Graph>
+std::unordered_map<size_t, EdgeId> Router<Weight, Graph>::FindLightestEdges(
+    const Graph &graph) const {
+  std::unordered_map<size_t, EdgeId> result;
+  for (VertexId vertex = 0; vertex < vertex_count_; ++vertex) {
+    for (const EdgeId edge_id : graph.GetIncidentEdges(vertex)) {
+      const auto &edge = graph.GetEdge(edge_id);
+      if (edge.weight < ZERO_WEIGHT) {
+        throw std::domain_error("Edges' weights should be non-negative");
+      }
+      auto [it, inserted] =
+          result.emplace(edge.from * vertex_count_ + edge.to, edge_id);
+      if (!inserted && edge.weight < graph.GetEdge(it->second).weight) {
+        it->second = edge_id;
+      }
+    }
+  }
+  return result;
+}
+
+template <typename Weight, typename Graph>
+template <typename EdgeIndex>
+bool Router<Weight, Graph>::UpdateRoutesInternalData(
+    const Graph &old_graph, size_t thread_count,
+    std::vector<EdgeIndex> &prev_edges) {
+  const size_t max_change_count = vertex_count_ / UPDATE_RECOMPUTE_DIVISOR;
+  auto recompute = [&]() {
+    std::fill(weights_.begin(), weights_.end(), UNREACHABLE);
+    std::fill(prev_edges.begin(), prev_edges.end(), NO_EDGE<EdgeIndex>);
+    InitializeRoutesInternalData(graph_, prev_edges);
+    RelaxRoutesInternalData(thread_count, prev_edges);
+    return false;
+  };
+
+  const auto old_edges = FindLightestEdges(old_graph);
+  const auto new_edges = FindLightestEdges(graph_);
+
+  // новый номер каждого самого лёгкого ребра старого графа; `NO_EDGE` -
+  // пара вершин подорожала или ребро между ними пропало
+  std::vector<EdgeIndex> new_edge_ids(old_graph.GetEdgeCount(),
+                                      NO_EDGE<EdgeIndex>);
+  for (const auto &[pair, old_edge_id] : old_edges) {
+    auto it = new_edges.find(pair);
+    if (it != new_edges.end() && !(graph_.GetEdge(it->second).weight >
+                                   old_graph.GetEdge(old_edge_id).weight)) {
+      new_edge_ids[old_edge_id] = static_cast<EdgeIndex>(it->second);
+    }
+  }
+  std::vector<EdgeId> cheaper_edges;
+  for (const auto &[pair, new_edge_id] : new_edges) {
+    auto it = old_edges.find(pair);
+    if (it == old_edges.end() || graph_.GetEdge(new_edge_id).weight <
+                                     old_graph.GetEdge(it->second).weight) {
+      cheaper_edges.push_back(new_edge_id);
+    }
+  }
+  if (cheaper_edges.size() > max_change_count) {
+    return recompute();
+  }
+  // порядок обхода хеш-таблицы не должен влиять на выбор равных маршрутов
+  std::sort(cheaper_edges.begin(), cheaper_edges.end());
+
+  std::vector<VertexId> changed_rows;
+  for (VertexId vertex_from = 0; vertex_from < vertex_count_; ++vertex_from) {
+    EdgeIndex *row_prev_edges = &prev_edges[vertex_from * vertex_count_];
+    for (VertexId vertex_to = 0; vertex_to < vertex_count_; ++vertex_to) {
+      EdgeIndex &prev_edge = row_prev_edges[vertex_to];
+      if (prev_edge == NO_EDGE<EdgeIndex>) {
+        continue;
+      }
+      prev_edge = new_edge_ids[prev_edge];
+      if (prev_edge == NO_EDGE<EdgeIndex>) {
+        changed_rows.push_back(vertex_from);
+        break;
+      }
+    }
+    if (changed_rows.size() > max_change_count) {
+      return recompute();
+    }
+  }
+  for (const VertexId vertex_from : changed_rows) {
+    RecalculateRow(vertex_from, prev_edges);
+  }
+
+  for (const EdgeId edge_id : cheaper_edges) {
+    const auto &edge = graph_.GetEdge(edge_id);
+    const size_t through_row = edge.to * vertex_count_;
+    for (VertexId vertex_from = 0; vertex_from < vertex_count_;
+         ++vertex_from) {
+      const size_t row = vertex_from * vertex_count_;
+      const Weight weight_from = weights_[row + edge.from];
+      if (weight_from == UNREACHABLE) {
+        continue;
+      }
+      const Weight weight_through = weight_from + edge.weight;
+      for (VertexId vertex_to = 0; vertex_to < vertex_count_; ++vertex_to) {
+        const Weight weight_to = weights_[through_row + vertex_to];
+        if (weight_to == UNREACHABLE) {
+          continue;
+        }
+        const Weight candidate_weight = weight_through + weight_to;
+        if (candidate_weight < weights_[row + vertex_to]) {
+          weights_[row + vertex_to] = candidate_weight;
+          prev_edges[row + vertex_to] =
+              vertex_to == edge.to
+                  ? static_cast<EdgeIndex>(edge_id)
+                  : prev_edges[through_row + vertex_to];
+        }
+      }
+    }
+  }
+  return true;
+}
+
+/**
+ * Пересчитать строку `vertex_from` алгоритмом Дейкстры по текущему графу.
+ */
+template <typename Weight, typename Graph>
+template <typename EdgeIndex>
+void Router<Weight, Graph>::RecalculateRow(
+    VertexId vertex_from, std::vector<EdgeIndex> &prev_edges) {
+  Weight *row_weights = &weights_[vertex_from * vertex_count_];
+  EdgeIndex *row_prev_edges = &prev_edges[vertex_from * vertex_count_];
+  std::fill_n(row_weights, vertex_count_, UNREACHABLE);
+  std::fill_n(row_prev_edges, vertex_count_, NO_EDGE<EdgeIndex>);
+  row_weights[vertex_from] = ZERO_WEIGHT;
+
+  using QueueItem = std::pair<Weight, VertexId>;
+  std::priority_queue<QueueItem, std::vector<QueueItem>, std::greater<>>
+      queue;
+  queue.emplace(ZERO_WEIGHT, vertex_from);
+  while (!queue.empty()) {
+    const auto [weight, vertex] = queue.top();
+    queue.pop();
+    if (weight > row_weights[vertex]) {
+      continue;
+    }
+    for (const EdgeId edge_id : graph_.GetIncidentEdges(vertex)) {
+      const auto &edge = graph_.GetEdge(edge_id);
+      const Weight candidate_weight = weight + edge.weight;
+      if (row_weights[edge.to] == UNREACHABLE ||
+          candidate_weight < row_weights[edge.to]) {
+        row_weights[edge.to] = candidate_weight;
+        row_prev_edges[edge.to] = static_cast<EdgeIndex>(edge_id);
+        queue.emplace(candidate_weight, edge.to);
+      }
+    }
+  }
+}
+
+template <typename Weight, typename Graph>
+std::optional<typename Router<Weight, Graph>::RouteInfo>
+Router<Weight, Graph>::BuildRoute(VertexId from, VertexId to) const {
+  if (from >= vertex_count_ || to >= vertex_count_) {
+    throw std::out_of_range("vertex id is out of range");
+  }
+  const size_t row = from * vertex_count_;
+  const Weight weight = weights_data_[row + to];
+  if (weight == UNREACHABLE) {
     return std::nullopt;
   }
-  const Weight weight = route_internal_data->weight;
   std::vector<EdgeId> edges;
-  for (std::optional<EdgeId> edge_id = route_internal_data->prev_edge; edge_id;
-       edge_id = routes_internal_data_[from][graph_.GetEdge(*edge_id).from]
-                     ->prev_edge) {
-    edges.push_back(*edge_id);
-  }
+  std::visit(
+      [this, row, to, &edges](const auto *prev_edges) {
+        using EdgeIndex = std::remove_const_t<
+            std::remove_pointer_t<decltype(prev_edges)>>;
+        for (EdgeIndex edge_id = prev_edges[row + to];
+             edge_id != NO_EDGE<EdgeIndex>;
+             edge_id = prev_edges[row + graph_.GetEdge(edge_id).from]) {
+          edges.push_back(edge_id);
+        }
+      },
+      prev_edges_data_);
   std::reverse(edges.begin(), edges.end());
 
   return RouteInfo{weight, std::move(edges)};
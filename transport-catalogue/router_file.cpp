@@ -0,0 +1,135 @@
+#include "router_file.h"
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <cstdio>
+#include <stdexcept>
+#include <string_view>
+#include <unordered_map>
+
+#include "domain.h"
+#include "transport_catalogue.h"
+#include "transport_router.h"
+
+using namespace std;
+
+namespace transport_catalogue::router {
+
+namespace {
+
+/**
+ * 64-битный FNV-1a.
+ */
+class Hasher {
+ public:
+  void Add(const void *data, size_t size) {
+    const auto *bytes = static_cast<const unsigned char *>(data);
+    for (size_t i = 0; i < size; ++i) {
+      hash_ = (hash_ ^ bytes[i]) * 1099511628211ull;
+    }
+  }
+
+  template <typename T>
+  void AddValue(const T &value) {
+    Add(&value, sizeof(value));
+  }
+
+  void AddString(string_view str) {
+    AddValue(str.size());
+    Add(str.data(), str.size());
+  }
+
+  uint64_t Get() const { return hash_; }
+
+ private:
+  uint64_t hash_ = 14695981039346656037ull;
+};
+
+}  // namespace
+
+MappedFile::MappedFile(const string &path) {
+  const int fd = open(path.c_str(), O_RDONLY);
+  if (fd < 0) {
+    return;
+  }
+  struct stat file_stat;
+  if (fstat(fd, &file_stat) == 0 && file_stat.st_size > 0) {
+    void *data =
+        mmap(nullptr, file_stat.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    if (data != MAP_FAILED) {
+      data_ = static_cast<const byte *>(data);
+      size_ = file_stat.st_size;
+    }
+  }
+  // отображение остаётся и после закрытия файла
+  close(fd);
+}
+
+MappedFile::~MappedFile() {
+  if (data_ != nullptr) {
+    munmap(const_cast<byte *>(data_), size_);
+  }
+}
+
+/**
+ * Пишет во временный файл рядом с `path`, а `Finish` переименовывает его
+ * в `path`: недописанный файл никогда не окажется на месте готового.
+ */
+RouterFileWriter::RouterFileWriter(const string &path)
+    : path_(path), out_(path + ".tmp"s, ios::binary | ios::trunc) {}
+
+void RouterFileWriter::Finish() {
+  out_.close();
+  const string tmp_path = path_ + ".tmp"s;
+  if (!out_ || rename(tmp_path.c_str(), path_.c_str()) != 0) {
+    remove(tmp_path.c_str());
+    throw runtime_error("can't write router file "s + path_);
+  }
+}
+
+uint64_t HashCatalogue(const TransportCatalogue &transport_catalogue) {
+  Hasher hasher;
+  unordered_map<const Stop *, size_t> index;
+  const auto stops = transport_catalogue.GetStops();
+  hasher.AddValue(stops.size());
+  for (size_t i = 0; i < stops.size(); ++i) {
+    index[stops[i]] = i;
+    hasher.AddString(stops[i]->name);
+    hasher.AddValue(stops[i]->coords.lat);
+    hasher.AddValue(stops[i]->coords.lng);
+  }
+
+  const auto buses = transport_catalogue.GetBuses();
+  hasher.AddValue(buses.size());
+  for (const Bus *bus : buses) {
+    hasher.AddString(bus->name);
+    hasher.AddValue(bus->route_type);
+    hasher.AddValue(bus->stops.size());
+    for (size_t i = 0; i < bus->stops.size(); ++i) {
+      const Stop *next = bus->stops[(i + 1) % bus->stops.size()];
+      hasher.AddValue(index.at(bus->stops[i]));
+      hasher.AddValue(
+          transport_catalogue.GetRealDistance(bus->stops[i], next));
+      hasher.AddValue(
+          transport_catalogue.GetRealDistance(next, bus->stops[i]));
+    }
+  }
+  return hasher.Get();
+}
+
+uint64_t HashRouterSettings(const RouterSettings &settings) {
+  Hasher hasher;
+  hasher.AddValue(settings.bus_velocity);
+  hasher.AddValue(settings.bus_wait_time);
+  hasher.AddValue(settings.engine);
+  hasher.AddValue(settings.graph_model);
+  hasher.AddValue(settings.prune_bus_edges);
+  hasher.AddValue(settings.reduce_to_transfer_stops);
+  hasher.AddValue(settings.reorder_vertices);
+  return hasher.Get();
+}
+
+}  // namespace transport_catalogue::router
@@ -0,0 +1,147 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <fstream>
+#include <string>
+
+namespace transport_catalogue {
+class TransportCatalogue;
+} /* namespace transport_catalogue */
+
+namespace transport_catalogue::router {
+
+struct RouterSettings;
+
+/**
+ * Заголовок файла с графом остановок и посчитанными маршрутами, см.
+ * `Router::SaveToFile`. За ним идут массивы, каждый выровнен на 8 байт.
+ * Числа записаны как в памяти машины, которая писала файл, поэтому файл
+ * отображается в память и используется как есть.
+ */
+struct RouterFileHeader {
+  static constexpr char MAGIC[8] = {'T', 'C', 'R', 'O', 'U', 'T', 'E', 'R'};
+  static constexpr uint32_t VERSION = 2;
+  static constexpr uint32_t BYTE_ORDER_MARK = 0x01020304;
+
+  char magic[8];
+  uint32_t version;
+  // `BYTE_ORDER_MARK` в порядке байтов машины, которая писала файл
+  uint32_t byte_order_mark;
+  uint64_t catalogue_hash;
+  uint64_t settings_hash;
+  uint64_t vertex_count;
+  uint64_t edge_count;
+  // размер номера ребра в таблице Флойда-Уоршелла, 0 - таблицы в файле нет
+  uint64_t prev_edge_size;
+};
+
+/**
+ * Описание ребра графа остановок в файле. Указатели на остановки и автобусы
+ * заменены их номерами в `GetStops` и `GetBuses` справочника.
+ */
+struct RouterFileEdge {
+  // номер альтернативы в `Edge`
+  uint32_t kind;
+  // номер остановки или автобуса, если ребру он нужен
+  uint32_t object;
+  uint64_t span_len;
+  // расстояние в метрах для рёбер автобусов
+  double distance;
+};
+
+/**
+ * Файл, отображённый в память только для чтения. Если файл не удалось
+ * открыть или отобразить, `GetData` вернёт `nullptr`.
+ */
+class MappedFile {
+ public:
+  explicit MappedFile(const std::string &path);
+  ~MappedFile();
+
+  MappedFile(const MappedFile &) = delete;
+  MappedFile &operator=(const MappedFile &) = delete;
+
+  const std::byte *GetData() const { return data_; }
+  size_t GetSize() const { return size_; }
+
+ private:
+  const std::byte *data_ = nullptr;
+  size_t size_ = 0;
+};
+
+/**
+ * Последовательное чтение массивов из отображённого файла без копирования.
+ */
+class RouterFileReader {
+ public:
+  RouterFileReader(const std::byte *data, size_t size)
+      : data_(data), size_(size) {}
+
+  /**
+   * Следующие `count` элементов. Если файл кончился раньше, вернёт
+   * `nullptr`, и все следующие чтения тоже.
+   */
+  template <typename T>
+  const T *Read(size_t count) {
+    const size_t begin = Align(position_);
+    if (data_ == nullptr || begin > size_ ||
+        count > (size_ - begin) / sizeof(T)) {
+      data_ = nullptr;
+      return nullptr;
+    }
+    position_ = begin + count * sizeof(T);
+    return reinterpret_cast<const T *>(data_ + begin);
+  }
+
+  bool IsAtEnd() const { return data_ != nullptr && position_ == size_; }
+
+ private:
+  const std::byte *data_;
+  size_t size_;
+  size_t position_ = 0;
+
+  static size_t Align(size_t offset) { return (offset + 7) / 8 * 8; }
+};
+
+/**
+ * Последовательная запись массивов в файл в том виде, в каком их прочитает
+ * `RouterFileReader`.
+ */
+class RouterFileWriter {
+ public:
+  explicit RouterFileWriter(const std::string &path);
+
+  template <typename T>
+  void Write(const T *data, size_t count) {
+    static constexpr char PADDING[8] = {};
+    out_.write(PADDING, (8 - position_ % 8) % 8);
+    position_ = (position_ + 7) / 8 * 8;
+    out_.write(reinterpret_cast<const char *>(data), count * sizeof(T));
+    position_ += count * sizeof(T);
+  }
+
+  /**
+   * Дописать файл. Кидает `runtime_error`, если запись не удалась.
+   */
+  void Finish();
+
+ private:
+  std::string path_;
+  std::ofstream out_;
+  size_t position_ = 0;
+};
+
+/**
+ * Хеш того содержимого справочника, из которого строится граф остановок:
+ * остановок с координатами, автобусов с их остановками и расстояний между
+ * соседними остановками маршрутов.
+ */
+uint64_t HashCatalogue(const TransportCatalogue &transport_catalogue);
+
+/**
+ * Хеш настроек, от которых зависят граф остановок и таблица маршрутов.
+ */
+uint64_t HashRouterSettings(const RouterSettings &settings);
+
+}  // namespace transport_catalogue::router
@@ -60,8 +60,7 @@ void TransportCatalogue::AddBus(string name, RouteType route_type,
     stops.resize(stops.size() - 1);
   }
 
-  const auto &ref =
-      buses_.emplace_back(Bus{move(name), route_type, move(stops)});
+  auto &ref = buses_.emplace_back(Bus{move(name), route_type, move(stops), {}});
   buses_by_name_.emplace(ref.name, &ref);
   for (const Stop *stop : ref.stops) {
     auto &buses_for_stop = buses_for_stop_[stop];
@@ -174,6 +173,29 @@ std::optional<BusesForStop> TransportCatalogue::GetStopInfo(
  */
 void TransportCatalogue::SetDistance(std::string_view from, std::string_view to,
                                      size_t distance) {
+  detail::StopDisKey key = ResolveStopPair(from, to);
+  if (real_distances_.count(key) > 0) {
+    throw invalid_argument{"distance between "s + string(from) + " and "s +
+                           string(to) + " has already been set"};
+  }
+  real_distances_.emplace(key, distance);
+}
+
+/**
+ * Задать реальное расстояние от остановки `from` до `to` в метрах, даже если
+ * оно уже было задано. Роутер, построенный по справочнику, об изменении
+ * нужно известить через `Router::Update`.
+ */
+void TransportCatalogue::ChangeDistance(std::string_view from,
+                                        std::string_view to, size_t distance) {
+  real_distances_[ResolveStopPair(from, to)] = distance;
+}
+
+/**
+ * Кидает `invalid_argument`, если какой-то из остановок нет в справочнике.
+ */
+detail::StopDisKey TransportCatalogue::ResolveStopPair(string_view from,
+                                                       string_view to) const {
   auto from_it = stops_by_name_.find(from);
   if (from_it == stops_by_name_.end()) {
     throw invalid_argument{"unknown stop "s + string(from)};
@@ -182,12 +204,44 @@ void TransportCatalogue::SetDistance(std::string_view from, std::string_view to,
   if (to_it == stops_by_name_.end()) {
     throw invalid_argument{"unknown stop "s + string(to)};
   }
-  detail::StopDisKey key{from_it->second, to_it->second};
-  if (real_distances_.count(key) > 0) {
-    throw invalid_argument{"distance between "s + string(from) + " and "s +
-                           string(to) + " has already been set"};
+  return {from_it->second, to_it->second};
+}
+
+/**
+ * Добавить маршруту `bus_name` рейс по расписанию. `departure_times` - время
+ * отправления с каждой остановки рейса в минутах, см. `Trip`.
+ *
+ * Кидает `invalid_argument` если:
+ *  - маршрута нет в справочнике;
+ *  - у маршрута нет остановок (кольцевой из одной остановки);
+ *  - число времён не совпадает с числом остановок в рейсе;
+ *  - время отправления с какой-то остановки раньше, чем с предыдущей.
+ *
+ * Параметр `departure_times` принимается по значению, т.к. всё равно будет
+ * скопирован.
+ */
+void TransportCatalogue::AddTrip(string_view bus_name,
+                                 vector<double> departure_times) {
+  auto it = buses_by_name_.find(bus_name);
+  if (it == buses_by_name_.end()) {
+    throw invalid_argument{"unknown bus "s + string(bus_name)};
   }
-  real_distances_.emplace(key, distance);
+  Bus &bus = *it->second;
+  if (bus.stops.empty()) {
+    throw invalid_argument{"bus "s + bus.name + " has no stops"s};
+  }
+  const size_t stops_count = bus.route_type == RouteType::LINEAR
+                                 ? bus.stops.size() * 2 - 1
+                                 : bus.stops.size() + 1;
+  if (departure_times.size() != stops_count) {
+    throw invalid_argument{"trip of bus "s + bus.name + " must have "s +
+                           to_string(stops_count) + " departure times"s};
+  }
+  if (!is_sorted(departure_times.begin(), departure_times.end())) {
+    throw invalid_argument{"departure times of bus "s + bus.name +
+                           " must not decrease"s};
+  }
+  bus.trips.push_back(Trip{move(departure_times)});
 }
 
 /**
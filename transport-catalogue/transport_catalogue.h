@@ -38,6 +38,9 @@ class TransportCatalogue {
   void AddBus(std::string name, RouteType route_type,
               const std::vector<std::string> &stop_names);
   void SetDistance(std::string_view from, std::string_view to, size_t distance);
+  void ChangeDistance(std::string_view from, std::string_view to,
+                      size_t distance);
+  void AddTrip(std::string_view bus_name, std::vector<double> departure_times);
   std::optional<BusStats> GetBusStats(std::string_view bus_name) const;
   std::optional<BusesForStop> GetStopInfo(std::string_view stop_name) const;
   std::vector<const Bus *> GetBuses() const;
@@ -69,7 +72,7 @@ class TransportCatalogue {
    * мапа <имя маршрута> -> <указатель на маршрут>
    * `string_view` смотрит на строку в самой структуре маршрута
    */
-  std::unordered_map<std::string_view, const Bus *> buses_by_name_;
+  std::unordered_map<std::string_view, Bus *> buses_by_name_;
 
   /**
    * мапа с реальным расстоянием между остановками `first` и `second`
@@ -88,6 +91,8 @@ class TransportCatalogue {
                                          const Stop *to) const;
   std::vector<const Stop *> ResolveStopNames(
       const std::vector<std::string> &stop_names);
+  detail::StopDisKey ResolveStopPair(std::string_view from,
+                                     std::string_view to) const;
 };
 
 }  // namespace transport_catalogue
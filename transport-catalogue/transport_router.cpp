@@ -1,9 +1,25 @@
 #include "transport_router.h"
 
+#include <algorithm>
+#include <atomic>
 #include <cassert>
+#include <cstdint>
+#include <iterator>
+#include <limits>
+#include <stdexcept>
 #include <string>
+#include <thread>
+#include <utility>
 
+#include "bidirectional_dijkstra_router.h"
+#include "connection_scan_router.h"
+#include "contraction_hierarchy_router.h"
+#include "dijkstra_router.h"
 #include "domain.h"
+#include "geo.h"
+#include "hub_label_router.h"
+#include "raptor_router.h"
+#include "router_file.h"
 #include "transport_catalogue.h"
 
 using namespace std;
@@ -12,37 +28,278 @@ namespace transport_catalogue::router {
 
 Router::Router(const RouterSettings &settings,
                const TransportCatalogue &transport_catalogue)
-    : settings_(settings), transport_catalogue_(transport_catalogue) {
+    : settings_(settings),
+      transport_catalogue_(transport_catalogue),
+      timetable_router_(
+          make_unique<ConnectionScanRouter>(transport_catalogue)) {
+  if (settings_.engine == RouterEngine::RAPTOR) {
+    raptor_ = make_unique<RaptorRouter>(settings_, transport_catalogue_);
+    return;
+  }
+  if (!settings_.cache_file.empty() && LoadFromFile(settings_.cache_file)) {
+    if (!router_) {
+      BuildGraphRouter();
+    }
+    return;
+  }
   BuildStopGraph();
+  BuildGraphRouter();
+  if (!settings_.cache_file.empty()) {
+    try {
+      SaveToFile(settings_.cache_file);
+    } catch (const runtime_error &) {
+      // файл - только кэш: без него роутер строится заново при каждом запуске
+    }
+  }
 }
 
+Router::~Router() = default;
+
+namespace {
+
+// сторона решётки, на которую кладутся координаты остановок
+constexpr uint32_t HILBERT_SIDE = 1 << 16;
+
+/**
+ * Номер клетки `(x, y)` решётки `HILBERT_SIDE` x `HILBERT_SIDE` при обходе
+ * её кривой Гильберта. Соседние по номеру клетки соседствуют и на решётке.
+ */
+uint64_t GetHilbertIndex(uint32_t x, uint32_t y) {
+  uint64_t index = 0;
+  for (uint32_t side = HILBERT_SIDE / 2; side > 0; side /= 2) {
+    const uint32_t rx = (x & side) > 0;
+    const uint32_t ry = (y & side) > 0;
+    index += uint64_t{side} * side * ((3 * rx) ^ ry);
+    // поворот четверти, чтобы кривая в ней шла в нужную сторону
+    if (ry == 0) {
+      if (rx == 1) {
+        x = HILBERT_SIDE - 1 - x;
+        y = HILBERT_SIDE - 1 - y;
+      }
+      swap(x, y);
+    }
+  }
+  return index;
+}
+
+/**
+ * Упорядочить остановки вдоль кривой Гильберта по их координатам. При
+ * равных клетках сохраняется порядок справочника.
+ */
+void SortStopsAlongHilbertCurve(vector<const Stop *> &stops) {
+  if (stops.empty()) {
+    return;
+  }
+  auto [min_lat, max_lat] = minmax_element(
+      stops.begin(), stops.end(), [](const Stop *lhs, const Stop *rhs) {
+        return lhs->coords.lat < rhs->coords.lat;
+      });
+  auto [min_lng, max_lng] = minmax_element(
+      stops.begin(), stops.end(), [](const Stop *lhs, const Stop *rhs) {
+        return lhs->coords.lng < rhs->coords.lng;
+      });
+  const geo::Coordinates min_coords{(*min_lat)->coords.lat,
+                                    (*min_lng)->coords.lng};
+  const double lat_range = (*max_lat)->coords.lat - min_coords.lat;
+  const double lng_range = (*max_lng)->coords.lng - min_coords.lng;
+  auto to_cell = [](double offset, double range) {
+    return range > 0 ? static_cast<uint32_t>(offset / range *
+                                             (HILBERT_SIDE - 1))
+                     : 0u;
+  };
+
+  vector<pair<uint64_t, const Stop *>> keyed_stops;
+  keyed_stops.reserve(stops.size());
+  for (const Stop *stop : stops) {
+    keyed_stops.emplace_back(
+        GetHilbertIndex(to_cell(stop->coords.lng - min_coords.lng, lng_range),
+                        to_cell(stop->coords.lat - min_coords.lat, lat_range)),
+        stop);
+  }
+  stable_sort(keyed_stops.begin(), keyed_stops.end(),
+              [](const auto &lhs, const auto &rhs) {
+                return lhs.first < rhs.first;
+              });
+  for (size_t i = 0; i < stops.size(); ++i) {
+    stops[i] = keyed_stops[i].second;
+  }
+}
+
+}  // namespace
+
+/**
+ * Построить граф остановок. У каждой остановки две вершины: "ждём автобус"
+ * (`2 * i`) и "садимся в автобус" (`2 * i + 1`), между ними ребро ожидания.
+ * В модели `GraphModel::WAIT_FREE` вершина одна (`i`), а рёбер ожидания нет.
+ * Рёбра автобусов зависят от `settings_.graph_model`.
+ *
+ * С `settings_.reorder_vertices` остановки нумеруются не в порядке
+ * справочника, а вдоль кривой Гильберта: `i` выше - место остановки в этом
+ * порядке.
+ *
+ * Рёбра каждого автобуса строятся независимо, поэтому автобусы делятся между
+ * `settings_.router_threads` потоками. Готовые пачки рёбер добавляются в граф
+ * в порядке автобусов в справочнике, так что номера рёбер не зависят от
+ * числа потоков.
+ */
 void Router::BuildStopGraph() {
   unordered_map<const Stop *, graph::VertexId> id_by_stop;
   auto all_stops = transport_catalogue_.GetStops();
+  if (settings_.reorder_vertices) {
+    SortStopsAlongHilbertCurve(all_stops);
+  }
+  const size_t vertices_per_stop = GetVerticesPerStop();
   {
     graph::VertexId id = 0;
     for (const Stop *stop : all_stops) {
       id_by_stop[stop] = id;
       vertex_by_stop_name_[string_view(stop->name)] = id;
-      id += 2;
+      stop_by_vertex_.insert(stop_by_vertex_.end(), vertices_per_stop, stop);
+      id += vertices_per_stop;
+    }
+  }
+
+  const auto buses = transport_catalogue_.GetBuses();
+  const bool is_ride_chain = settings_.graph_model == GraphModel::RIDE_CHAIN;
+  // первая вершина цепочек каждого автобуса в модели `RIDE_CHAIN`
+  vector<graph::VertexId> first_chain_vertices(buses.size());
+  for (size_t i = 0; i < buses.size(); ++i) {
+    first_chain_vertices[i] = stop_by_vertex_.size();
+    const auto &stops = buses[i]->stops;
+    if (!is_ride_chain || stops.size() < 2) {
+      continue;
+    }
+    stop_by_vertex_.insert(stop_by_vertex_.end(), stops.begin(), stops.end());
+    if (buses[i]->route_type == RouteType::CIRCULAR) {
+      stop_by_vertex_.push_back(stops.front());
+    } else {
+      stop_by_vertex_.insert(stop_by_vertex_.end(), stops.rbegin(),
+                             stops.rend());
+    }
+  }
+  graph_builder_ =
+      graph::DirectedWeightedGraph<double>(stop_by_vertex_.size());
+
+  vector<EdgeBatch> batches(buses.size());
+  atomic<size_t> next_bus = 0;
+  auto build_batches = [&]() {
+    for (size_t i = next_bus++; i < buses.size(); i = next_bus++) {
+      batches[i] = is_ride_chain
+                       ? MakeRideChainBusEdges(buses[i], id_by_stop,
+                                               first_chain_vertices[i])
+                       : MakeAllPairsBusEdges(buses[i], id_by_stop);
+    }
+  };
+  size_t thread_count = settings_.router_threads;
+  if (thread_count == 0) {
+    thread_count = max(1u, thread::hardware_concurrency());
+  }
+  thread_count = max<size_t>(1, min(thread_count, buses.size()));
+  vector<thread> threads;
+  threads.reserve(thread_count - 1);
+  for (size_t i = 1; i < thread_count; ++i) {
+    threads.emplace_back(build_batches);
+  }
+  build_batches();
+  for (auto &thread : threads) {
+    thread.join();
+  }
+  AddBusEdges(move(batches));
+
+  if (settings_.graph_model != GraphModel::WAIT_FREE) {
+    double w = settings_.bus_wait_time * 60;
+    for (const Stop *stop : all_stops) {
+      auto v_wait = id_by_stop.at(stop);
+      AddGraphEdge({v_wait, v_wait + 1, w}, WaitEdge{stop});
     }
   }
+  FreezeStopGraph();
+  BuildReachabilityIndex();
+}
+
+/**
+ * Сколько вершин графа остановок у каждой остановки, см. `BuildStopGraph`.
+ */
+size_t Router::GetVerticesPerStop() const {
+  return settings_.graph_model == GraphModel::WAIT_FREE ? 1 : 2;
+}
 
+graph::EdgeId Router::AddGraphEdge(const graph::Edge<double> &graph_edge,
+                                   Edge edge) {
+  auto edge_id = graph_builder_.AddEdge(graph_edge);
+  assert(edge_id == edges_.size());
+  edges_.push_back(move(edge));
+  return edge_id;
+}
+
+/**
+ * Добавить в граф пачки рёбер автобусов по порядку.
+ *
+ * С `settings_.prune_bus_edges` из параллельных рёбер между одной парой
+ * вершин в граф попадает только самое быстрое: остальные не могут лежать на
+ * кратчайшем пути, если только не равны ему по весу. При равенстве
+ * остаётся ребро автобуса, добавленного в справочник раньше, а рёбра
+ * добавляются в порядке первого появления пары вершин, так что граф
+ * не зависит от порядка обхода хеш-таблиц.
+ */
+void Router::AddBusEdges(vector<EdgeBatch> batches) {
+  if (!settings_.prune_bus_edges ||
+      settings_.graph_model == GraphModel::RIDE_CHAIN) {
+    for (auto &batch : batches) {
+      for (auto &[graph_edge, edge] : batch) {
+        AddGraphEdge(graph_edge, move(edge));
+      }
+    }
+    return;
+  }
+
+  const uint64_t vertex_count = graph_builder_.GetVertexCount();
+  EdgeBatch kept_edges;
+  unordered_map<uint64_t, size_t> kept_edge_by_pair;
+  for (auto &batch : batches) {
+    for (auto &edge : batch) {
+      const uint64_t key = edge.first.from * vertex_count + edge.first.to;
+      auto [it, inserted] = kept_edge_by_pair.emplace(key, kept_edges.size());
+      if (inserted) {
+        kept_edges.push_back(move(edge));
+      } else if (edge.first.weight < kept_edges[it->second].first.weight) {
+        kept_edges[it->second] = move(edge);
+      }
+    }
+  }
+  for (auto &[graph_edge, edge] : kept_edges) {
+    AddGraphEdge(graph_edge, move(edge));
+  }
+}
+
+/**
+ * Рёбра автобуса модели `GraphModel::ALL_PAIRS`: из вершины посадки каждой
+ * остановки в вершину ожидания каждой следующей остановки маршрута. В модели
+ * `GraphModel::WAIT_FREE` - между вершинами остановок, и к весу ребра
+ * прибавляется время ожидания.
+ *
+ * С `settings_.prune_bus_edges` длины путей считаются за O(1) по префиксным
+ * суммам перегонов.
+ */
+Router::EdgeBatch Router::MakeAllPairsBusEdges(
+    const Bus *bus,
+    const unordered_map<const Stop *, graph::VertexId> &id_by_stop) const {
+  EdgeBatch result;
+  const auto &stops = bus->stops;
+  if (stops.size() < 2) {
+    return result;
+  }
   double v = settings_.bus_velocity * 1000 / 3600;
-  double w = settings_.bus_wait_time * 60;
-
-  stop_graph_ = graph::DirectedWeightedGraph<double>(all_stops.size() * 2);
-
-  auto buses = transport_catalogue_.GetBuses();
-  auto add_bus_edge = [this, &id_by_stop, v](const Bus *bus, const Stop *from,
-                                             const Stop *to, size_t span_len,
-                                             double route_len) {
-    auto v_from = id_by_stop.at(from) + 1;
-    auto v_to = id_by_stop.at(to);
-    auto time = route_len / v;
-    auto edge_id = stop_graph_.AddEdge({v_from, v_to, time});
-    assert(edge_id == edges_.size());
-    edges_.push_back(BusEdge{bus, span_len});
+  const bool use_prefix_sums = settings_.prune_bus_edges;
+  const bool is_wait_free = settings_.graph_model == GraphModel::WAIT_FREE;
+  const double w = is_wait_free ? settings_.bus_wait_time * 60 : 0;
+  const graph::VertexId board_offset = is_wait_free ? 0 : 1;
+
+  auto add_bus_edge = [&](const Stop *from, const Stop *to, size_t span_len,
+                          double route_len) {
+    result.push_back({{id_by_stop.at(from) + board_offset, id_by_stop.at(to),
+                       w + route_len / v},
+                      BusEdge{bus, span_len, route_len}});
   };
   auto calc_part_lengths = [this](const vector<const Stop *> &stops,
                                   bool inverse) {
@@ -55,83 +312,1093 @@ void Router::BuildStopGraph() {
     }
     return part_lengths;
   };
-  auto calc_route_length = [](const vector<double> &part_lens, size_t from,
-                              size_t to) {
+  // `prefix_lens[i]` - сумма первых `i` перегонов
+  auto calc_prefix_lengths = [](const vector<double> &part_lens) {
+    vector<double> prefix_lens(part_lens.size() + 1, 0);
+    for (size_t i = 0; i < part_lens.size(); ++i) {
+      prefix_lens[i + 1] = prefix_lens[i] + part_lens[i];
+    }
+    return prefix_lens;
+  };
+  auto calc_route_length = [use_prefix_sums](const vector<double> &part_lens,
+                                             const vector<double> &prefix_lens,
+                                             size_t from, size_t to) {
+    if (use_prefix_sums) {
+      return prefix_lens[to] - prefix_lens[from];
+    }
     double length = 0;
     for (size_t i = from; i != to; ++i) {
       length += part_lens[i];
     }
     return length;
   };
-  for (const Bus *bus : buses) {
-    const auto &stops = bus->stops;
-    if (stops.size() < 2) {
+
+  vector<double> part_lens = calc_part_lengths(stops, false);
+  vector<double> inv_part_lens;
+  vector<double> prefix_lens;
+  vector<double> inv_prefix_lens;
+
+  if (bus->route_type == RouteType::LINEAR) {
+    inv_part_lens = calc_part_lengths(stops, true);
+  }
+  if (use_prefix_sums) {
+    prefix_lens = calc_prefix_lengths(part_lens);
+    inv_prefix_lens = calc_prefix_lengths(inv_part_lens);
+  }
+  for (size_t i = 0; i < stops.size() - 1; ++i) {
+    for (size_t j = i + 1; j < stops.size(); ++j) {
+      add_bus_edge(stops[i], stops[j], j - i,
+                   calc_route_length(part_lens, prefix_lens, i, j));
+      if (bus->route_type == RouteType::LINEAR) {
+        add_bus_edge(stops[j], stops[i], j - i,
+                     calc_route_length(inv_part_lens, inv_prefix_lens, i, j));
+      }
+    }
+  }
+  if (bus->route_type == RouteType::CIRCULAR) {
+    double depo_len =
+        transport_catalogue_.GetRealDistance(stops.back(), stops[0]);
+    for (size_t i = 1; i < stops.size(); ++i) {
+      add_bus_edge(stops[i], stops[0], stops.size() - i,
+                   calc_route_length(part_lens, prefix_lens, i,
+                                     stops.size() - 1) +
+                       depo_len);
+    }
+  }
+  return result;
+}
+
+/**
+ * Рёбра автобуса модели `GraphModel::RIDE_CHAIN`. На каждый проезд автобуса
+ * в одну сторону (у линейного - туда и обратно, у кольцевого - круг с первой
+ * остановкой в конце) заводится цепочка вершин "в автобусе у `k`-й
+ * остановки", соединённых рёбрами перегонов. Из вершины посадки остановки в
+ * цепочку ведёт ребро посадки, из цепочки в вершину ожидания - ребро
+ * высадки, оба нулевого веса. Сесть нельзя только в последней вершине
+ * цепочки, а выйти - только в первой. Поэтому кольцо можно проехать целиком,
+ * сев на первой остановке и выйдя на ней же в конце цепочки, но не дальше:
+ * на второй круг без пересадки не уехать.
+ *
+ * Вершины цепочек автобуса идут подряд начиная с `first_vertex`.
+ */
+Router::EdgeBatch Router::MakeRideChainBusEdges(
+    const Bus *bus,
+    const unordered_map<const Stop *, graph::VertexId> &id_by_stop,
+    graph::VertexId first_vertex) const {
+  EdgeBatch result;
+  const auto &stops = bus->stops;
+  if (stops.size() < 2) {
+    return result;
+  }
+  double v = settings_.bus_velocity * 1000 / 3600;
+  graph::VertexId next_vertex = first_vertex;
+
+  auto add_chain = [&](const vector<const Stop *> &chain_stops) {
+    const graph::VertexId first = next_vertex;
+    next_vertex += chain_stops.size();
+    for (size_t k = 0; k < chain_stops.size(); ++k) {
+      const graph::VertexId v_stop = id_by_stop.at(chain_stops[k]);
+      if (k + 1 < chain_stops.size()) {
+        result.push_back({{v_stop + 1, first + k, 0}, BoardEdge{bus}});
+        const double length = transport_catalogue_.GetRealDistance(
+            chain_stops[k], chain_stops[k + 1]);
+        result.push_back(
+            {{first + k, first + k + 1, length / v}, RideEdge{length}});
+      }
+      if (k > 0) {
+        result.push_back({{first + k, v_stop, 0}, AlightEdge{}});
+      }
+    }
+  };
+  if (bus->route_type == RouteType::CIRCULAR) {
+    auto circle = stops;
+    circle.push_back(stops.front());
+    add_chain(circle);
+  } else {
+    add_chain(stops);
+    add_chain({stops.rbegin(), stops.rend()});
+  }
+  return result;
+}
+
+/**
+ * Перенести собранный граф в `stop_graph_` и переставить описания рёбер
+ * в `edges_` под номера рёбер CSR-графа.
+ */
+void Router::FreezeStopGraph() {
+  stop_graph_ = StopGraph(graph_builder_);
+  graph_builder_ = {};
+  vector<Edge> edges;
+  edges.reserve(edges_.size());
+  for (graph::EdgeId id = 0; id < stop_graph_.GetEdgeCount(); ++id) {
+    edges.push_back(move(edges_[stop_graph_.GetSourceEdgeId(id)]));
+  }
+  edges_ = move(edges);
+}
+
+namespace {
+
+using FloydWarshallRouter =
+    graph::Router<double, graph::CsrGraph<double>>;
+
+/**
+ * Проверить, что массивы графа согласованы и номера в них не выходят за
+ * границы: повреждённый файл не должен приводить к чтению за пределами
+ * массивов.
+ */
+bool IsValidGraphData(const graph::CsrGraph<double>::Data &data) {
+  const size_t vertex_count = data.vertex_count;
+  const size_t edge_count = data.edge_count;
+  for (const auto *offsets : {data.offsets, data.incoming_offsets}) {
+    if (offsets[0] != 0 || offsets[vertex_count] != edge_count) {
+      return false;
+    }
+    for (size_t i = 0; i < vertex_count; ++i) {
+      if (offsets[i] > offsets[i + 1]) {
+        return false;
+      }
+    }
+  }
+  for (size_t i = 0; i < edge_count; ++i) {
+    if (data.sources[i] >= vertex_count || data.targets[i] >= vertex_count ||
+        data.incoming_edges[i] >= edge_count) {
+      return false;
+    }
+  }
+  return true;
+}
+
+}  // namespace
+
+/**
+ * Записать в файл `path` граф остановок, описания его рёбер, остановки
+ * вершин и, для `RouterEngine::FLOYD_WARSHALL` без
+ * `RouterSettings::reduce_to_transfer_stops`, таблицу маршрутов. Формат
+ * описан в `RouterFileHeader`, вместе с данными записываются хеши
+ * справочника и настроек.
+ *
+ * Кидает `logic_error` для `RouterEngine::RAPTOR`, у которого нет графа
+ * остановок, и `runtime_error`, если файл не удалось записать.
+ */
+void Router::SaveToFile(const string &path) const {
+  if (settings_.engine == RouterEngine::RAPTOR) {
+    throw logic_error("RAPTOR router has no stop graph to save"s);
+  }
+  unordered_map<const Stop *, uint32_t> stop_index;
+  for (const Stop *stop : transport_catalogue_.GetStops()) {
+    stop_index.emplace(stop, static_cast<uint32_t>(stop_index.size()));
+  }
+  unordered_map<const Bus *, uint32_t> bus_index;
+  for (const Bus *bus : transport_catalogue_.GetBuses()) {
+    bus_index.emplace(bus, static_cast<uint32_t>(bus_index.size()));
+  }
+
+  const auto *table =
+      UsesFullTable()
+          ? static_cast<const FloydWarshallRouter *>(router_.get())
+          : nullptr;
+  const auto &data = stop_graph_.GetData();
+  RouterFileHeader header{};
+  copy(begin(RouterFileHeader::MAGIC), end(RouterFileHeader::MAGIC),
+       header.magic);
+  header.version = RouterFileHeader::VERSION;
+  header.byte_order_mark = RouterFileHeader::BYTE_ORDER_MARK;
+  header.catalogue_hash = HashCatalogue(transport_catalogue_);
+  header.settings_hash = HashRouterSettings(settings_);
+  header.vertex_count = data.vertex_count;
+  header.edge_count = data.edge_count;
+  if (table != nullptr) {
+    header.prev_edge_size = visit(
+        [](const auto *prev_edges) { return sizeof(*prev_edges); },
+        table->GetPrevEdges());
+  }
+
+  vector<uint32_t> vertex_stops;
+  vertex_stops.reserve(stop_by_vertex_.size());
+  for (const Stop *stop : stop_by_vertex_) {
+    vertex_stops.push_back(stop_index.at(stop));
+  }
+  vector<RouterFileEdge> file_edges;
+  file_edges.reserve(edges_.size());
+  for (const Edge &edge : edges_) {
+    RouterFileEdge &file_edge = file_edges.emplace_back();
+    file_edge = {static_cast<uint32_t>(edge.index()), 0, 0, 0};
+    if (const auto *wait_edge = get_if<WaitEdge>(&edge)) {
+      file_edge.object = stop_index.at(wait_edge->stop);
+    } else if (const auto *bus_edge = get_if<BusEdge>(&edge)) {
+      file_edge.object = bus_index.at(bus_edge->bus);
+      file_edge.span_len = bus_edge->span_len;
+      file_edge.distance = bus_edge->distance;
+    } else if (const auto *board_edge = get_if<BoardEdge>(&edge)) {
+      file_edge.object = bus_index.at(board_edge->bus);
+    } else if (const auto *ride_edge = get_if<RideEdge>(&edge)) {
+      file_edge.distance = ride_edge->distance;
+    }
+  }
+
+  const size_t vertex_count = data.vertex_count;
+  const size_t edge_count = data.edge_count;
+  RouterFileWriter writer{path};
+  writer.Write(&header, 1);
+  writer.Write(data.offsets, vertex_count + 1);
+  writer.Write(data.sources, edge_count);
+  writer.Write(data.targets, edge_count);
+  writer.Write(data.weights, edge_count);
+  writer.Write(data.incoming_offsets, vertex_count + 1);
+  writer.Write(data.incoming_edges, edge_count);
+  writer.Write(data.source_edge_ids, edge_count);
+  writer.Write(vertex_stops.data(), vertex_count);
+  writer.Write(file_edges.data(), edge_count);
+  if (table != nullptr) {
+    const size_t cell_count = vertex_count * vertex_count;
+    writer.Write(table->GetWeights(), cell_count);
+    visit([&](const auto *prev_edges) { writer.Write(prev_edges, cell_count); },
+          table->GetPrevEdges());
+  }
+  writer.Finish();
+}
+
+/**
+ * Загрузить то, что записал `SaveToFile`. Вернёт `false`, если файла нет,
+ * он повреждён или записан другой версией формата, по другому справочнику
+ * или с другими настройками.
+ *
+ * Массивы графа и таблица маршрутов не копируются: `stop_graph_` и движок
+ * смотрят прямо в отображённый в память файл. Граф проверяется на
+ * согласованность, таблица маршрутов - нет: её проверка стоила бы O(V^2).
+ */
+bool Router::LoadFromFile(const string &path) {
+  auto file = make_unique<MappedFile>(path);
+  RouterFileReader reader{file->GetData(), file->GetSize()};
+  const auto *header = reader.Read<RouterFileHeader>(1);
+  if (header == nullptr ||
+      !equal(begin(RouterFileHeader::MAGIC), end(RouterFileHeader::MAGIC),
+             header->magic) ||
+      header->version != RouterFileHeader::VERSION ||
+      header->byte_order_mark != RouterFileHeader::BYTE_ORDER_MARK ||
+      header->catalogue_hash != HashCatalogue(transport_catalogue_) ||
+      header->settings_hash != HashRouterSettings(settings_) ||
+      header->vertex_count >= numeric_limits<uint32_t>::max() ||
+      header->edge_count >= numeric_limits<uint32_t>::max()) {
+    return false;
+  }
+
+  const size_t vertex_count = header->vertex_count;
+  const size_t edge_count = header->edge_count;
+  StopGraph::Data data;
+  data.vertex_count = vertex_count;
+  data.edge_count = edge_count;
+  data.offsets = reader.Read<uint32_t>(vertex_count + 1);
+  data.sources = reader.Read<uint32_t>(edge_count);
+  data.targets = reader.Read<uint32_t>(edge_count);
+  data.weights = reader.Read<double>(edge_count);
+  data.incoming_offsets = reader.Read<uint32_t>(vertex_count + 1);
+  data.incoming_edges = reader.Read<uint32_t>(edge_count);
+  data.source_edge_ids = reader.Read<uint32_t>(edge_count);
+  const auto *vertex_stops = reader.Read<uint32_t>(vertex_count);
+  const auto *file_edges = reader.Read<RouterFileEdge>(edge_count);
+  const size_t cell_count = vertex_count * vertex_count;
+  const double *table_weights = nullptr;
+  FloydWarshallRouter::PrevEdgesData table_prev_edges;
+  if (header->prev_edge_size != 0) {
+    table_weights = reader.Read<double>(cell_count);
+  }
+  if (header->prev_edge_size == sizeof(uint32_t)) {
+    table_prev_edges = reader.Read<uint32_t>(cell_count);
+  } else if (header->prev_edge_size == sizeof(uint64_t)) {
+    table_prev_edges = reader.Read<uint64_t>(cell_count);
+  } else if (header->prev_edge_size != 0) {
+    return false;
+  }
+  if (!reader.IsAtEnd() || UsesFullTable() != (table_weights != nullptr) ||
+      !IsValidGraphData(data)) {
+    return false;
+  }
+
+  const auto stops = transport_catalogue_.GetStops();
+  const auto buses = transport_catalogue_.GetBuses();
+  if (vertex_count < stops.size() * GetVerticesPerStop()) {
+    return false;
+  }
+  vector<const Stop *> stop_by_vertex(vertex_count);
+  for (size_t i = 0; i < vertex_count; ++i) {
+    if (vertex_stops[i] >= stops.size()) {
+      return false;
+    }
+    stop_by_vertex[i] = stops[vertex_stops[i]];
+  }
+  vector<Edge> edges;
+  edges.reserve(edge_count);
+  for (size_t i = 0; i < edge_count; ++i) {
+    // `kind` - номер альтернативы `Edge`: остановка нужна `WaitEdge`,
+    // автобус - `BusEdge` и `BoardEdge`
+    const RouterFileEdge &file_edge = file_edges[i];
+    const size_t object_count =
+        file_edge.kind == 0 ? stops.size() : buses.size();
+    if (file_edge.kind >= variant_size_v<Edge> ||
+        (file_edge.kind <= 2 && file_edge.object >= object_count)) {
+      return false;
+    }
+    switch (file_edge.kind) {
+      case 0:
+        edges.push_back(WaitEdge{stops[file_edge.object]});
+        break;
+      case 1:
+        edges.push_back(BusEdge{buses[file_edge.object], file_edge.span_len,
+                                file_edge.distance});
+        break;
+      case 2:
+        edges.push_back(BoardEdge{buses[file_edge.object]});
+        break;
+      case 3:
+        edges.push_back(RideEdge{file_edge.distance});
+        break;
+      default:
+        edges.push_back(AlightEdge{});
+        break;
+    }
+  }
+
+  mapped_file_ = move(file);
+  stop_graph_ = StopGraph(data);
+  BuildReachabilityIndex();
+  edges_ = move(edges);
+  stop_by_vertex_ = move(stop_by_vertex);
+  // вершины остановок идут первыми, порядок остановок записан в файле
+  for (size_t vertex = 0; vertex < stops.size() * GetVerticesPerStop();
+       vertex += GetVerticesPerStop()) {
+    vertex_by_stop_name_[string_view(stop_by_vertex_[vertex]->name)] = vertex;
+  }
+  if (table_weights != nullptr) {
+    router_ = make_unique<FloydWarshallRouter>(stop_graph_, table_weights,
+                                               table_prev_edges);
+  }
+  return true;
+}
+
+/**
+ * Учесть изменения справочника после создания роутера: новые маршруты и
+ * остановки, расстояния, изменённые через
+ * `TransportCatalogue::ChangeDistance`.
+ *
+ * Граф остановок строится заново, это O(E). Таблица
+ * `RouterEngine::FLOYD_WARSHALL` при тех же вершинах графа не считается с
+ * нуля, а обновляется через `graph::Router::Update`, если она посчитана не
+ * только между пересадочными остановками. Вершины добавляются
+ * вместе с остановками, а в модели `GraphModel::RIDE_CHAIN` - и с
+ * маршрутами. Остальные движки и кэш деревьев строятся заново, поиск по
+ * расписанию - тоже.
+ */
+void Router::Update() {
+  timetable_router_ = make_unique<ConnectionScanRouter>(transport_catalogue_);
+  if (settings_.engine == RouterEngine::RAPTOR) {
+    raptor_ = make_unique<RaptorRouter>(settings_, transport_catalogue_);
+    ClearProfileRouters();
+    return;
+  }
+  trees_.clear();
+  tree_by_source_.clear();
+  tree_cache_stats_.size = 0;
+  // графы профилей смотрят в массивы старого графа
+  ClearProfileRouters();
+
+  // движок смотрит на `stop_graph_`, а старый граф нужен ему для обновления
+  StopGraph old_graph = move(stop_graph_);
+  edges_.clear();
+  vertex_by_stop_name_.clear();
+  stop_by_vertex_.clear();
+  BuildStopGraph();
+  if (UsesFullTable() &&
+      stop_graph_.GetVertexCount() == old_graph.GetVertexCount()) {
+    static_cast<FloydWarshallRouter &>(*router_).Update(
+        old_graph, settings_.router_threads);
+  } else {
+    BuildGraphRouter();
+  }
+  // граф и таблица маршрутов больше не смотрят в файл
+  mapped_file_.reset();
+}
+
+/**
+ * Создать движок поиска маршрутов в графе остановок, выбранный в настройках.
+ * С кэшем деревьев маршруты ищутся по деревьям, и движок не нужен: для
+ * `RouterEngine::FLOYD_WARSHALL` это сберегает O(V^3) подготовки и таблицу
+ * на V^2 ячеек.
+ */
+void Router::BuildGraphRouter() {
+  if (UsesTreeCache()) {
+    router_.reset();
+    return;
+  }
+  switch (settings_.engine) {
+    case RouterEngine::FLOYD_WARSHALL:
+      if (UsesTransferStops()) {
+        BuildCoreGraph();
+        router_ = make_unique<FloydWarshallRouter>(core_graph_,
+                                                   settings_.router_threads);
+      } else {
+        router_ = make_unique<FloydWarshallRouter>(stop_graph_,
+                                                   settings_.router_threads);
+      }
+      break;
+    case RouterEngine::DIJKSTRA:
+      router_ =
+          make_unique<graph::DijkstraRouter<double, StopGraph>>(stop_graph_);
+      break;
+    case RouterEngine::BIDIRECTIONAL_DIJKSTRA:
+      router_ = make_unique<
+          graph::BidirectionalDijkstraRouter<double, StopGraph>>(stop_graph_);
+      break;
+    case RouterEngine::A_STAR:
+      router_ = make_unique<graph::AStarRouter<double, StopGraph>>(
+          stop_graph_, MakeGeoPotential());
+      break;
+    case RouterEngine::ALT:
+      router_ = make_unique<graph::AltRouter<double, StopGraph>>(
+          stop_graph_, settings_.landmark_count);
+      break;
+    case RouterEngine::CONTRACTION_HIERARCHY:
+      router_ = make_unique<
+          graph::ContractionHierarchyRouter<double, StopGraph>>(stop_graph_);
+      break;
+    case RouterEngine::HUB_LABELS:
+      router_ =
+          make_unique<graph::HubLabelRouter<double, StopGraph>>(stop_graph_);
+      break;
+    case RouterEngine::RAPTOR:
+      // граф остановок для RAPTOR не нужен, см. конструктор
+      break;
+  }
+}
+
+bool Router::UsesTreeCache() const {
+  return settings_.tree_cache_size > 0 &&
+         settings_.engine != RouterEngine::RAPTOR;
+}
+
+/**
+ * Ищет ли маршруты таблица `RouterEngine::FLOYD_WARSHALL` по всему графу
+ * остановок. Только она записывается в файл и обновляется через
+ * `graph::Router::Update`: таблицу между пересадочными остановками дешевле
+ * посчитать заново.
+ */
+bool Router::UsesFullTable() const {
+  return settings_.engine == RouterEngine::FLOYD_WARSHALL &&
+         !UsesTreeCache() && !UsesTransferStops();
+}
+
+bool Router::UsesTransferStops() const {
+  return settings_.reduce_to_transfer_stops &&
+         settings_.engine == RouterEngine::FLOYD_WARSHALL &&
+         settings_.graph_model == GraphModel::ALL_PAIRS && !UsesTreeCache();
+}
+
+/**
+ * Построить `core_graph_` - подграф графа остановок на вершинах
+ * пересадочных остановок. Пересадочная остановка - та, через которую идёт
+ * больше одного автобуса, конечная или та, которую автобус проезжает
+ * несколько раз.
+ *
+ * Через любую другую остановку идёт ровно один автобус, и все рёбра графа
+ * остановок у неё - рёбра этого автобуса. Поездку до неё, ожидание и
+ * поездку дальше можно заменить одним ребром того же автобуса не тяжелее:
+ * длина маршрута та же, а ожидания нет. Поэтому кратчайшие пути между
+ * пересадочными остановками в `core_graph_` те же, что в графе остановок.
+ */
+void Router::BuildCoreGraph() {
+  // конечные считаются лишний раз, чтобы попасть в пересадочные
+  unordered_map<const Stop *, size_t> visit_counts;
+  for (const Bus *bus : transport_catalogue_.GetBuses()) {
+    if (bus->stops.empty()) {
       continue;
     }
-    vector<double> part_lens = calc_part_lengths(stops, false);
-    vector<double> inv_part_lens;
+    ++visit_counts[bus->stops.front()];
+    ++visit_counts[bus->stops.back()];
+    for (const Stop *stop : bus->stops) {
+      ++visit_counts[stop];
+    }
+  }
 
-    if (bus->route_type == RouteType::LINEAR) {
-      inv_part_lens = calc_part_lengths(stops, true);
+  core_vertices_.assign(stop_graph_.GetVertexCount(), NO_CORE_VERTEX);
+  graph::VertexId core_vertex_count = 0;
+  for (const Stop *stop : transport_catalogue_.GetStops()) {
+    if (auto it = visit_counts.find(stop);
+        it == visit_counts.end() || it->second < 2) {
+      continue;
     }
-    for (size_t i = 0; i < stops.size() - 1; ++i) {
-      for (size_t j = i + 1; j < stops.size(); ++j) {
-        add_bus_edge(bus, stops[i], stops[j], j - i,
-                     calc_route_length(part_lens, i, j));
-        if (bus->route_type == RouteType::LINEAR) {
-          add_bus_edge(bus, stops[j], stops[i], j - i,
-                       calc_route_length(inv_part_lens, i, j));
+    const graph::VertexId v_wait = vertex_by_stop_name_.at(stop->name);
+    core_vertices_[v_wait] = core_vertex_count++;
+    core_vertices_[v_wait + 1] = core_vertex_count++;
+  }
+
+  graph::DirectedWeightedGraph<double> core_builder(core_vertex_count);
+  vector<graph::EdgeId> edge_ids;
+  for (graph::EdgeId edge_id = 0; edge_id < stop_graph_.GetEdgeCount();
+       ++edge_id) {
+    const auto edge = stop_graph_.GetEdge(edge_id);
+    const graph::VertexId core_from = core_vertices_[edge.from];
+    const graph::VertexId core_to = core_vertices_[edge.to];
+    if (core_from != NO_CORE_VERTEX && core_to != NO_CORE_VERTEX) {
+      core_builder.AddEdge({core_from, core_to, edge.weight});
+      edge_ids.push_back(edge_id);
+    }
+  }
+  core_graph_ = StopGraph(core_builder);
+  core_edge_ids_.clear();
+  core_edge_ids_.reserve(edge_ids.size());
+  for (graph::EdgeId id = 0; id < core_graph_.GetEdgeCount(); ++id) {
+    core_edge_ids_.push_back(edge_ids[core_graph_.GetSourceEdgeId(id)]);
+  }
+}
+
+/**
+ * Оценка снизу для времени пути между вершинами по расстоянию по прямой между
+ * их остановками.
+ *
+ * Реальные расстояния между остановками задаются во входных данных и могут
+ * оказаться меньше расстояния по прямой, поэтому делить на скорость автобуса
+ * нельзя: оценка могла бы превысить настоящее время. Вместо этого берётся
+ * наименьшее по всем рёбрам графа отношение времени ребра к расстоянию по
+ * прямой между его концами. Тогда по неравенству треугольника время любого
+ * пути не меньше этого отношения, умноженного на расстояние по прямой между
+ * началом и концом пути.
+ */
+graph::AStarRouter<double, Router::StopGraph>::Potential
+Router::MakeGeoPotential() const {
+  // `geo::ComputeDistance` считает близкие точки совпадающими и теряет
+  // точность на малых расстояниях, поэтому неравенство треугольника для неё
+  // выполняется лишь приблизительно; оценку немного занижаем с запасом
+  static constexpr double SAFETY_FACTOR = 0.99;
+  static constexpr double SLACK_METERS = 1.0;
+
+  optional<double> seconds_per_meter;
+  for (graph::EdgeId edge_id = 0; edge_id < stop_graph_.GetEdgeCount();
+       ++edge_id) {
+    const auto &edge = stop_graph_.GetEdge(edge_id);
+    const double crow_distance =
+        geo::ComputeDistance(stop_by_vertex_[edge.from]->coords,
+                             stop_by_vertex_[edge.to]->coords);
+    if (crow_distance > 0) {
+      const double ratio = edge.weight / crow_distance;
+      seconds_per_meter =
+          seconds_per_meter ? min(*seconds_per_meter, ratio) : ratio;
+    }
+  }
+  const double factor = seconds_per_meter.value_or(0) * SAFETY_FACTOR;
+
+  vector<geo::Coordinates> coords;
+  coords.reserve(stop_by_vertex_.size());
+  for (const Stop *stop : stop_by_vertex_) {
+    coords.push_back(stop->coords);
+  }
+  return [coords = move(coords), factor](
+             graph::VertexId vertex,
+             graph::VertexId target) -> optional<double> {
+    const double crow_distance =
+        geo::ComputeDistance(coords[vertex], coords[target]);
+    return max(0.0, crow_distance - SLACK_METERS) * factor;
+  };
+}
+
+optional<graph::AbstractRouter<double>::RouteInfo> Router::BuildGraphRoute(
+    graph::VertexId from, graph::VertexId to) const {
+  if (!UsesTreeCache()) {
+    return UsesTransferStops() ? BuildCoreRoute(from, to)
+                               : router_->BuildRoute(from, to);
+  }
+  return GetShortestPathTree(from).BuildRoute(to);
+}
+
+/**
+ * Маршрут между вершинами ожидания `from` и `to` по таблице `core_graph_`.
+ *
+ * С непересадочной остановки маршрут начинается ожиданием и ребром её
+ * автобуса до пересадочной остановки или сразу до `to`, а на непересадочную
+ * остановку приходит ребром автобуса из вершины посадки пересадочной, см.
+ * `BuildCoreGraph`. Перебираются все пересадочные остановки автобуса, а не
+ * только ближайшие: проехать ближайшую не выходя быстрее, чем ждать на ней
+ * тот же автобус. Пар начала и конца не больше, чем произведение числа
+ * пересадочных остановок на автобусах `from` и `to`.
+ */
+optional<graph::AbstractRouter<double>::RouteInfo> Router::BuildCoreRoute(
+    graph::VertexId from, graph::VertexId to) const {
+  using RouteInfo = graph::AbstractRouter<double>::RouteInfo;
+  if (from == to) {
+    return RouteInfo{0, {}};
+  }
+  // вершина `core_graph_`, время до неё из `from` (или из неё до `to`) и
+  // рёбра графа остановок этой части маршрута
+  struct Attachment {
+    graph::VertexId core_vertex;
+    double weight;
+    vector<graph::EdgeId> edges;
+  };
+  optional<RouteInfo> best_route;
+  auto consider_direct = [&](double weight, vector<graph::EdgeId> edges) {
+    if (!best_route || weight < best_route->weight) {
+      best_route = RouteInfo{weight, move(edges)};
+    }
+  };
+
+  vector<Attachment> sources;
+  if (core_vertices_[from] != NO_CORE_VERTEX) {
+    sources.push_back({core_vertices_[from], 0, {}});
+  } else {
+    // из вершины ожидания выходит только ребро ожидания
+    for (graph::EdgeId wait_edge_id : stop_graph_.GetIncidentEdges(from)) {
+      const auto wait_edge = stop_graph_.GetEdge(wait_edge_id);
+      for (graph::EdgeId bus_edge_id :
+           stop_graph_.GetIncidentEdges(wait_edge.to)) {
+        const auto bus_edge = stop_graph_.GetEdge(bus_edge_id);
+        const double weight = wait_edge.weight + bus_edge.weight;
+        if (bus_edge.to == to) {
+          consider_direct(weight, {wait_edge_id, bus_edge_id});
+        }
+        if (core_vertices_[bus_edge.to] != NO_CORE_VERTEX) {
+          sources.push_back({core_vertices_[bus_edge.to], weight,
+                             {wait_edge_id, bus_edge_id}});
         }
       }
     }
-    if (bus->route_type == RouteType::CIRCULAR) {
-      double depo_len =
-          transport_catalogue_.GetRealDistance(stops.back(), stops[0]);
-      for (size_t i = 1; i < stops.size(); ++i) {
-        add_bus_edge(
-            bus, stops[i], stops[0], stops.size() - i,
-            calc_route_length(part_lens, i, stops.size() - 1) + depo_len);
+  }
+  vector<Attachment> targets;
+  if (core_vertices_[to] != NO_CORE_VERTEX) {
+    targets.push_back({core_vertices_[to], 0, {}});
+  } else {
+    for (graph::EdgeId bus_edge_id : stop_graph_.GetIncomingEdges(to)) {
+      const auto bus_edge = stop_graph_.GetEdge(bus_edge_id);
+      if (core_vertices_[bus_edge.from] != NO_CORE_VERTEX) {
+        targets.push_back(
+            {core_vertices_[bus_edge.from], bus_edge.weight, {bus_edge_id}});
       }
     }
   }
-  for (const Stop *stop : all_stops) {
-    auto v_wait = id_by_stop.at(stop);
-    auto v_bus = v_wait + 1;
-    auto edge_id = stop_graph_.AddEdge({v_wait, v_bus, w});
-    assert(edge_id == edges_.size());
-    edges_.push_back(WaitEdge{stop});
+
+  const auto &table = static_cast<const FloydWarshallRouter &>(*router_);
+  const double *table_weights = table.GetWeights();
+  const size_t core_vertex_count = core_graph_.GetVertexCount();
+  const Attachment *best_source = nullptr;
+  const Attachment *best_target = nullptr;
+  double best_weight = numeric_limits<double>::infinity();
+  for (const Attachment &source : sources) {
+    const double *row = table_weights + source.core_vertex * core_vertex_count;
+    for (const Attachment &target : targets) {
+      const double weight =
+          source.weight + row[target.core_vertex] + target.weight;
+      if (weight < best_weight) {
+        best_weight = weight;
+        best_source = &source;
+        best_target = &target;
+      }
+    }
+  }
+  if (best_source == nullptr ||
+      (best_route && !(best_weight < best_route->weight))) {
+    return best_route;
   }
 
-  router_ = make_unique<graph::Router<double>>(stop_graph_);
+  auto core_route =
+      table.BuildRoute(best_source->core_vertex, best_target->core_vertex);
+  vector<graph::EdgeId> edges = best_source->edges;
+  for (graph::EdgeId edge_id : core_route->edges) {
+    edges.push_back(core_edge_ids_[edge_id]);
+  }
+  edges.insert(edges.end(), best_target->edges.begin(),
+               best_target->edges.end());
+  return RouteInfo{best_weight, move(edges)};
 }
 
-optional<RouteResult> Router::CalcRoute(string_view from,
-                                        string_view to) const {
-  if (vertex_by_stop_name_.count(from) == 0 ||
-      vertex_by_stop_name_.count(to) == 0) {
-    return nullopt;
+/**
+ * Дерево кратчайших путей из `source`: из кэша или построенное заново. Если
+ * кэш заполнен, из него вытесняется дерево, которое дольше всех не
+ * использовалось.
+ */
+const graph::ShortestPathTree<double, Router::StopGraph> &
+Router::GetShortestPathTree(graph::VertexId source) const {
+  if (auto it = tree_by_source_.find(source); it != tree_by_source_.end()) {
+    ++tree_cache_stats_.hits;
+    trees_.splice(trees_.begin(), trees_, it->second);
+    return trees_.front();
   }
-  graph::VertexId v_from = vertex_by_stop_name_.at(from);
-  graph::VertexId v_to = vertex_by_stop_name_.at(to);
-  auto route_opt = router_->BuildRoute(v_from, v_to);
-  if (!route_opt) {
+  ++tree_cache_stats_.misses;
+  if (trees_.size() == settings_.tree_cache_size) {
+    tree_by_source_.erase(trees_.back().GetSource());
+    trees_.pop_back();
+    ++tree_cache_stats_.evictions;
+  }
+  trees_.emplace_front(stop_graph_, source);
+  tree_by_source_[source] = trees_.begin();
+  tree_cache_stats_.size = trees_.size();
+  return trees_.front();
+}
+
+optional<graph::VertexId> Router::FindStopVertex(string_view stop) const {
+  if (auto it = vertex_by_stop_name_.find(stop);
+      it != vertex_by_stop_name_.end()) {
+    return it->second;
+  }
+  return nullopt;
+}
+
+void Router::BuildReachabilityIndex() {
+  if (settings_.use_reachability_index) {
+    reachability_.emplace(stop_graph_);
+  } else {
+    reachability_.reset();
+  }
+}
+
+/**
+ * Может ли быть путь из `from` в `to`. Без индекса достижимости ответ
+ * всегда `true`, и отсутствие пути обнаруживает сам поиск.
+ */
+bool Router::IsReachable(graph::VertexId from, graph::VertexId to) const {
+  return !reachability_ || reachability_->IsReachable(from, to);
+}
+
+/**
+ * Граф остановок и движок для скорости `bus_velocity` и времени ожидания
+ * `bus_wait_time`: из кэша или построенные заново. Вес каждого ребра
+ * считается по его описанию в `edges_` так же, как при построении графа,
+ * остальные массивы графа берутся у `stop_graph_` без копирования. Если кэш
+ * заполнен, из него вытесняется профиль, который дольше всех не
+ * использовался.
+ *
+ * Кидает `invalid_argument`, если скорость не положительна или время
+ * ожидания отрицательно.
+ */
+const Router::ProfileRouter &Router::GetProfileRouter(
+    double bus_velocity, double bus_wait_time) const {
+  if (!(bus_velocity > 0)) {
+    throw invalid_argument("bus velocity should be positive"s);
+  }
+  if (!(bus_wait_time >= 0)) {
+    throw invalid_argument("bus wait time should be non-negative"s);
+  }
+  const pair profile{bus_velocity, bus_wait_time};
+  if (auto it = profile_router_by_profile_.find(profile);
+      it != profile_router_by_profile_.end()) {
+    ++profile_cache_stats_.hits;
+    profile_routers_.splice(profile_routers_.begin(), profile_routers_,
+                            it->second);
+    return profile_routers_.front();
+  }
+  ++profile_cache_stats_.misses;
+  if (!profile_routers_.empty() &&
+      profile_routers_.size() >= settings_.profile_cache_size) {
+    profile_router_by_profile_.erase(profile_routers_.back().profile);
+    profile_routers_.pop_back();
+    ++profile_cache_stats_.evictions;
+  }
+  ProfileRouter &profile_router = profile_routers_.emplace_front();
+  profile_router.profile = profile;
+  profile_router_by_profile_[profile] = profile_routers_.begin();
+  profile_cache_stats_.size = profile_routers_.size();
+  if (settings_.engine == RouterEngine::RAPTOR) {
+    RouterSettings settings = settings_;
+    settings.bus_velocity = bus_velocity;
+    settings.bus_wait_time = bus_wait_time;
+    profile_router.raptor =
+        make_unique<RaptorRouter>(settings, transport_catalogue_);
+    return profile_router;
+  }
+
+  const double v = bus_velocity * 1000 / 3600;
+  const double w = bus_wait_time * 60;
+  profile_router.weights.reserve(edges_.size());
+  for (const Edge &edge : edges_) {
+    double weight = 0;
+    if (holds_alternative<WaitEdge>(edge)) {
+      weight = w;
+    } else if (const auto *bus_edge = get_if<BusEdge>(&edge)) {
+      weight = bus_edge->distance / v;
+      if (settings_.graph_model == GraphModel::WAIT_FREE) {
+        weight = w + weight;
+      }
+    } else if (const auto *ride_edge = get_if<RideEdge>(&edge)) {
+      weight = ride_edge->distance / v;
+    }
+    profile_router.weights.push_back(weight);
+  }
+  StopGraph::Data data = stop_graph_.GetData();
+  data.weights = profile_router.weights.data();
+  profile_router.stop_graph = StopGraph(data);
+  profile_router.router =
+      make_unique<graph::DijkstraRouter<double, StopGraph>>(
+          profile_router.stop_graph);
+  return profile_router;
+}
+
+/**
+ * Размер меток и время их построения для `RouterEngine::HUB_LABELS` или
+ * `nullopt`, если маршруты ищутся без меток: другим движком или по кэшу
+ * деревьев.
+ */
+optional<graph::HubLabelStats> Router::GetHubLabelStats() const {
+  if (settings_.engine != RouterEngine::HUB_LABELS || !router_) {
     return nullopt;
   }
-  const auto &route = *route_opt;
+  return static_cast<const graph::HubLabelRouter<double, StopGraph> &>(
+             *router_)
+      .GetStats();
+}
+
+void Router::ClearProfileRouters() {
+  profile_routers_.clear();
+  profile_router_by_profile_.clear();
+  profile_cache_stats_.size = 0;
+}
+
+/**
+ * Время и шаги маршрута по рёбрам графа `stop_graph` со скоростью
+ * `bus_velocity` и временем ожидания `bus_wait_time`.
+ *
+ * В модели `GraphModel::WAIT_FREE` время складывается по шагам, в том же
+ * порядке, что и веса рёбер двухвершинной модели, чтобы не отличаться от
+ * неё даже погрешностью округления.
+ */
+RouteResult Router::MakeRouteResult(const StopGraph &stop_graph,
+                                    const vector<graph::EdgeId> &edges,
+                                    double bus_velocity,
+                                    double bus_wait_time) const {
   RouteResult result;
-  for (auto edge_id : route.edges) {
+  result.steps = MakeRouteSteps(stop_graph, edges, bus_velocity,
+                                bus_wait_time);
+  if (settings_.graph_model == GraphModel::WAIT_FREE) {
+    for (const auto &step : result.steps) {
+      result.time += visit([](const auto &action) { return action.time; },
+                           step);
+    }
+    return result;
+  }
+  for (auto edge_id : edges) {
+    result.time += stop_graph.GetEdge(edge_id).weight;
+  }
+  return result;
+}
+
+/**
+ * Шаги маршрута по рёбрам графа остановок, время шагов берётся из весов
+ * `stop_graph`. Ребро автобуса модели `GraphModel::WAIT_FREE` даёт два шага:
+ * ожидание `bus_wait_time` и поездку со скоростью `bus_velocity`.
+ */
+vector<RouteAction> Router::MakeRouteSteps(const StopGraph &stop_graph,
+                                           const vector<graph::EdgeId> &edges,
+                                           double bus_velocity,
+                                           double bus_wait_time) const {
+  const bool is_wait_free = settings_.graph_model == GraphModel::WAIT_FREE;
+  vector<RouteAction> steps;
+  steps.reserve(is_wait_free ? 2 * edges.size() : edges.size());
+  for (auto edge_id : edges) {
     const auto &edge = edges_[edge_id];
-    const auto &graph_edge = stop_graph_.GetEdge(edge_id);
+    const auto &graph_edge = stop_graph.GetEdge(edge_id);
     if (holds_alternative<WaitEdge>(edge)) {
       const auto &wait_edge = get<WaitEdge>(edge);
-      result.steps.push_back(
+      steps.push_back(
           WaitAction{string_view{wait_edge.stop->name}, graph_edge.weight});
-    } else {
+    } else if (holds_alternative<BusEdge>(edge)) {
       const auto &bus_edge = get<BusEdge>(edge);
-      result.steps.push_back(BusAction{string_view{bus_edge.bus->name},
-                                       bus_edge.span_len, graph_edge.weight});
+      if (!is_wait_free) {
+        steps.push_back(BusAction{string_view{bus_edge.bus->name},
+                                  bus_edge.span_len, graph_edge.weight});
+        continue;
+      }
+      // те же слагаемые, из которых сложен вес ребра
+      steps.push_back(WaitAction{
+          string_view{stop_by_vertex_[graph_edge.from]->name},
+          bus_wait_time * 60});
+      const double v = bus_velocity * 1000 / 3600;
+      steps.push_back(BusAction{string_view{bus_edge.bus->name},
+                                bus_edge.span_len, bus_edge.distance / v});
+    } else if (holds_alternative<BoardEdge>(edge)) {
+      // перегоны до высадки складываются в одну поездку
+      steps.push_back(
+          BusAction{string_view{get<BoardEdge>(edge).bus->name}, 0, 0});
+    } else if (holds_alternative<RideEdge>(edge)) {
+      auto &ride = get<BusAction>(steps.back());
+      ++ride.stop_count;
+      ride.time += graph_edge.weight;
+    }
+  }
+  return steps;
+}
+
+optional<RouteResult> Router::CalcRoute(string_view from,
+                                        string_view to) const {
+  if (raptor_) {
+    return raptor_->CalcRoute(from, to);
+  }
+  auto v_from = FindStopVertex(from);
+  auto v_to = FindStopVertex(to);
+  if (!v_from || !v_to || !IsReachable(*v_from, *v_to)) {
+    return nullopt;
+  }
+  auto route_opt = BuildGraphRoute(*v_from, *v_to);
+  if (!route_opt) {
+    return nullopt;
+  }
+  return MakeRouteResult(stop_graph_, route_opt->edges,
+                         settings_.bus_velocity, settings_.bus_wait_time);
+}
+
+/**
+ * Маршрут со скоростью и временем ожидания из `profile`. Если они совпадают
+ * с настройками, ищется обычным `CalcRoute`.
+ */
+optional<RouteResult> Router::CalcRoute(string_view from, string_view to,
+                                        const RouteProfile &profile) const {
+  const double bus_velocity =
+      profile.bus_velocity.value_or(settings_.bus_velocity);
+  const double bus_wait_time =
+      profile.bus_wait_time.value_or(settings_.bus_wait_time);
+  if (bus_velocity == settings_.bus_velocity &&
+      bus_wait_time == settings_.bus_wait_time) {
+    return CalcRoute(from, to);
+  }
+  const ProfileRouter &profile_router =
+      GetProfileRouter(bus_velocity, bus_wait_time);
+  if (profile_router.raptor) {
+    return profile_router.raptor->CalcRoute(from, to);
+  }
+  auto v_from = FindStopVertex(from);
+  auto v_to = FindStopVertex(to);
+  // у графа профиля те же рёбра, что у `stop_graph_`
+  if (!v_from || !v_to || !IsReachable(*v_from, *v_to)) {
+    return nullopt;
+  }
+  auto route_opt = profile_router.router->BuildRoute(*v_from, *v_to);
+  if (!route_opt) {
+    return nullopt;
+  }
+  return MakeRouteResult(profile_router.stop_graph, route_opt->edges,
+                         bus_velocity, bus_wait_time);
+}
+
+/**
+ * Маршрут по расписанию рейсов с отправлением из `from` не раньше
+ * `departure_time` минут от начала суток.
+ */
+optional<RouteResult> Router::CalcTimetableRoute(string_view from,
+                                                 string_view to,
+                                                 double departure_time) const {
+  return timetable_router_->CalcRoute(from, to, departure_time);
+}
+
+/**
+ * Остановки, до которых можно доехать из `from` не дольше `max_time`
+ * секунд. Вместо запроса маршрута до каждой остановки делается один поиск
+ * Дейкстры из `from`, который не идёт дальше `max_time`, так что
+ * обрабатываются только вершины внутри изохроны. `std::nullopt` -
+ * остановки `from` нет.
+ *
+ * У `RouterEngine::RAPTOR` графа остановок нет, и он ищет маршруты из
+ * `from` до всех остановок сразу, см. `RaptorRouter::CalcRouteMatrix`.
+ *
+ * Кидает `invalid_argument`, если `max_time` отрицательно.
+ */
+optional<Isochrone> Router::CalcIsochrone(string_view from,
+                                          double max_time) const {
+  if (!(max_time >= 0)) {
+    throw invalid_argument("max time should be non-negative"s);
+  }
+  const auto stops = transport_catalogue_.GetStops();
+  Isochrone result;
+  if (raptor_) {
+    if (!transport_catalogue_.GetStopInfo(from)) {
+      return nullopt;
+    }
+    vector<string_view> to;
+    to.reserve(stops.size());
+    for (const Stop *stop : stops) {
+      to.push_back(stop->name);
+    }
+    const auto matrix = raptor_->CalcRouteMatrix({from}, to, false);
+    for (size_t i = 0; i < to.size(); ++i) {
+      if (matrix.times[i] && *matrix.times[i] <= max_time) {
+        result.stops.push_back({to[i], *matrix.times[i]});
+      }
+    }
+  } else {
+    auto v_from = FindStopVertex(from);
+    if (!v_from) {
+      return nullopt;
+    }
+    const graph::ShortestPathTree<double, StopGraph> tree{stop_graph_,
+                                                          *v_from, max_time};
+    for (const Stop *stop : stops) {
+      // время до вершины ожидания - время прибытия на остановку
+      if (auto time = tree.GetWeight(vertex_by_stop_name_.at(stop->name))) {
+        result.stops.push_back({stop->name, *time});
+      }
+    }
+  }
+  sort(result.stops.begin(), result.stops.end(),
+       [](const ReachableStop &lhs, const ReachableStop &rhs) {
+         return pair{lhs.time, lhs.stop_name} < pair{rhs.time, rhs.stop_name};
+       });
+  return result;
+}
+
+/**
+ * Маршруты из каждой остановки `from` в каждую остановку `to`. Вместо
+ * `from.size() * to.size()` запросов к движку делается один поиск на каждую
+ * начальную остановку: строится дерево кратчайших путей, из которого
+ * читаются маршруты до всех конечных остановок. Если включён кэш деревьев,
+ * деревья берутся из него.
+ *
+ * Шаги маршрутов собираются, только если `with_steps`, иначе считается одно
+ * время. Для неизвестных остановок маршрута нет. Если ни одна конечная
+ * остановка недостижима из начальной, дерево для неё не строится.
+ */
+RouteMatrix Router::CalcRouteMatrix(const vector<string_view> &from,
+                                    const vector<string_view> &to,
+                                    bool with_steps) const {
+  if (raptor_) {
+    return raptor_->CalcRouteMatrix(from, to, with_steps);
+  }
+  RouteMatrix result;
+  result.from_count = from.size();
+  result.to_count = to.size();
+  result.times.resize(from.size() * to.size());
+  if (with_steps) {
+    result.steps.resize(from.size() * to.size());
+  }
+
+  vector<optional<graph::VertexId>> to_vertices;
+  to_vertices.reserve(to.size());
+  for (string_view stop : to) {
+    to_vertices.push_back(FindStopVertex(stop));
+  }
+
+  for (size_t i = 0; i < from.size(); ++i) {
+    auto v_from = FindStopVertex(from[i]);
+    if (!v_from ||
+        none_of(to_vertices.begin(), to_vertices.end(),
+                [&](const optional<graph::VertexId> &v_to) {
+                  return v_to && IsReachable(*v_from, *v_to);
+                })) {
+      continue;
+    }
+    optional<graph::ShortestPathTree<double, StopGraph>> local_tree;
+    const auto &tree = settings_.tree_cache_size > 0
+                           ? GetShortestPathTree(*v_from)
+                           : local_tree.emplace(stop_graph_, *v_from);
+    for (size_t j = 0; j < to.size(); ++j) {
+      if (!to_vertices[j]) {
+        continue;
+      }
+      const size_t index = i * to.size() + j;
+      if (!with_steps) {
+        result.times[index] = tree.GetWeight(*to_vertices[j]);
+        continue;
+      }
+      if (auto route = tree.BuildRoute(*to_vertices[j])) {
+        result.times[index] = route->weight;
+        result.steps[index] =
+            MakeRouteSteps(stop_graph_, route->edges, settings_.bus_velocity,
+                           settings_.bus_wait_time);
+      }
     }
-    result.time += graph_edge.weight;
   }
 
   return result;
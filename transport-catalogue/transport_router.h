@@ -1,14 +1,23 @@
 #pragma once
 
 #include <cstddef>
+#include <limits>
+#include <list>
+#include <map>
 #include <memory>
 #include <optional>
+#include <string>
 #include <string_view>
 #include <unordered_map>
+#include <utility>
 #include <variant>
 #include <vector>
 
+#include "astar_router.h"
+#include "dijkstra_router.h"
 #include "graph.h"
+#include "hub_label_router.h"
+#include "reachability_index.h"
 #include "router.h"
 
 namespace transport_catalogue {
@@ -22,9 +31,103 @@ class TransportCatalogue;
 
 namespace transport_catalogue::router {
 
+class ConnectionScanRouter;
+class MappedFile;
+class RaptorRouter;
+
+/**
+ * Алгоритм, которым ищутся кратчайшие маршруты в графе остановок.
+ */
+enum RouterEngine {
+  // все маршруты считаются заранее алгоритмом Флойда-Уоршелла: O(V^3) на
+  // старте, O(V^2) памяти, быстрые ответы
+  FLOYD_WARSHALL,
+  // алгоритм Дейкстры на каждый запрос: быстрый старт, O(V + E) памяти
+  DIJKSTRA,
+  // два поиска Дейкстры навстречу друг другу: тоже без подготовки, но
+  // обрабатывается примерно вдвое меньше вершин
+  BIDIRECTIONAL_DIJKSTRA,
+  // A* с оценкой оставшегося времени по расстоянию по прямой до цели
+  A_STAR,
+  // A* с оценками по заранее посчитанным расстояниям до ориентиров
+  ALT,
+  // иерархии сжатия: подготовка почти линейная на разреженных графах, запрос
+  // обходит лишь небольшую часть графа
+  CONTRACTION_HIERARCHY,
+  // метки-хабы: самая долгая подготовка и больше всего памяти, зато запрос -
+  // это слияние двух коротких отсортированных массивов
+  HUB_LABELS,
+  // поиск раундами прямо по спискам остановок автобусов (RAPTOR): граф
+  // остановок не строится, память линейна по длине маршрутов
+  RAPTOR,
+};
+
+/**
+ * Как автобусы представлены в графе остановок.
+ */
+enum GraphModel {
+  // ребро из каждой остановки автобуса в каждую следующую: O(n^2) рёбер на
+  // маршрут из n остановок, зато путь короче
+  ALL_PAIRS,
+  // цепочка вершин "в автобусе" вдоль маршрута с рёбрами посадки и высадки:
+  // O(n) вершин и рёбер на маршрут
+  RIDE_CHAIN,
+  // рёбра как в `ALL_PAIRS`, но у остановки одна вершина, а время ожидания
+  // входит в вес каждого ребра автобуса: вдвое меньше вершин при тех же
+  // маршрутах. Ожидание всё равно выдаётся отдельным шагом маршрута
+  WAIT_FREE,
+};
+
 struct RouterSettings {
   double bus_velocity = 0;
   double bus_wait_time = 0;
+  RouterEngine engine = RouterEngine::FLOYD_WARSHALL;
+  GraphModel graph_model = GraphModel::ALL_PAIRS;
+  // для `GraphModel::ALL_PAIRS` и `GraphModel::WAIT_FREE`: оставлять между
+  // парой вершин только самое быстрое из параллельных рёбер разных
+  // автобусов, а длины пути считать по префиксным суммам перегонов
+  bool prune_bus_edges = false;
+  // для `RouterEngine::FLOYD_WARSHALL` и `GraphModel::ALL_PAIRS`: считать
+  // таблицу маршрутов только между пересадочными остановками, а остальные
+  // присоединять к ним при запросе, см. `Router::BuildCoreGraph`
+  bool reduce_to_transfer_stops = false;
+  // нумеровать вершины остановок вдоль кривой Гильберта по координатам
+  // остановок, а не в порядке справочника: у близких остановок близкие
+  // номера, и поиск реже прыгает по памяти. Маршруты не меняются
+  bool reorder_vertices = false;
+  // строить индекс достижимости, чтобы маршрут между несвязанными сетями
+  // отвечался без поиска. Индекс занимает до C^2 бит, где C - число
+  // компонент сильной связности графа, и пересчитывается при каждой
+  // загрузке и `Router::Update`, а в связной сети ничего не отсекает
+  bool use_reachability_index = false;
+  // сколько ориентиров выбирать для `RouterEngine::ALT`
+  size_t landmark_count = 8;
+  // сколько потоков строят рёбра автобусов графа остановок и считают таблицу
+  // `RouterEngine::FLOYD_WARSHALL`, 0 - по числу ядер
+  size_t router_threads = 1;
+  // сколько деревьев кратчайших путей хранить в кэше, 0 - не кэшировать.
+  // С кэшем маршруты ищутся по деревьям, а движок `engine` не строится.
+  // Для `RouterEngine::RAPTOR` кэш не используется
+  size_t tree_cache_size = 0;
+  // сколько графов с весами под другой `RouteProfile` хранить в кэше.
+  // Последний использованный хранится всегда, даже при 0
+  size_t profile_cache_size = 4;
+  // файл с графом остановок и таблицей маршрутов, см. `Router::SaveToFile`.
+  // Пустая строка - не сохранять и не загружать. Для `RouterEngine::RAPTOR`
+  // не используется
+  std::string cache_file;
+  // сколько ответов на запросы маршрута хранит обработчик запросов, чтобы
+  // повторные запросы не искались и не печатались заново, 0 - не кэшировать
+  size_t route_cache_size = 0;
+};
+
+/**
+ * Настройки, которые можно переопределить в отдельном запросе маршрута.
+ * Незаданные берутся из `RouterSettings`.
+ */
+struct RouteProfile {
+  std::optional<double> bus_velocity;
+  std::optional<double> bus_wait_time;
 };
 
 struct WaitAction {
@@ -44,35 +147,250 @@ struct WaitEdge {
   const Stop *stop;
 };
 
+// рёбра автобусов хранят пройденное расстояние в метрах, чтобы вес ребра
+// можно было пересчитать под другую скорость, см. `RouteProfile`
 struct BusEdge {
   const Bus *bus;
   size_t span_len;
+  double distance;
 };
 
-using Edge = std::variant<WaitEdge, BusEdge>;
+// рёбра модели `GraphModel::RIDE_CHAIN`: посадка в автобус, перегон до
+// следующей остановки и высадка
+struct BoardEdge {
+  const Bus *bus;
+};
+
+struct RideEdge {
+  double distance;
+};
+
+struct AlightEdge {};
+
+using Edge = std::variant<WaitEdge, BusEdge, BoardEdge, RideEdge, AlightEdge>;
 
 struct RouteResult {
   double time = 0;
   std::vector<RouteAction> steps;
 };
 
+/**
+ * Матрица маршрутов между двумя списками остановок.
+ */
+struct RouteMatrix {
+  size_t from_count = 0;
+  size_t to_count = 0;
+  // время в пути из `i`-й начальной остановки в `j`-ю конечную лежит в
+  // `times[i * to_count + j]`, `std::nullopt` - маршрута нет
+  std::vector<std::optional<double>> times;
+  // шаги маршрутов по тем же индексам; пустой, если шаги не запрашивались
+  std::vector<std::vector<RouteAction>> steps;
+};
+
+/**
+ * Остановка, до которой можно доехать, и время в пути до неё.
+ */
+struct ReachableStop {
+  std::string_view stop_name;
+  double time;
+};
+
+/**
+ * Все остановки, до которых можно доехать из начальной не дольше заданного
+ * времени, включая саму начальную.
+ */
+struct Isochrone {
+  // по возрастанию времени, при равном времени - по названию
+  std::vector<ReachableStop> stops;
+};
+
+/**
+ * Статистика кэша: деревьев кратчайших путей роутера или ответов на запросы
+ * маршрута обработчика запросов.
+ */
+struct CacheStats {
+  // сколько записей сейчас в кэше
+  size_t size = 0;
+  size_t hits = 0;
+  size_t misses = 0;
+  size_t evictions = 0;
+
+  double GetHitRate() const {
+    return hits + misses == 0 ? 0.0
+                              : static_cast<double>(hits) / (hits + misses);
+  }
+};
+
+/**
+ * Поиск маршрутов между остановками.
+ *
+ * Если в настройках задан `tree_cache_size`, маршруты ищутся не движком, а по
+ * деревьям кратчайших путей из начальной остановки. Деревья для последних
+ * `tree_cache_size` начальных остановок хранятся в кэше, и запрос из такой
+ * остановки отвечается без поиска. Это выгодно, когда большинство запросов
+ * идёт из нескольких популярных остановок, а движок ищет маршрут на каждый
+ * запрос.
+ *
+ * Если у автобусов есть рейсы по расписанию, `CalcTimetableRoute` ищет по
+ * ним маршрут с самым ранним прибытием, независимо от `engine`.
+ *
+ * После изменения справочника роутер нужно обновить через `Update`.
+ *
+ * Если задан `cache_file`, граф остановок и таблица маршрутов загружаются
+ * из этого файла, а если файла нет или он построен по другому справочнику
+ * или настройкам - строятся заново и записываются в него. Если записать
+ * файл не удалось, роутер работает без него.
+ *
+ * Запрос с `RouteProfile`, отличным от настроек, ищет маршрут алгоритмом
+ * Дейкстры по тому же графу остановок с пересчитанными весами рёбер. Веса
+ * считаются за O(E) и хранятся в кэше для последних `profile_cache_size`
+ * профилей, топология графа и индексы остановок общие для всех профилей.
+ *
+ * С `reduce_to_transfer_stops` таблица `RouterEngine::FLOYD_WARSHALL`
+ * считается только между пересадочными остановками. Обычно у большинства
+ * остановок один автобус, а время подготовки кубически зависит от числа
+ * вершин, так что она ускоряется на порядки. Остальные остановки
+ * присоединяются к таблице при каждом запросе.
+ *
+ * С `use_reachability_index` маршрут между остановками, между которыми в
+ * графе остановок нет пути, например из разных городов, отвечается за O(1)
+ * по индексу достижимости, без поиска.
+ *
+ * `CalcRoute` меняет буферы движка и кэш, поэтому его нельзя вызывать
+ * одновременно из нескольких потоков.
+ */
 class Router {
  public:
   Router(const RouterSettings &settings,
          const TransportCatalogue &transport_catalogue);
+  ~Router();
+
   std::optional<RouteResult> CalcRoute(std::string_view from,
                                        std::string_view to) const;
+  std::optional<RouteResult> CalcRoute(std::string_view from,
+                                       std::string_view to,
+                                       const RouteProfile &profile) const;
+  RouteMatrix CalcRouteMatrix(const std::vector<std::string_view> &from,
+                              const std::vector<std::string_view> &to,
+                              bool with_steps) const;
+  std::optional<RouteResult> CalcTimetableRoute(std::string_view from,
+                                                std::string_view to,
+                                                double departure_time) const;
+  std::optional<Isochrone> CalcIsochrone(std::string_view from,
+                                         double max_time) const;
+
+  void Update();
+  void SaveToFile(const std::string &path) const;
+  bool IsLoadedFromFile() const { return mapped_file_ != nullptr; }
+
+  const CacheStats &GetTreeCacheStats() const { return tree_cache_stats_; }
+  const CacheStats &GetProfileCacheStats() const {
+    return profile_cache_stats_;
+  }
+  std::optional<graph::HubLabelStats> GetHubLabelStats() const;
+  size_t GetStopGraphEdgeCount() const { return stop_graph_.GetEdgeCount(); }
+  bool HasReachabilityIndex() const { return reachability_.has_value(); }
 
  private:
   RouterSettings settings_;
   const TransportCatalogue &transport_catalogue_;
-  graph::DirectedWeightedGraph<double> stop_graph_;
-  std::unique_ptr<graph::Router<double>> router_;
+  // граф собирается в `graph_builder_`, а ищут маршруты по его неизменяемой
+  // копии в формате CSR, `edges_` переставлены в её порядке рёбер
+  using StopGraph = graph::CsrGraph<double>;
+  graph::DirectedWeightedGraph<double> graph_builder_;
+  // файл, в который смотрят `stop_graph_` и таблица `router_`, если они
+  // загружены из файла
+  std::unique_ptr<MappedFile> mapped_file_;
+  StopGraph stop_graph_;
+  // индекс достижимости, если он включён в настройках
+  std::optional<graph::ReachabilityIndex<StopGraph>> reachability_;
+  // подграф `stop_graph_` на вершинах пересадочных остановок, по которому
+  // считается таблица с `settings_.reduce_to_transfer_stops`. Ребру
+  // `core_graph_` соответствует ребро `core_edge_ids_` графа остановок,
+  // вершине графа остановок - вершина `core_vertices_` или `NO_CORE_VERTEX`
+  static constexpr graph::VertexId NO_CORE_VERTEX =
+      std::numeric_limits<graph::VertexId>::max();
+  StopGraph core_graph_;
+  std::vector<graph::EdgeId> core_edge_ids_;
+  std::vector<graph::VertexId> core_vertices_;
+  std::unique_ptr<graph::AbstractRouter<double>> router_;
+  // вместо графа остановок и `router_` для `RouterEngine::RAPTOR`
+  std::unique_ptr<RaptorRouter> raptor_;
+  // поиск по расписанию
+  std::unique_ptr<ConnectionScanRouter> timetable_router_;
 
   std::vector<Edge> edges_;
+  // перевод между остановками и номерами вершин в обе стороны: вершины
+  // остановок нумеруются в порядке справочника или, с
+  // `settings_.reorder_vertices`, вдоль кривой Гильберта
   std::unordered_map<std::string_view, graph::VertexId> vertex_by_stop_name_;
+  std::vector<const Stop *> stop_by_vertex_;
+
+  // кэш деревьев кратчайших путей, недавно использованные - в начале списка
+  using TreeList = std::list<graph::ShortestPathTree<double, StopGraph>>;
+  mutable TreeList trees_;
+  mutable std::unordered_map<graph::VertexId, TreeList::iterator>
+      tree_by_source_;
+  mutable CacheStats tree_cache_stats_;
+
+  // граф остановок с весами под другие скорость и время ожидания: массивы
+  // топологии общие со `stop_graph_`, свои только веса
+  struct ProfileRouter {
+    // скорость и время ожидания
+    std::pair<double, double> profile;
+    std::vector<double> weights;
+    StopGraph stop_graph;
+    std::unique_ptr<graph::DijkstraRouter<double, StopGraph>> router;
+    // вместо графа для `RouterEngine::RAPTOR`
+    std::unique_ptr<RaptorRouter> raptor;
+  };
+  // кэш графов профилей, недавно использованные - в начале списка
+  using ProfileList = std::list<ProfileRouter>;
+  mutable ProfileList profile_routers_;
+  mutable std::map<std::pair<double, double>, ProfileList::iterator>
+      profile_router_by_profile_;
+  mutable CacheStats profile_cache_stats_;
 
   void BuildStopGraph();
+  // рёбра графа остановок вместе с их описанием в `edges_`
+  using EdgeBatch = std::vector<std::pair<graph::Edge<double>, Edge>>;
+  EdgeBatch MakeAllPairsBusEdges(
+      const Bus *bus,
+      const std::unordered_map<const Stop *, graph::VertexId> &id_by_stop)
+      const;
+  EdgeBatch MakeRideChainBusEdges(
+      const Bus *bus,
+      const std::unordered_map<const Stop *, graph::VertexId> &id_by_stop,
+      graph::VertexId first_vertex) const;
+  void AddBusEdges(std::vector<EdgeBatch> batches);
+  graph::EdgeId AddGraphEdge(const graph::Edge<double> &graph_edge, Edge edge);
+  void BuildGraphRouter();
+  bool UsesTreeCache() const;
+  bool UsesFullTable() const;
+  bool UsesTransferStops() const;
+  void BuildCoreGraph();
+  void FreezeStopGraph();
+  bool LoadFromFile(const std::string &path);
+  graph::AStarRouter<double, StopGraph>::Potential MakeGeoPotential() const;
+  std::optional<graph::AbstractRouter<double>::RouteInfo> BuildGraphRoute(
+      graph::VertexId from, graph::VertexId to) const;
+  std::optional<graph::AbstractRouter<double>::RouteInfo> BuildCoreRoute(
+      graph::VertexId from, graph::VertexId to) const;
+  const graph::ShortestPathTree<double, StopGraph> &GetShortestPathTree(
+      graph::VertexId source) const;
+  const ProfileRouter &GetProfileRouter(double bus_velocity,
+                                        double bus_wait_time) const;
+  void ClearProfileRouters();
+  std::optional<graph::VertexId> FindStopVertex(std::string_view stop) const;
+  void BuildReachabilityIndex();
+  bool IsReachable(graph::VertexId from, graph::VertexId to) const;
+  size_t GetVerticesPerStop() const;
+  RouteResult MakeRouteResult(const StopGraph &stop_graph,
+                              const std::vector<graph::EdgeId> &edges,
+                              double bus_velocity, double bus_wait_time) const;
+  std::vector<RouteAction> MakeRouteSteps(
+      const StopGraph &stop_graph, const std::vector<graph::EdgeId> &edges,
+      double bus_velocity, double bus_wait_time) const;
 };
 
 }  // namespace transport_catalogue::router